@@ -1,4 +1,6 @@
 #pragma once
+#include <LaunchOptions.h>
+
 #include <memory>
 
 class Graphics;
@@ -12,7 +14,11 @@ private:
 
 	int m_GraphicsStatus = 0;
 
+	LaunchOptions m_Options{};
+
 public:
+	Engine() = default;
+	Engine(const LaunchOptions& options) : m_Options(options) {}
 
 	int Start();
 	int Tick();
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+
+// command line switches, with none given the app runs as the normal window
+struct LaunchOptions
+{
+	// hidden window, the UI is still drawn and captured offscreen so recordings work without a display
+	bool m_Headless = false;
+
+	// OSMesa software context rather than the platform one, for machines without a GPU driver
+	bool m_SoftwareContext = false;
+
+	// starts recording straight away and closes once the file has saved
+	std::string m_RecordName = "";
+	int m_RecordFPS = 30;
+	int m_RecordTime = 10;
+	int m_Encoder = -1;
+
+	// streams the recording to tcp://<port>, pipe://<name> or unix://<path> instead of a file
+	std::string m_LiveTarget = "";
+
+	// fixed time step recording, one frame per tick rather than following the clock
+	bool m_Offline = false;
+
+	// closes after this many ticks, 0 runs until the window is closed
+	int m_MaxFrames = 0;
+
+	// converts a .glsc recording with the chosen encoder, y4m if none is given, and exits without opening a window
+	std::string m_DecodeInput = "";
+	std::string m_DecodeOutput = "";
+
+	bool Parse(const int& argc, char** argv);
+
+	static void PrintUsage();
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+// maps rendered frames onto output frame slots, each rendered frame is read back once and covers however many slots passed while it was drawn
+class CaptureScheduler
+{
+	double m_StartTime = 0.0;
+	double m_SlotDuration = 1.0 / 30.0;
+
+	unsigned long long m_NextSlot = 0;
+
+	unsigned long long m_FramesScheduled = 0;
+	unsigned int m_MaxSlotsPerFrame = 0;
+
+public:
+	void Reset(const double& startTime, const int& fps);
+
+	// output slots that fell due by 'time', 0 means the frame isn't needed, more than 1 means it repeats
+	unsigned int Advance(const double& time);
+
+	inline unsigned long long GetSlotCount() const { return m_NextSlot; }
+	inline unsigned long long GetFramesScheduled() const { return m_FramesScheduled; }
+	inline unsigned long long GetRepeatedSlots() const { return m_NextSlot - m_FramesScheduled; }
+	inline unsigned int GetMaxSlotsPerFrame() const { return m_MaxSlotsPerFrame; }
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// converts bottom up BGRA frames from glReadPixels to 4:2:0 YUV in one pass, flipping the rows as it goes
+class ColourConverter
+{
+public:
+	enum class Format { NV12, I420 };
+	enum class Matrix { BT601, BT709 };
+	enum class Path { Scalar, SSE2, AVX2 };
+
+private:
+	int m_Width = 0;
+	int m_Height = 0;
+
+	Format m_Format = Format::NV12;
+	Matrix m_Matrix = Matrix::BT601;
+	Path m_Path = Path::Scalar;
+
+	// Q15 fixed point coefficients for limited range output, order is B, G, R
+	int16_t m_YCoeffs[3]{};
+	int16_t m_UCoeffs[3]{};
+	int16_t m_VCoeffs[3]{};
+
+	struct RowPair
+	{
+		const uint8_t* m_Src0;
+		const uint8_t* m_Src1;
+		uint8_t* m_Y0;
+		uint8_t* m_Y1;
+		uint8_t* m_U;
+		uint8_t* m_V;
+	};
+
+	RowPair GetRowPair(const void* bgra, uint8_t* dst, const int& pair, const bool& flip) const;
+
+	void ConvertScalar(const RowPair& rows, const int& startX) const;
+	int ConvertSSE2(const RowPair& rows) const;
+	int ConvertAVX2(const RowPair& rows) const;
+
+public:
+	ColourConverter() = default;
+	ColourConverter(const int& width, const int& height, const Format& format, const Matrix& matrix);
+
+	void Convert(const void* bgra, uint8_t* dst, const bool& flip) const;
+
+	// converts output rows [2 * firstPair, 2 * endPair), lets callers split a frame across threads
+	void ConvertRows(const void* bgra, uint8_t* dst, const bool& flip, const int& firstPair, const int& endPair) const;
+
+	bool SetPath(const Path& path);
+
+	inline Path GetPath() const { return m_Path; }
+	inline Format GetFormat() const { return m_Format; }
+	inline Matrix GetMatrix() const { return m_Matrix; }
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+	inline int GetRowPairCount() const { return (m_Height + 1) / 2; }
+
+	size_t GetOutputSize() const;
+
+	static Path GetBestPath();
+	static bool IsPathSupported(const Path& path);
+	static const char* GetPathName(const Path& path);
+	static const char* GetFormatName(const Format& format);
+	static const char* GetMatrixName(const Matrix& matrix);
+};
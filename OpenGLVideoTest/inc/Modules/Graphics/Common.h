@@ -3,7 +3,19 @@
 #include <glew/glew.h>
 #include <iostream>
 
-#define ASSERT(x) if (!(x)) __debugbreak();
+// stops in the debugger like __debugbreak, SIGTRAP can be continued past where a trap can't
+#if defined(_MSC_VER)
+#define DEBUG_BREAK() __debugbreak()
+#else
+#include <csignal>
+#ifdef SIGTRAP
+#define DEBUG_BREAK() std::raise(SIGTRAP)
+#else
+#define DEBUG_BREAK() __builtin_trap()
+#endif
+#endif
+
+#define ASSERT(x) if (!(x)) DEBUG_BREAK();
 #define GL_CALL(x) ClearGLErrors();\
 	x;\
 	ASSERT(LogGLCall(#x, __FILE__, __LINE__))
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// raw deflate (RFC 1951) with LZ77 over a 32KB window and a dynamic Huffman table per block
+// each call compresses its data on its own and ends on a byte boundary, so chunks compressed on separate threads can be joined in order
+class Deflate
+{
+	// most recent position for each hash of three bytes, and the one before it with the same hash
+	std::vector<int32_t> m_Head{};
+	std::vector<int32_t> m_Prev{};
+
+	// the current block, a literal byte or match length in the low 16 bits and the match distance in the high 16
+	std::vector<uint32_t> m_Symbols{};
+
+	int m_MaxChain = 16;
+
+public:
+	static const size_t WindowSize = 32768;
+
+	// higher levels search more of the window for a longer match, 1 to 9
+	explicit Deflate(const int& level = 6);
+
+	// appends the compressed data to out, the last chunk of a stream closes it, the rest end on a sync flush
+	void Compress(const uint8_t* data, const size_t& size, std::vector<uint8_t>& out, const bool& last);
+
+	static uint32_t Adler32(const uint8_t* data, const size_t& size, uint32_t adler = 1);
+
+	// adler of a followed by b, from the adlers of both and the length of b
+	static uint32_t CombineAdler32(const uint32_t& a, const uint32_t& b, const size_t& sizeB);
+
+	static uint32_t Crc32(const uint8_t* data, const size_t& size, uint32_t crc = 0);
+};
@@ -0,0 +1,95 @@
+#pragma once
+#include <Modules/Graphics/ColourConverter.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+enum class EncoderType
+{
+	MediaFoundation,
+	Y4M,
+	RawI420,
+	MJPEG,
+	Screen,
+	Count
+};
+
+struct EncoderSettings
+{
+	std::string m_FilePath = "";
+	int m_FrameWidth = 640;
+	int m_FrameHeight = 480;
+	int m_FrameRate = 60;
+	int m_BitRate = 80000;
+	int m_KeyFrameInterval = 60;
+	ColourConverter::Matrix m_ColourMatrix = ColourConverter::Matrix::BT709;
+
+	// for encoders with a quality rather than a bit rate, 1 to 100
+	int m_Quality = 85;
+
+	// threads the backend's own encoder may split a single frame across
+	int m_Threads = 1;
+};
+
+struct WriteStats;
+
+struct EncodedPacket
+{
+	std::vector<uint8_t> m_Data{};
+	long long m_Timestamp = 0;
+	long long m_Duration = 0;
+	bool m_KeyFrame = true;
+};
+
+// turns frames into packets with state of its own, so several can run side by side on different threads
+class SegmentEncoder
+{
+public:
+	virtual ~SegmentEncoder() = default;
+
+	// the first frame given to a new encoder is always a keyframe
+	virtual bool Encode(const void* frameData, EncodedPacket& packet) = 0;
+
+	// encoders that can split a single frame use up to this many threads for it
+	virtual void SetThreads(const int& threads) {}
+};
+
+// everything the VideoWriter needs from an encoder, frames arrive as bottom up BGRA straight from the readback
+class EncoderBackend
+{
+public:
+	virtual ~EncoderBackend() = default;
+
+	virtual int Open(const EncoderSettings& settings) = 0;
+
+	// timestamp and duration are in 100ns units
+	virtual bool WriteFrame(const void* frameData, const long long& timestamp, const long long& duration) = 0;
+
+	virtual bool Finalize() = 0;
+	virtual void Close() = 0;
+
+	virtual const char* GetName() const = 0;
+
+	// live output goes to another process as it is made, frames shouldn't be held back waiting to see how long they last
+	virtual bool IsLive() const { return false; }
+
+	// backends that can split encoding from writing let the VideoWriter encode keyframe aligned segments in parallel
+	virtual bool SupportsSegments() const { return false; }
+	virtual std::unique_ptr<SegmentEncoder> CreateSegmentEncoder() const { return nullptr; }
+	virtual bool WritePacket(const EncodedPacket& packet) { return false; }
+
+	// encoded bytes handed to the output so far, backends that can't see their output leave it at 0
+	virtual unsigned long long GetBytesOutput() const { return 0; }
+
+	// backends writing a file behind themselves report how the disk is keeping up, the last recording's stay after Finalize
+	virtual bool GetWriteStats(WriteStats& stats) const { return false; }
+
+	static std::unique_ptr<EncoderBackend> Create(const EncoderType& type);
+
+	static bool IsAvailable(const EncoderType& type);
+	static const char* GetName(const EncoderType& type);
+	static const char* GetFileExtension(const EncoderType& type);
+	static EncoderType GetDefault();
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// LZ4 style byte compressor tuned for GUI frames, long runs and repeats cost a handful of bytes
+class FrameCompressor
+{
+	std::vector<uint32_t> m_HashTable{};
+
+public:
+	FrameCompressor();
+
+	// dst is overwritten, returns the compressed size
+	size_t Compress(const uint8_t* src, const size_t& size, std::vector<uint8_t>& dst);
+
+	static bool Decompress(const uint8_t* src, const size_t& size, uint8_t* dst, const size_t& dstSize);
+
+	// dst ^= src, used to turn a frame into a delta against the one before it and back again
+	static void Xor(uint8_t* dst, const uint8_t* src, const size_t& size);
+	static void Xor(uint8_t* dst, const uint8_t* a, const uint8_t* b, const size_t& size);
+};
@@ -0,0 +1,21 @@
+#pragma once
+#include <Modules/Graphics/ColourConverter.h>
+
+#include <cstdint>
+#include <cstddef>
+
+// 64 bit content hash for whole frames, fast enough to run on every capture so identical frames can be spotted
+class FrameHasher
+{
+	static uint64_t HashScalar(const uint8_t* data, const size_t& size);
+	static uint64_t HashSSE2(const uint8_t* data, const size_t& size);
+	static uint64_t HashAVX2(const uint8_t* data, const size_t& size);
+
+public:
+	// every path gives the same hash, the best one the CPU supports is picked by default
+	static uint64_t Hash(const void* data, const size_t& size);
+	static uint64_t Hash(const void* data, const size_t& size, const ColourConverter::Path& path);
+
+	// folds a value into a running hash, for hashing several small buffers as one
+	static uint64_t Combine(const uint64_t& seed, const uint64_t& value);
+};
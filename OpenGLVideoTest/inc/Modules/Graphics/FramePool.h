@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <memory>
+
+class FramePool;
+
+// move only owner of a single pooled frame, the slab goes back to its pool when the handle is destroyed
+class FrameHandle
+{
+	std::shared_ptr<FramePool> m_Pool = nullptr;
+	void* m_Data = nullptr;
+
+public:
+	FrameHandle() = default;
+	FrameHandle(const std::shared_ptr<FramePool>& pool, void* data) : m_Pool(pool), m_Data(data) {}
+	~FrameHandle() { Reset(); }
+
+	FrameHandle(const FrameHandle&) = delete;
+	FrameHandle& operator=(const FrameHandle&) = delete;
+
+	FrameHandle(FrameHandle&& other) noexcept;
+	FrameHandle& operator=(FrameHandle&& other) noexcept;
+
+	void Reset();
+
+	inline void* GetData() const { return m_Data; }
+	inline explicit operator bool() const { return m_Data != nullptr; }
+};
+
+// recycles fixed size, cache line aligned frame slabs so recording does not hit the heap every frame
+class FramePool : public std::enable_shared_from_this<FramePool>
+{
+	mutable std::mutex m_Mutex;
+
+	std::vector<void*> m_FreeSlabs{};
+
+	size_t m_FrameSize = 0;
+	size_t m_SlabSize = 0;
+
+	size_t m_SlabCount = 0;
+	size_t m_Outstanding = 0;
+	size_t m_HighWater = 0;
+
+	unsigned long long m_Hits = 0;
+	unsigned long long m_Misses = 0;
+
+	static void* AllocateSlab(const size_t& size);
+	static void FreeSlab(void* slab);
+
+public:
+	static const size_t Alignment = 64;
+
+	FramePool(const size_t& frameSize, const size_t& preallocate);
+	~FramePool();
+
+	FramePool(const FramePool&) = delete;
+	FramePool& operator=(const FramePool&) = delete;
+
+	FrameHandle Acquire();
+	void Release(void* slab);
+
+	void Reserve(const size_t& count);
+	void Trim(const size_t& maxSlabs);
+
+	void ResetStats();
+
+	inline size_t GetFrameSize() const { return m_FrameSize; }
+	inline size_t GetSlabSize() const { return m_SlabSize; }
+
+	size_t GetSlabCount() const;
+	size_t GetOutstanding() const;
+	size_t GetHighWater() const;
+	unsigned long long GetHits() const;
+	unsigned long long GetMisses() const;
+};
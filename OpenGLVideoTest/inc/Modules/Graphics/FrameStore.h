@@ -0,0 +1,84 @@
+#pragma once
+#include <Modules/Graphics/FramePool.h>
+#include <Modules/Graphics/FrameCompressor.h>
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+// keeps a buffered recording compressed in memory, frames are delta coded against the one before on a worker thread
+class FrameStore
+{
+	struct StoredFrame
+	{
+		std::vector<uint8_t> m_Data{};
+		bool m_KeyFrame = true;
+
+		// duplicate of the frame before, nothing is stored
+		bool m_Repeat = false;
+	};
+
+	size_t m_FrameSize = 0;
+	size_t m_KeyFrameInterval = 60;
+
+	std::vector<StoredFrame> m_Frames{};
+
+	// raw frames waiting for the worker, each still holds its pool slab
+	std::thread m_Worker;
+	mutable std::mutex m_Mutex;
+	std::condition_variable m_Condition;
+	std::deque<FrameHandle> m_Pending{};
+	bool m_Finishing = false;
+
+	std::atomic<unsigned long long> m_RawBytes = 0;
+	std::atomic<unsigned long long> m_CompressedBytes = 0;
+	std::atomic<size_t> m_FramesStored = 0;
+
+	void CompressFrames();
+
+public:
+	// replays the store in order, a reader can start at any keyframe
+	class Reader
+	{
+		const FrameStore& m_Store;
+
+		std::vector<uint8_t> m_Frame{};
+		std::vector<uint8_t> m_Delta{};
+		size_t m_Next = 0;
+
+		bool Decode(const size_t& index);
+
+	public:
+		Reader(const FrameStore& store);
+
+		// returns nullptr if the frame is missing or corrupt, valid until the next call
+		const void* Read(const size_t& index);
+
+		bool IsRepeat(const size_t& index) const;
+	};
+
+	FrameStore(const size_t& frameSize, const size_t& keyFrameInterval);
+	~FrameStore();
+
+	FrameStore(const FrameStore&) = delete;
+	FrameStore& operator=(const FrameStore&) = delete;
+
+	// an empty handle records a repeat of the last frame
+	void Push(FrameHandle frame);
+
+	// blocks until every pushed frame has been compressed
+	void Finish();
+
+	inline size_t GetFrameSize() const { return m_FrameSize; }
+	inline size_t GetKeyFrameInterval() const { return m_KeyFrameInterval; }
+
+	size_t GetFrameCount() const { return m_FramesStored; }
+	size_t GetPending() const;
+	unsigned long long GetRawBytes() const { return m_RawBytes; }
+	unsigned long long GetCompressedBytes() const { return m_CompressedBytes; }
+	double GetCompressionRatio() const;
+};
@@ -1,11 +1,17 @@
 #pragma once
 #include <Modules/Module.h>
+#include <Modules/Graphics/FramePool.h>
+#include <Modules/Graphics/CaptureScheduler.h>
+#include <LaunchOptions.h>
 
 #include <memory>
 #include <array>
 #include <vector>
 #include <string>
 #include <future>
+#include <deque>
+#include <chrono>
+#include <cstdint>
 
 struct GLFWwindow;
 struct ImVec4;
@@ -13,6 +19,11 @@ struct ImVec2;
 struct ImGuiContext;
 struct FIBITMAP;
 class Renderer;
+class PixelReadback;
+class FrameStore;
+class RenderTarget;
+class VideoWriter;
+class ScreenshotWriter;
 
 class Graphics : public Module
 {
@@ -26,38 +37,176 @@ private:
 
 	bool m_Init = false;
 
+	LaunchOptions m_Options{};
+
+	// set when a recording was asked for on the command line, the app closes once it has saved
+	bool m_AutoRecord = false;
+	bool m_CloseAfterSave = false;
+
 	char m_RenderFileName[32]{};
-	char m_RenderFilePath[128]{};
+	std::string m_RenderFilePath = "";
 	int m_RenderFileFPS = 30;
 	int m_RenderFileTime = 10;
 	int m_RenderFileDelay = 1;
 
+	// encode frames while recording rather than storing them all until the end
+	bool m_StreamEncode = true;
+	int m_StreamQueueDepth = 4;
+
+	// frames the pool keeps past a full queue, the one capture is copying into, the one the encoder has popped and the one it holds back for repeats
+	static constexpr int StreamSpareFrames = 3;
+
+	// frames queued for the encoder stay under this much memory, past it they page out to a spill file in the videos folder
+	int m_StreamMemoryMB = 256;
+	bool m_SpillToDisk = true;
+	int m_SpillFileMB = 2048;
+
+	// 0 = block capture, 1 = drop the oldest queued frame, 2 = drop the new frame, once memory and the spill file are both full
+	int m_StreamQueuePolicy = 0;
+
+	// 0 = file in the videos folder, 1 = loopback tcp port, 2 = named pipe, live output is always streamed and kept close behind capture
+	int m_RenderOutput = 0;
+	int m_LivePort = 9000;
+	char m_LivePipeName[32] = "OpenGLVideoTest";
+	int m_RenderFileMatrix = 1;
+	int m_RenderFileEncoder = 0;
+	int m_RenderFileThreads = 1;
+	int m_RenderFileQuality = 85;
+
+	// buffered recordings keep their frames compressed in memory until the save
+	bool m_CompressFrames = true;
+	const char* m_RenderFileExtension = ".wmv";
+
+	// offline recordings feed ImGui a fixed 1 / fps time step and capture one frame per tick, so they run as fast as frames can be made
+	bool m_OfflineRender = false;
+	bool m_OfflineActive = false;
+	unsigned int m_RecordTicks = 0;
+
 	double m_RecordRefreshTime = 0.0;
+
+	// real time recordings read each drawn frame once and let it cover every output frame that fell due while it was drawn
+	CaptureScheduler m_CaptureScheduler{};
 	float m_RecordDelayTime = 0.0f;
 	float m_RecordTime = 0.0f;
 
 	bool m_Saving = false;
 	bool m_Recording = false;
+	bool m_Streaming = false;
+
+	unsigned int m_FramesCaptured = 0;
+
+	// frames identical to the one before are not copied, the writer stretches the previous frame instead
+	bool m_SkipDuplicates = true;
+	bool m_HasLastFrameHash = false;
+	uint64_t m_LastFrameHash = 0;
+	unsigned int m_DuplicateFrames = 0;
+
+	// readback is skipped altogether while ImGui draws exactly what it drew for the last captured frame
+	bool m_SkipUnchangedDraws = true;
+	bool m_HasCapturedDrawHash = false;
+	uint64_t m_DrawDataHash = 0;
+	uint64_t m_CapturedDrawHash = 0;
+	unsigned int m_SkippedReadbacks = 0;
+
+	// repeats owed after each read still in the readback ring, so they reach the writer in order, kept as when each was captured
+	std::deque<std::vector<std::chrono::steady_clock::time_point>> m_ReadRepeats{};
 
-	//std::string m_PrintFilePathBase = "";
+	// counters shown while recording only update once a second, otherwise the status line alone would change every frame
+	struct RecordingStatus
+	{
+		int m_Second = -1;
+		unsigned int m_FramesEncoded = 0;
+		unsigned int m_FramesCaptured = 0;
+		unsigned int m_DuplicateFrames = 0;
+		unsigned int m_SkippedReadbacks = 0;
+		unsigned int m_FramesSpilled = 0;
+		unsigned int m_SpillQueued = 0;
+		double m_CompressionRatio = 0.0;
+		double m_LatencyMs = 0.0;
 
-	char m_PrintFilePathBase[256]{0};
-	char m_RenderFilePathBase[256]{0};
+		// encoder telemetry, also refreshed a couple of times a second while saving
+		unsigned int m_FramesRemaining = 0;
+		unsigned long long m_BytesOutput = 0;
+		double m_EncodeFps = 0.0;
+		double m_EncodeMs = 0.0;
+		double m_SecondsRemaining = -1.0;
+		double m_SaveRefreshTime = 0.0;
+	};
 
-	unsigned int m_PixelBuffers[2]{};
-	int m_ReadIndex = 0;
-	int m_WriteIndex = 1;
+	RecordingStatus m_RecordingStatus{};
+
+	// built from the working directory, which can be any length
+	std::string m_PrintFilePathBase = "";
+	std::string m_RenderFilePathBase = "";
+	std::string m_ScreenshotFilePathBase = "";
+
+	std::shared_ptr<PixelReadback> m_Readback = nullptr;
+	int m_ReadbackDepth = 3;
+
+	// frames can be scaled down on the GPU before readback, 0 = full, 1 = half, 2 = quarter, 3 = custom size
+	int m_CaptureScale = 0;
+	int m_CaptureCustomSize[2] = { 800, 450 };
+	int m_CaptureWidth = 1600;
+	int m_CaptureHeight = 900;
+
+	// only part of the framebuffer can be captured, 0 = all of it, 1 = a named ImGui window, 2 = a fixed rect (x, y down from the top, width, height)
+	// regions are aligned to 16 pixels for the encoders, and keep the size they start a recording with, a followed window only moves it after that
+	int m_CaptureRegion = 0;
+	char m_CaptureWindowName[64] = "ImGui In Action!";
+	int m_CaptureRect[4] = { 0, 0, 800, 448 };
+	int m_RegionSize[2] = { 0, 0 };
+
+	// area of the capture framebuffer read this frame, GL coordinates so y counts up from the bottom
+	int m_SourceRect[4] = { 0, 0, 0, 0 };
+
+	// the UI can be drawn into an offscreen target at a fixed size and blitted to the window, captures then read the target
+	bool m_RenderOffscreen = false;
+	int m_OffscreenSize[2] = { 1600, 900 };
+	std::shared_ptr<RenderTarget> m_OffscreenTarget = nullptr;
+
+	// framebuffer captures are read from, the back buffer or the offscreen target
+	unsigned int m_CaptureFramebuffer = 0;
+	int m_FramebufferWidth = 1600;
+	int m_FramebufferHeight = 900;
+
+	// source size the scaling chain was built for, it is rebuilt if the source changes mid recording
+	int m_CaptureSourceWidth = 0;
+	int m_CaptureSourceHeight = 0;
+	std::vector<std::shared_ptr<RenderTarget>> m_CaptureTargets{};
+
+	// screenshots are read back through a ring of their own once the frame is drawn, then compressed and saved on a worker thread
+	struct PendingScreenshot
+	{
+		int m_Width = 0;
+		int m_Height = 0;
+		int m_Format = 0;
+	};
+
+	std::shared_ptr<PixelReadback> m_ScreenshotReadback = nullptr;
+	std::shared_ptr<ScreenshotWriter> m_ScreenshotWriter = nullptr;
+	std::deque<PendingScreenshot> m_PendingScreenshots{};
+
+	// format of the screenshot asked for this frame, -1 for none
+	int m_ScreenshotRequest = -1;
+
+	// the screen codec benchmark wants a real frame, so it runs once this frame has been drawn
+	bool m_ScreenCodecBenchmarkRequest = false;
+	unsigned int m_ScreenshotCount = 0;
 
 	double m_CumulativeFrameTime = 0.0;
 
 	unsigned int m_BufferSize = 0;
 
-	std::vector<void*> m_StoredFrames{};
+	std::shared_ptr<FramePool> m_FramePool = nullptr;
+
+	std::vector<FrameHandle> m_StoredFrames{};
+	std::shared_ptr<FrameStore> m_FrameStore = nullptr;
 
-	std::future<void> m_VideoWriteTask;
+	std::future<bool> m_VideoWriteTask;
 
 public:
 	Graphics() = default;
+	Graphics(const LaunchOptions& options) : m_Options(options) {}
 
 	int Start() override;
 	int Tick() override;
@@ -71,6 +220,22 @@ private:
 	int SetupGLFW();
 	int SetupImGUI();
 
+	void BeginOffscreenFrame();
+	void PresentOffscreenFrame(const int& displayWidth, const int& displayHeight);
+	void GetPresentRect(const int& width, const int& height, float& x, float& y, float& scale) const;
+	void GetCaptureSize(int& width, int& height) const;
+	void GetCaptureRegion(int& x, int& y, int& width, int& height, const bool& keepSize) const;
+	void SetupCaptureTargets();
+	bool CaptureFrame();
+	bool CollectFrame(const bool& wait);
+	void StoreFrame(const void* frameData, const std::chrono::steady_clock::time_point& capturedAt);
+	void RepeatFrame();
+	void SubmitFrame(FrameHandle frame, const std::chrono::steady_clock::time_point& capturedAt);
+	uint64_t HashDrawData(const int& width, const int& height) const;
+	void ReleaseStoredFrames();
+	void CaptureScreenshot();
+	void CollectScreenshots(const bool& wait);
+
 	void ShowMenuBar(bool& beginRendering, bool& showRenderScreen, bool& showCurrentlyRenderingScreen, bool& showPrintedScreen, bool& showStats, bool& closeShown);
 	void ShowStatsWindow();
 	int ShowRenderToFileWindow();
@@ -86,6 +251,9 @@ private:
 	void PrintGLFWInfo();
 	void PrintGLEWInfo();
 	void PrintSomethingFun();
+	void PrintConversionBenchmark();
+	void PrintMJPEGBenchmark();
+	void PrintScreenCodecBenchmark();
 
 };
 
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+enum class ImageFormat
+{
+	PNG = 0,
+	QOI,
+	Count
+};
+
+// still image files from BGRA pixels as they come out of a readback, bottom row first
+class ImageEncoder
+{
+public:
+	// RGB, each row filtered on its own, bands of rows are filtered and deflated on separate threads then joined into one stream
+	static bool EncodePNG(const uint8_t* bgra, const int& width, const int& height, const int& threads, std::vector<uint8_t>& out);
+
+	// RGB, much faster to write than PNG though larger, the format codes each pixel against the one before so it runs on one thread
+	static bool EncodeQOI(const uint8_t* bgra, const int& width, const int& height, std::vector<uint8_t>& out);
+
+	static bool Encode(const ImageFormat& format, const uint8_t* bgra, const int& width, const int& height, const int& threads, std::vector<uint8_t>& out);
+
+	static const char* GetName(const ImageFormat& format);
+	static const char* GetFileExtension(const ImageFormat& format);
+};
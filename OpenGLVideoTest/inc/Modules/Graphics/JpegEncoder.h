@@ -0,0 +1,61 @@
+#pragma once
+#include <Modules/Graphics/ColourConverter.h>
+#include <Modules/Graphics/WorkerPool.h>
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+// baseline 4:2:0 JFIF from bottom up BGRA, frames can be cut into restart interval slices that are encoded on separate threads
+class JpegEncoder
+{
+public:
+	// same instruction sets the colour converter picks between, the DCT and quantisation run on the best one
+	typedef ColourConverter::Path Path;
+
+private:
+	int m_Width = 0;
+	int m_Height = 0;
+	int m_Quality = 85;
+
+	Path m_Path = Path::Scalar;
+
+	// 16x16 macroblocks, four luma blocks and one of each chroma
+	int m_McuColumns = 0;
+	int m_McuRows = 0;
+
+	// each slice is a whole number of macroblock rows ending on a restart marker, so slices don't depend on each other
+	int m_SliceCount = 1;
+	int m_SliceRows = 0;
+
+	// in natural order, as written to the file, and as reciprocals the DCT output is scaled by
+	uint8_t m_QuantTables[2][64]{};
+	float m_Reciprocals[2][64]{};
+
+	// everything before the scan data, the same for every frame
+	std::vector<uint8_t> m_Header{};
+
+	std::vector<std::vector<uint8_t>> m_Slices{};
+
+	std::unique_ptr<WorkerPool> m_Pool = nullptr;
+
+	void BuildHeader();
+	void EncodeSlice(const uint8_t* bgra, const int& slice, std::vector<uint8_t>& out) const;
+
+public:
+	JpegEncoder() = default;
+	JpegEncoder(const int& width, const int& height, const int& quality, const int& threads);
+
+	// a complete JFIF image
+	bool Encode(const void* bgra, std::vector<uint8_t>& out);
+
+	void SetThreads(const int& threads);
+	bool SetPath(const Path& path);
+
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+	inline int GetQuality() const { return m_Quality; }
+	inline int GetThreads() const { return m_Pool != nullptr ? m_Pool->GetThreadCount() : 1; }
+	inline int GetSliceCount() const { return m_SliceCount; }
+	inline Path GetPath() const { return m_Path; }
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include <Modules/Graphics/EncoderBackend.h>
+
+struct IMFSinkWriter;
+
+// Windows Media Foundation sink writer, encodes to WMV3
+class MFEncoderBackend : public EncoderBackend
+{
+	EncoderSettings m_Settings{};
+
+	// frames are converted to NV12 before the encoder sees them
+	ColourConverter m_Converter;
+
+	IMFSinkWriter* m_SinkWriter = nullptr;
+	unsigned long m_StreamIndex = 0;
+
+	// what the sink writer says has reached the file
+	unsigned long long m_BytesOutput = 0;
+
+public:
+	~MFEncoderBackend() override;
+
+	int Open(const EncoderSettings& settings) override;
+	bool WriteFrame(const void* frameData, const long long& timestamp, const long long& duration) override;
+	bool Finalize() override;
+	void Close() override;
+
+	const char* GetName() const override { return "Media Foundation"; }
+
+	unsigned long long GetBytesOutput() const override { return m_BytesOutput; }
+
+	static bool IsSupported();
+
+	static bool Startup();
+	static void Shutdown();
+};
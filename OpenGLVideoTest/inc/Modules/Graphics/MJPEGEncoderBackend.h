@@ -0,0 +1,56 @@
+#pragma once
+#include <Modules/Graphics/EncoderBackend.h>
+#include <Modules/Graphics/OutputSink.h>
+#include <Modules/Graphics/JpegEncoder.h>
+#include <Modules/Graphics/MatroskaMuxer.h>
+
+// every frame is its own JPEG, so any frame can be encoded on any thread, and a single frame can be split into slices too
+class MJPEGSegmentEncoder : public SegmentEncoder
+{
+	JpegEncoder m_Encoder;
+
+public:
+	MJPEGSegmentEncoder(const EncoderSettings& settings, const int& threads);
+
+	bool Encode(const void* frameData, EncodedPacket& packet) override;
+	void SetThreads(const int& threads) override { m_Encoder.SetThreads(threads); }
+};
+
+// intra only motion JPEG, muxed into Matroska when going to a file
+// live outputs can't be seeked back into to finish a container, so they get the JPEGs back to back, which ffmpeg and VLC read as an mjpeg stream
+class MJPEGEncoderBackend : public EncoderBackend
+{
+	EncoderSettings m_Settings{};
+
+	std::unique_ptr<MatroskaMuxer> m_Muxer = nullptr;
+	std::unique_ptr<OutputSink> m_Sink = nullptr;
+
+	std::unique_ptr<MJPEGSegmentEncoder> m_Encoder = nullptr;
+	EncodedPacket m_Packet{};
+
+	// kept from the file once it is closed
+	WriteStats m_WriteStats{};
+	bool m_HasWriteStats = false;
+
+	unsigned long long m_BytesOutput = 0;
+
+public:
+	~MJPEGEncoderBackend() override;
+
+	int Open(const EncoderSettings& settings) override;
+	bool WriteFrame(const void* frameData, const long long& timestamp, const long long& duration) override;
+	bool Finalize() override;
+	void Close() override;
+
+	const char* GetName() const override { return "MJPEG"; }
+
+	bool IsLive() const override { return m_Sink != nullptr && m_Sink->IsLive(); }
+
+	// segment encoders run one per thread already, so they keep each frame on one
+	bool SupportsSegments() const override { return true; }
+	std::unique_ptr<SegmentEncoder> CreateSegmentEncoder() const override;
+	bool WritePacket(const EncodedPacket& packet) override;
+
+	unsigned long long GetBytesOutput() const override { return m_BytesOutput; }
+	bool GetWriteStats(WriteStats& stats) const override;
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <Modules/Graphics/WriteBehindFile.h>
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// single video track Matroska, written front to back through a write-behind file with the cues kept in memory until the end
+// clusters go out with an unknown size that Finalize fills in, so a recording cut short still plays up to where it stopped
+class MatroskaMuxer
+{
+	struct ClusterEntry
+	{
+		long long m_Time = 0;
+
+		// from the start of the segment's data, as cues and seek heads count
+		unsigned long long m_Position = 0;
+		unsigned long long m_Size = 0;
+
+		bool m_KeyFrame = false;
+	};
+
+	WriteBehindFile m_File;
+
+	std::vector<ClusterEntry> m_Clusters{};
+	bool m_ClusterOpen = false;
+
+	// where the values only known at the end are, as file offsets
+	unsigned long long m_SegmentSizeOffset = 0;
+	unsigned long long m_SegmentDataOffset = 0;
+	unsigned long long m_CuesPositionOffset = 0;
+	unsigned long long m_DurationOffset = 0;
+
+	long long m_EndTime = 0;
+	unsigned long long m_FramesWritten = 0;
+
+	bool m_Open = false;
+
+	void CloseCluster();
+
+public:
+	// Matroska counts in milliseconds here, frames come in 100ns units like everything else
+	static constexpr long long TimestampScale = 1000000;
+
+	// a new cluster starts on the first keyframe after this long, so seeking lands within a second of where it's asked
+	static constexpr long long ClusterDuration = 1000;
+
+	// big sequential writes with a few in flight, a slow disk has a while before it holds up the encoder
+	static constexpr size_t ChunkSize = 4 * 1024 * 1024;
+	static constexpr size_t ChunkCount = 4;
+
+	MatroskaMuxer() = default;
+	~MatroskaMuxer();
+
+	MatroskaMuxer(const MatroskaMuxer&) = delete;
+	MatroskaMuxer& operator=(const MatroskaMuxer&) = delete;
+
+	// codecId is the Matroska name, "V_MJPEG" for example
+	int Open(const std::string& filePath, const std::string& codecId, const int& width, const int& height, const int& frameRate);
+
+	// timestamps have to go up, the gap to the next frame is how long this one stays on screen
+	bool WriteFrame(const void* data, const size_t& size, const long long& timestamp, const long long& duration, const bool& keyFrame);
+
+	// cues, then a handful of fixed size fields near the start, so the work depends on the cluster count rather than the file size
+	bool Finalize();
+	void Close();
+
+	inline bool IsOpen() const { return m_Open; }
+	inline unsigned long long GetFramesWritten() const { return m_FramesWritten; }
+	inline size_t GetClusterCount() const { return m_Clusters.size(); }
+	inline const WriteBehindFile& GetFile() const { return m_File; }
+};
@@ -0,0 +1,128 @@
+#pragma once
+#include <Modules/Graphics/WriteBehindFile.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstddef>
+
+// where an encoder's bytes end up, a file or a live connection to another local process
+// live targets are given as "tcp://<port>" (loopback only), "pipe://<name>" or, off Windows, "unix://<path>"
+class OutputSink
+{
+public:
+	virtual ~OutputSink() = default;
+
+	virtual int Open(const std::string& target) = 0;
+
+	// sent once to a file, and again to each client that connects to a live sink so it can start mid recording
+	virtual bool WriteHeader(const void* data, const size_t& size) = 0;
+
+	// optional, a packet that isn't a keyframe can't be the first one a new live client sees
+	virtual void BeginPacket(const bool& keyFrame) {}
+
+	// part of the current packet
+	virtual bool Write(const void* data, const size_t& size) = 0;
+
+	// live sinks only take on a new client between packets, so the stream it sees always starts on a whole frame
+	virtual bool EndPacket() { return true; }
+
+	virtual bool Flush() = 0;
+	virtual void Close() = 0;
+
+	// a live sink drops data while nobody is listening, losing a client is not a failure
+	virtual bool IsLive() const { return false; }
+	virtual bool IsConnected() const { return true; }
+
+	virtual const char* GetName() const = 0;
+
+	// sinks that write behind the caller report how the writes are keeping up
+	virtual bool GetWriteStats(WriteStats& stats) const { return false; }
+
+	static std::unique_ptr<OutputSink> Create(const std::string& target);
+	static bool IsLiveTarget(const std::string& target);
+};
+
+// file output written behind the encoder in large chunks, so a slow disk holds up the encoder only once every chunk is in flight
+class FileSink : public OutputSink
+{
+	WriteBehindFile m_File;
+
+	// a few frames worth each, with several in flight at once
+	static constexpr size_t ChunkSize = 4 * 1024 * 1024;
+	static constexpr size_t ChunkCount = 4;
+
+public:
+	~FileSink() override;
+
+	int Open(const std::string& target) override;
+	bool WriteHeader(const void* data, const size_t& size) override { return Write(data, size); }
+	bool Write(const void* data, const size_t& size) override;
+	bool Flush() override;
+	void Close() override;
+
+	const char* GetName() const override { return "File"; }
+
+	bool GetWriteStats(WriteStats& stats) const override;
+};
+
+// a single client at a time on a loopback socket or local pipe, written to directly so a frame is on its way as soon as it is encoded
+// writes never block, a client that stops reading is waited on for a while and then dropped
+class LiveSink : public OutputSink
+{
+public:
+	enum class Transport { Tcp, Pipe, Unix };
+
+private:
+	Transport m_Transport = Transport::Tcp;
+	std::string m_Address = "";
+
+	// listening socket or pipe, and the connected client, as native handles
+	long long m_Listener = -1;
+	long long m_Client = -1;
+	bool m_Listening = false;
+
+	std::vector<unsigned char> m_Header{};
+
+	// set once a write to the current client fails, the rest of its packet is skipped
+	bool m_ClientLost = false;
+
+	// a new client is only sent packets from the next keyframe on, for streams where frames depend on the one before
+	bool m_WaitingForKeyFrame = false;
+	bool m_SkipPacket = false;
+
+	unsigned long long m_Clients = 0;
+	unsigned long long m_BytesSent = 0;
+
+	// keeps single writes to a size every transport takes in one go
+	static const size_t MaxChunk = 1024 * 1024;
+
+	// a client that takes no data for this long is dropped, so a stalled viewer can't hold up the writer or the end of the stream
+	static constexpr int SendTimeoutMs = 1000;
+
+	bool Listen();
+	bool Accept();
+	bool WaitForSpace(const int& timeoutMs);
+	bool Send(const void* data, const size_t& size);
+	void Disconnect();
+
+public:
+	~LiveSink() override;
+
+	int Open(const std::string& target) override;
+	bool WriteHeader(const void* data, const size_t& size) override;
+	void BeginPacket(const bool& keyFrame) override;
+	bool Write(const void* data, const size_t& size) override;
+	bool EndPacket() override;
+	bool Flush() override { return true; }
+	void Close() override;
+
+	bool IsLive() const override { return true; }
+	bool IsConnected() const override { return m_Client != -1; }
+
+	const char* GetName() const override;
+
+	inline unsigned long long GetClients() const { return m_Clients; }
+	inline unsigned long long GetBytesSent() const { return m_BytesSent; }
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+// counters for one stage of the streaming pipeline, written by the stage's own thread and read from anywhere
+// busy is time spent working, idle is waiting on the queue in front, stalled is waiting for room in the queue behind
+class PipelineStage
+{
+	std::atomic<unsigned long long> m_Items = 0;
+	std::atomic<unsigned long long> m_Dropped = 0;
+	std::atomic<long long> m_BusyNs = 0;
+	std::atomic<long long> m_IdleNs = 0;
+	std::atomic<long long> m_StallNs = 0;
+
+	std::atomic<size_t> m_Depth = 0;
+	std::atomic<size_t> m_MaxDepth = 0;
+	size_t m_Capacity = 0;
+
+	std::chrono::steady_clock::time_point m_Start{};
+
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	void Reset(const size_t& capacity);
+
+	inline void AddItems(const unsigned long long& count) { m_Items += count; }
+	inline void AddDropped() { m_Dropped++; }
+	inline void AddBusy(const Clock::time_point& since) { m_BusyNs += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - since).count(); }
+	inline void AddIdle(const Clock::time_point& since) { m_IdleNs += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - since).count(); }
+	inline void AddStall(const Clock::time_point& since) { m_StallNs += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - since).count(); }
+
+	// depth of the queue feeding this stage
+	void SetDepth(const size_t& depth);
+
+	inline unsigned long long GetItems() const { return m_Items; }
+	inline unsigned long long GetDropped() const { return m_Dropped; }
+	inline double GetBusyMs() const { return m_BusyNs / 1000000.0; }
+	inline double GetIdleMs() const { return m_IdleNs / 1000000.0; }
+	inline double GetStallMs() const { return m_StallNs / 1000000.0; }
+	inline size_t GetDepth() const { return m_Depth; }
+	inline size_t GetMaxDepth() const { return m_MaxDepth; }
+	inline size_t GetCapacity() const { return m_Capacity; }
+
+	// items per second since Reset
+	double GetThroughput() const;
+
+	// share of the elapsed time spent busy, the stage closest to 1 is the one holding the rest back
+	double GetLoad() const;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include <chrono>
+
+struct __GLsync;
+
+// ring of pixel buffer objects, each read is fenced and only mapped once the GPU has finished with it
+class PixelReadback
+{
+	struct Slot
+	{
+		unsigned int m_Buffer = 0;
+		__GLsync* m_Fence = nullptr;
+		std::chrono::steady_clock::time_point m_ReadAt{};
+	};
+
+	std::vector<Slot> m_Slots{};
+
+	unsigned int m_BufferSize = 0;
+
+	// oldest read still waiting to be mapped and the number of reads in flight
+	int m_Head = 0;
+	int m_Pending = 0;
+
+	bool m_Mapped = false;
+
+	unsigned long long m_ReadCount = 0;
+	unsigned long long m_FencePendingCount = 0;
+	unsigned long long m_StallCount = 0;
+
+	// fences that couldn't be made or waited on, and reads whose buffer wouldn't map and were skipped
+	unsigned long long m_FenceFailCount = 0;
+	unsigned long long m_MapFailCount = 0;
+
+public:
+	static constexpr int MinDepth = 2;
+	static constexpr int MaxDepth = 8;
+
+	// a full ring clears once the oldest read is collected, a read bigger than the buffers never fits
+	enum class ReadResult
+	{
+		Read,
+		RingFull,
+		TooLarge
+	};
+
+	PixelReadback(const unsigned int& bufferSize, const int& depth);
+	~PixelReadback();
+
+	PixelReadback(const PixelReadback&) = delete;
+	PixelReadback& operator=(const PixelReadback&) = delete;
+
+	ReadResult Read(const int& x, const int& y, const int& width, const int& height);
+
+	const void* Map(const bool& wait);
+	void Unmap();
+
+	// when the oldest pending read was issued, the capture time of the frame Map hands back next
+	inline std::chrono::steady_clock::time_point GetOldestReadTime() const { return m_Slots[m_Head].m_ReadAt; }
+
+	void Reset();
+
+	inline int GetDepth() const { return (int)m_Slots.size(); }
+	inline int GetPending() const { return m_Pending; }
+	inline unsigned int GetBufferSize() const { return m_BufferSize; }
+	inline unsigned long long GetReadCount() const { return m_ReadCount; }
+	inline unsigned long long GetFencePendingCount() const { return m_FencePendingCount; }
+	inline unsigned long long GetStallCount() const { return m_StallCount; }
+	inline unsigned long long GetFenceFailCount() const { return m_FenceFailCount; }
+	inline unsigned long long GetMapFailCount() const { return m_MapFailCount; }
+};
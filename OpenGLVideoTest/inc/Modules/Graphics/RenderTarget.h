@@ -0,0 +1,36 @@
+#pragma once
+
+// framebuffer object with a single BGRA colour renderbuffer, used to resize or hold frames on the GPU before readback
+class RenderTarget
+{
+	unsigned int m_ID = 0;
+	unsigned int m_ColourBuffer = 0;
+
+	int m_Width = 0;
+	int m_Height = 0;
+
+public:
+	RenderTarget(const int& width, const int& height);
+	~RenderTarget();
+
+	RenderTarget(const RenderTarget&) = delete;
+	RenderTarget& operator=(const RenderTarget&) = delete;
+
+	void Bind(bool makeBind) const;
+	void BindRead(bool makeBind) const;
+
+	// copies the whole of the read framebuffer 'source' into this target, scaling it to fit
+	void BlitFrom(const unsigned int& source, const int& sourceWidth, const int& sourceHeight, const bool& linear) const;
+
+	// same, from just the given rect of 'source'
+	void BlitFrom(const unsigned int& source, const int& sourceX, const int& sourceY, const int& sourceWidth, const int& sourceHeight, const bool& linear) const;
+
+	// copies the whole target into the given rect of the draw framebuffer 'destination'
+	void BlitTo(const unsigned int& destination, const int& x, const int& y, const int& width, const int& height, const bool& linear) const;
+
+	bool IsComplete() const;
+
+	inline unsigned int GetID() const { return m_ID; }
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+// bounded single producer, single consumer ring, neither side ever takes a lock
+// each side keeps its own copy of the other's index so the shared cache lines are only touched when the ring looks full or empty
+template<typename T>
+class SPSCRing
+{
+	std::vector<T> m_Slots{};
+	size_t m_Mask = 0;
+
+	alignas(64) std::atomic<size_t> m_Head = 0;
+	size_t m_CachedTail = 0;
+
+	alignas(64) std::atomic<size_t> m_Tail = 0;
+	size_t m_CachedHead = 0;
+
+public:
+	// rounded up to a power of two
+	explicit SPSCRing(const size_t& capacity)
+	{
+		size_t size = 2;
+
+		while (size < capacity)
+			size <<= 1;
+
+		m_Slots.resize(size);
+		m_Mask = size - 1;
+	}
+
+	SPSCRing(const SPSCRing&) = delete;
+	SPSCRing& operator=(const SPSCRing&) = delete;
+
+	// producer only, item is left untouched when full
+	bool TryPush(T& item)
+	{
+		const size_t tail = m_Tail.load(std::memory_order_relaxed);
+
+		if (tail - m_CachedHead > m_Mask)
+		{
+			m_CachedHead = m_Head.load(std::memory_order_acquire);
+
+			if (tail - m_CachedHead > m_Mask)
+				return false;
+		}
+
+		m_Slots[tail & m_Mask] = std::move(item);
+		m_Tail.store(tail + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	// consumer only
+	bool TryPop(T& item)
+	{
+		const size_t head = m_Head.load(std::memory_order_relaxed);
+
+		if (head == m_CachedTail)
+		{
+			m_CachedTail = m_Tail.load(std::memory_order_acquire);
+
+			if (head == m_CachedTail)
+				return false;
+		}
+
+		item = std::move(m_Slots[head & m_Mask]);
+		m_Head.store(head + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	// a snapshot, only exact from the producer or consumer thread
+	inline size_t GetSize() const { return m_Tail.load(std::memory_order_acquire) - m_Head.load(std::memory_order_acquire); }
+	inline size_t GetCapacity() const { return m_Mask + 1; }
+	inline bool IsEmpty() const { return GetSize() == 0; }
+};
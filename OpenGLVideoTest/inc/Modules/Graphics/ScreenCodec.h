@@ -0,0 +1,77 @@
+#pragma once
+#include <Modules/Graphics/WorkerPool.h>
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+// lossless codec for GUI frames, which are mostly flat colour, sharp text and whatever hasn't changed since the last frame
+// frames are cut into tiles that are each skipped, filled, palette coded or run length coded against the previous frame
+class ScreenCodec
+{
+public:
+	static constexpr int TileSize = 32;
+
+	// stored in the low two bits of every tile header
+	enum class TileMode
+	{
+		Skip,
+		Solid,
+		Palette,
+		Pixels,
+		Count
+	};
+
+private:
+	int m_Width = 0;
+	int m_Height = 0;
+
+	int m_TileColumns = 0;
+	int m_TileRows = 0;
+
+	// each band is a whole number of tile rows with a size of its own, so bands are encoded and decoded on separate threads
+	int m_BandCount = 1;
+	int m_BandRows = 0;
+
+	std::vector<std::vector<uint8_t>> m_Bands{};
+	std::vector<std::vector<int>> m_BandTileCounts{};
+
+	// the last frame encoded or decoded, what skipped tiles and previous frame runs copy from
+	std::vector<uint8_t> m_Reference{};
+	bool m_HasReference = false;
+
+	int m_TileCounts[(int)TileMode::Count]{};
+
+	std::unique_ptr<WorkerPool> m_Pool = nullptr;
+
+	void EncodeBand(const uint8_t* bgra, const bool& keyFrame, const int& firstRow, const int& rowCount, std::vector<uint8_t>& out, std::vector<int>& tileCounts);
+	bool DecodeBand(const uint8_t* data, const size_t& size, const bool& keyFrame, const int& firstRow, const int& rowCount);
+
+public:
+	ScreenCodec() = default;
+	ScreenCodec(const int& width, const int& height, const int& threads);
+
+	// keyframes don't look at the previous frame, the first frame is always one
+	bool Encode(const void* bgra, const bool& keyFrame, std::vector<uint8_t>& out);
+
+	// rebuilds a bottom up BGRA frame, alpha is always 255 as only colour is kept
+	bool Decode(const uint8_t* data, const size_t& size, void* bgra);
+
+	// the next frame is encoded as a keyframe, and the next decoded has to be one
+	void Reset();
+
+	void SetThreads(const int& threads);
+
+	static bool IsKeyFrame(const uint8_t* data, const size_t& size);
+
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+	inline int GetThreads() const { return m_Pool != nullptr ? m_Pool->GetThreadCount() : 1; }
+	inline int GetBandCount() const { return m_BandCount; }
+	inline int GetTileCount() const { return m_TileColumns * m_TileRows; }
+
+	// how the tiles of the last encoded frame were stored
+	inline int GetTileCount(const TileMode& mode) const { return m_TileCounts[(int)mode]; }
+
+	static const char* GetModeName(const TileMode& mode);
+};
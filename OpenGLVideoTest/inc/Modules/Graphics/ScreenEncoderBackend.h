@@ -0,0 +1,64 @@
+#pragma once
+#include <Modules/Graphics/EncoderBackend.h>
+#include <Modules/Graphics/OutputSink.h>
+#include <Modules/Graphics/ScreenCodec.h>
+
+// inter frames lean on the frame before, so a segment is kept on one encoder and starts a keyframe every interval
+class ScreenSegmentEncoder : public SegmentEncoder
+{
+	ScreenCodec m_Codec;
+
+	int m_KeyFrameInterval = 60;
+	long long m_FrameCount = 0;
+
+public:
+	ScreenSegmentEncoder(const EncoderSettings& settings, const int& threads);
+
+	bool Encode(const void* frameData, EncodedPacket& packet) override;
+	void SetThreads(const int& threads) override { m_Codec.SetThreads(threads); }
+};
+
+// lossless screen codec in a small container of its own
+// "GLSC", version, tile size, then 32 bit width, height and frame rate, followed by a record per frame of
+// 32 bit size, 64 bit timestamp and duration in 100ns units, and the frame itself, all little endian
+class ScreenEncoderBackend : public EncoderBackend
+{
+public:
+	static constexpr uint8_t StreamVersion = 1;
+	static constexpr size_t HeaderSize = 18;
+	static constexpr size_t RecordSize = 20;
+
+private:
+	EncoderSettings m_Settings{};
+
+	// a file, or a live connection, clients that join part way through wait for the next keyframe
+	std::unique_ptr<OutputSink> m_Sink = nullptr;
+
+	std::unique_ptr<ScreenSegmentEncoder> m_Encoder = nullptr;
+	EncodedPacket m_Packet{};
+
+	// kept from the file once it is closed
+	WriteStats m_WriteStats{};
+	bool m_HasWriteStats = false;
+
+	unsigned long long m_BytesOutput = 0;
+
+public:
+	~ScreenEncoderBackend() override;
+
+	int Open(const EncoderSettings& settings) override;
+	bool WriteFrame(const void* frameData, const long long& timestamp, const long long& duration) override;
+	bool Finalize() override;
+	void Close() override;
+
+	const char* GetName() const override { return "Screen Codec"; }
+
+	bool IsLive() const override { return m_Sink != nullptr && m_Sink->IsLive(); }
+
+	bool SupportsSegments() const override { return true; }
+	std::unique_ptr<SegmentEncoder> CreateSegmentEncoder() const override;
+	bool WritePacket(const EncodedPacket& packet) override;
+
+	unsigned long long GetBytesOutput() const override { return m_BytesOutput; }
+	bool GetWriteStats(WriteStats& stats) const override;
+};
@@ -0,0 +1,54 @@
+#pragma once
+#include <Modules/Graphics/ScreenCodec.h>
+#include <Modules/Graphics/ScreenEncoderBackend.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// reads back the .glsc files ScreenEncoderBackend writes, a decoded frame at a time
+// a stream saved from a live connection may start part way through, frames before its first keyframe are skipped
+class ScreenStreamReader
+{
+	std::ifstream m_File;
+
+	ScreenCodec m_Codec;
+
+	int m_Width = 0;
+	int m_Height = 0;
+	int m_FrameRate = 0;
+
+	std::vector<uint8_t> m_Packet{};
+	bool m_HasKeyFrame = false;
+
+	// set once the last whole record has been read, a file that stops part way through a record isn't finished
+	bool m_Finished = false;
+
+	unsigned long long m_FramesRead = 0;
+	unsigned long long m_FramesSkipped = 0;
+
+public:
+	~ScreenStreamReader();
+
+	int Open(const std::string& path, const int& threads = 1);
+
+	// false at the end of the file or on a frame that doesn't decode, IsFinished tells them apart
+	// frames come out bottom up BGRA, the layout every EncoderBackend takes
+	bool ReadFrame(std::vector<uint8_t>& bgra, long long& timestamp, long long& duration);
+
+	void Close();
+
+	inline bool IsOpen() const { return m_File.is_open(); }
+	inline bool IsFinished() const { return m_Finished; }
+
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+	inline int GetFrameRate() const { return m_FrameRate; }
+
+	inline unsigned long long GetFramesRead() const { return m_FramesRead; }
+	inline unsigned long long GetFramesSkipped() const { return m_FramesSkipped; }
+
+	// decodes a whole file into another encoder's output, keeping each frame's timestamp and duration
+	static int Export(const std::string& input, const std::string& output, const EncoderType& type);
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include <Modules/Graphics/ImageEncoder.h>
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+// compresses and saves screenshots on a worker thread, the render thread only copies the pixels out of the readback
+class ScreenshotWriter
+{
+	struct Job
+	{
+		std::vector<uint8_t> m_Pixels{};
+		int m_Width = 0;
+		int m_Height = 0;
+		ImageFormat m_Format = ImageFormat::PNG;
+		std::string m_FilePath = "";
+	};
+
+	int m_Threads = 1;
+
+	std::thread m_Worker;
+	mutable std::mutex m_Mutex;
+	std::condition_variable m_Condition;
+	std::deque<Job> m_Jobs{};
+	bool m_Finishing = false;
+
+	// pixel buffers handed back once a screenshot is saved, so taking another doesn't allocate and fault in a fresh one
+	std::vector<std::vector<uint8_t>> m_FreeBuffers{};
+
+	std::atomic<unsigned long long> m_Saved = 0;
+	std::atomic<unsigned long long> m_Failed = 0;
+	std::atomic<unsigned long long> m_LastBytes = 0;
+	std::atomic<long long> m_LastEncodeUs = 0;
+	std::atomic<long long> m_LastWriteUs = 0;
+
+	void SaveScreenshots();
+
+public:
+	// screenshots waiting past this are turned away rather than queueing unbounded copies of the window
+	static const size_t MaxPending = 8;
+
+	// threads is how many bands a PNG is compressed in at once
+	ScreenshotWriter(const int& threads);
+	~ScreenshotWriter();
+
+	ScreenshotWriter(const ScreenshotWriter&) = delete;
+	ScreenshotWriter& operator=(const ScreenshotWriter&) = delete;
+
+	// a buffer of at least size bytes to copy pixels into, reused from an earlier screenshot where possible
+	std::vector<uint8_t> AcquireBuffer(const size_t& size);
+
+	// pixels are bottom up BGRA, false if too many screenshots are already waiting
+	bool Submit(std::vector<uint8_t> pixels, const int& width, const int& height, const ImageFormat& format, const std::string& filePath);
+
+	// blocks until every submitted screenshot has been saved
+	void Finish();
+
+	size_t GetPending() const;
+	unsigned long long GetSaved() const { return m_Saved; }
+	unsigned long long GetFailed() const { return m_Failed; }
+	unsigned long long GetLastBytes() const { return m_LastBytes; }
+	double GetLastEncodeMs() const { return m_LastEncodeUs / 1000.0; }
+	double GetLastWriteMs() const { return m_LastWriteUs / 1000.0; }
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <vector>
+
+// preallocated ring of frame slots in a memory mapped file, frames go in at the tail and are freed from the head in order
+// one thread may Push while another Releases, like the ring its frames are queued on
+class SpillFile
+{
+#ifdef _WIN32
+	void* m_File = nullptr;
+	void* m_Mapping = nullptr;
+#else
+	int m_File = -1;
+#endif
+	uint8_t* m_View = nullptr;
+
+	size_t m_FrameSize = 0;
+	size_t m_SlotSize = 0;
+	size_t m_SlotCount = 0;
+
+	// both only ever count up, the slot is the count modulo m_SlotCount
+	std::atomic<size_t> m_Head = 0;
+	std::atomic<size_t> m_Tail = 0;
+
+	// slots released out of order, the head only moves past a slot once it and every slot before it is released
+	// only the releasing thread touches these
+	std::vector<uint8_t> m_Released{};
+
+	size_t m_HighWater = 0;
+	unsigned long long m_TotalSpilled = 0;
+
+public:
+	// page sized slots so written and consumed slots can be handed back to the os on their own
+	static const size_t SlotAlignment = 4096;
+
+	SpillFile() = default;
+	~SpillFile();
+
+	SpillFile(const SpillFile&) = delete;
+	SpillFile& operator=(const SpillFile&) = delete;
+
+	// creates and preallocates the file, it is deleted again on Close
+	int Open(const char* filePath, const size_t& frameSize, const size_t& slotCount);
+	void Close();
+
+	// reserves the tail slot, the caller fills it through GetSlot then calls Written, false when full
+	bool Push(size_t& slot);
+	void Written(const size_t& slot);
+
+	// takes back the slot just pushed, only for the pushing thread and only while nothing else has seen the slot
+	void Unpush();
+
+	// frees a slot once its frame has been encoded or dropped, slots held by earlier frames stay put
+	void Release(const size_t& slot);
+
+	uint8_t* GetSlot(const size_t& slot) const;
+
+	inline bool IsOpen() const { return m_View != nullptr; }
+	inline size_t GetCount() const { return m_Tail - m_Head; }
+	inline bool IsFull() const { return GetCount() >= m_SlotCount; }
+	inline size_t GetSlotCount() const { return m_SlotCount; }
+	inline size_t GetFrameSize() const { return m_FrameSize; }
+	inline size_t GetHighWater() const { return m_HighWater; }
+	inline unsigned long long GetTotalSpilled() const { return m_TotalSpilled; }
+	inline unsigned long long GetFileSize() const { return (unsigned long long)m_SlotSize * m_SlotCount; }
+};
@@ -1,14 +1,22 @@
 #pragma once
 #include <Modules/ModulePart.h>
+#include <Modules/Graphics/FramePool.h>
+#include <Modules/Graphics/FrameStore.h>
+#include <Modules/Graphics/SpillFile.h>
+#include <Modules/Graphics/SPSCRing.h>
+#include <Modules/Graphics/PipelineStage.h>
+#include <Modules/Graphics/EncoderBackend.h>
+#include <Modules/Graphics/WriteBehindFile.h>
 
-#include <windows.h>
 #include <memory>
-#include <guiddef.h>
-
 #include <string>
 #include <vector>
-
-struct IMFSinkWriter;
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 class VideoWriter : public ModulePart
 {
@@ -17,38 +25,209 @@ public:
 	int Tick() override;
 	int End() override;
 
+	// hands buffered frames to the encode loops in order, every segment worker gets its own
+	class FrameSource
+	{
+	public:
+		virtual ~FrameSource() = default;
+
+		// false on failure
+		virtual bool Get(const size_t& index, const void*& frameData) = 0;
+		virtual void Done(const size_t& index) {}
+
+		// a repeat is a duplicate of the frame before, it only stretches that frame's duration
+		virtual bool IsRepeat(const size_t& index) const = 0;
+	};
+
+	typedef std::function<std::unique_ptr<FrameSource>()> FrameSourceFactory;
+
+	// what capture does once the encoder has no room left, a dropped frame becomes a repeat of the one before so timing holds
+	enum class QueuePolicy { Block, DropOldest, DropNewest };
+
+	// streaming runs capture -> encode -> write, each on its own thread with a lock free ring in between
+	enum class StreamStage { Capture, Encode, Write, Count };
+
 private:
-	std::wstring m_FilePath = L"";
+	std::string m_FilePath = "";
 	int m_FrameRate = 60;
 	int m_FrameWidth = 640;
 	int m_FrameHeight = 480;
 	long m_FrameDur = 10 * 1000 * 1000 / 60;
 	int m_BitRate = 80000;
-	GUID m_VideoEncFormat;
-	GUID m_VideoInFormat;
-	unsigned int m_VideoArea = 640 * 480;
 	unsigned int m_FrameCount = 20 * 60;
 
-	void* m_FrameData;
+	ColourConverter::Matrix m_ColourMatrix = ColourConverter::Matrix::BT709;
+	int m_Quality = 85;
 
-	IMFSinkWriter* m_SinkWriter;
-	std::shared_ptr<DWORD> m_StreamIndex;
+	// the front end only queues and times frames, the backend does the encoding and writing
+	EncoderType m_EncoderType = EncoderBackend::GetDefault();
+	std::unique_ptr<EncoderBackend> m_Backend = nullptr;
+
+	// buffered recordings are cut into this many keyframe aligned segments and encoded side by side
+	int m_EncodeThreads = 1;
+	int m_KeyFrameInterval = 60;
+	// packets a segment may have encoded ahead of the writer, past this its worker waits so later segments don't buffer the whole recording
+	static constexpr size_t SegmentQueueDepth = 4;
 
 	bool m_Started = false;
 	bool m_Initialised = false;
 	bool m_Writing = false;
+
+	// streaming mode, frames are queued by the capture thread, encoded on m_StreamThread and written out on m_WriteThread
+	std::thread m_StreamThread;
+	std::thread m_WriteThread;
+
+	// a queued frame is either held in memory or parked in the spill file, an empty one repeats the frame before
+	struct QueuedFrame
+	{
+		FrameHandle m_Frame;
+		bool m_Spilled = false;
+		size_t m_SpillSlot = 0;
+		PipelineStage::Clock::time_point m_CapturedAt{};
+	};
+
+	struct QueuedPacket
+	{
+		EncodedPacket m_Packet{};
+		PipelineStage::Clock::time_point m_CapturedAt{};
+	};
+
+	std::unique_ptr<SPSCRing<QueuedFrame>> m_EncodeQueue = nullptr;
+	size_t m_MaxQueuedFrames = 4;
+	std::atomic<size_t> m_QueuedInMemory = 0;
+
+	QueuePolicy m_QueuePolicy = QueuePolicy::Block;
+	// oldest frames the encoder should throw away rather than encode, only capture adds and only the encoder takes
+	std::atomic<unsigned int> m_DropRequests = 0;
+
+	// backends that split encoding from writing get a packet ring to the writer, spent packets come back so their buffers are reused
+	static const size_t WriteQueueDepth = 4;
+	std::unique_ptr<SegmentEncoder> m_StreamEncoder = nullptr;
+	std::unique_ptr<SPSCRing<QueuedPacket>> m_WriteQueue = nullptr;
+	std::unique_ptr<SPSCRing<QueuedPacket>> m_FreePackets = nullptr;
+
+	std::atomic<bool> m_StreamEnding = false;
+	std::atomic<bool> m_StreamFailed = false;
+	std::atomic<bool> m_EncodeDone = false;
+	std::atomic<unsigned int> m_FramesStreamed = 0;
+
+	PipelineStage m_Stages[(int)StreamStage::Count];
+
+	// capture to write, how long after its pixels were read back each frame actually left the writer
+	std::atomic<long long> m_LatencyTotalNs = 0;
+	std::atomic<long long> m_LatencyMaxNs = 0;
+	std::atomic<unsigned long long> m_LatencyCount = 0;
+
+	// once m_MaxQueuedFrames are in memory, further frames page out to disk rather than holding capture back
+	std::string m_SpillFilePath = "";
+	size_t m_MaxSpilledFrames = 0;
+	std::unique_ptr<SpillFile> m_Spill = nullptr;
+	std::atomic<unsigned int> m_FramesSpilled = 0;
+	std::atomic<unsigned int> m_SpillQueued = 0;
+	std::atomic<unsigned int> m_SpillHighWater = 0;
+
+	// progress of the current save or stream, published as frames are encoded so the UI can show how far along it is
+	// repeats count as frames encoded but cost no encode time, streaming adds to the frames to encode as they are queued
+	std::atomic<unsigned int> m_FramesEncoded = 0;
+	std::atomic<unsigned int> m_FramesToEncode = 0;
+	std::atomic<unsigned long long> m_BytesOutput = 0;
+	std::atomic<long long> m_EncodeTotalNs = 0;
+	std::atomic<unsigned long long> m_EncodeCount = 0;
+	std::atomic<long long> m_EncodeStartNs = 0;
+	std::atomic<long long> m_EncodeEndNs = 0;
+
+	// copied from the backend by whichever thread is writing, they outlive the backend so the last recording's can be shown
+	mutable std::mutex m_WriteStatsMutex;
+	WriteStats m_WriteStats{};
+	bool m_HasWriteStats = false;
 	
-	bool WriteFrame(void*, const long long&);
+	bool WriteFrame(const void*, const long long& timestamp, const long long& duration);
+	bool Finalize();
+
+	bool WriteFrames(const size_t& frameCount, const FrameSourceFactory& createSource);
+	bool WriteSegments(const size_t& frameCount, const FrameSourceFactory& createSource);
+
+	void StreamFrames();
+	void WritePackets();
 
-	void SetFilePath(const char* filePath);
+	size_t GetQueuedFrames() const;
+	void AddLatency(const PipelineStage::Clock::time_point& capturedAt);
+
+	void ResetProgress(const unsigned int& framesToEncode);
+	void AddEncoded(const long long& duration, const PipelineStage::Clock::time_point& encodeStart);
+	void UpdateOutputStats();
 
 public:
 	int Init(const char* filePath, const int& frameWidth, const int& frameHeight, const int& frameRate, const int& dur, const int& bitRate);
 
-	void WriteAllFrames(std::vector<void*> frames);
+	// frames are handed over, each one goes back to its pool as soon as it has been encoded, an empty handle repeats the frame before
+	// false if any frame failed to encode or the file couldn't be finished
+	bool WriteAllFrames(std::vector<FrameHandle> frames);
+
+	// same as WriteAllFrames but decodes each frame out of a compressed store first
+	bool WriteStoredFrames(std::shared_ptr<FrameStore> store);
+
+	void SetColourMatrix(const ColourConverter::Matrix& matrix) { m_ColourMatrix = matrix; }
+	ColourConverter::Matrix GetColourMatrix() { return m_ColourMatrix; }
+
+	// used by the encoders that take a quality rather than a bit rate
+	void SetQuality(const int& quality) { m_Quality = quality; }
+	int GetQuality() { return m_Quality; }
+
+	void SetEncoderType(const EncoderType& type) { m_EncoderType = type; }
+	EncoderType GetEncoderType() { return m_EncoderType; }
+
+	void SetEncodeThreads(const int& threads) { m_EncodeThreads = threads > 0 ? threads : 1; }
+	int GetEncodeThreads() { return m_EncodeThreads; }
+
+	// an empty path turns spilling off, the file is created and sized when streaming begins
+	void SetSpillFile(const std::string& filePath, const size_t& maxFrames) { m_SpillFilePath = filePath; m_MaxSpilledFrames = maxFrames; }
+
+	void SetQueuePolicy(const QueuePolicy& policy) { m_QueuePolicy = policy; }
+	QueuePolicy GetQueuePolicy() { return m_QueuePolicy; }
+
+	int BeginStreaming(const size_t& maxQueuedFrames);
+	// an empty handle repeats the last frame, the writer holds each frame back until it knows how long it lasts
+	// capturedAt is when the frame's readback was issued, so latency covers the readback and the copy as well as the queue
+	bool QueueFrame(FrameHandle frame, const PipelineStage::Clock::time_point& capturedAt);
+	// false if the stream failed part way, wrote nothing, or couldn't be finished
+	bool EndStreaming();
 
     bool IsInit() { return m_Initialised; }
 	bool IsWriting() { return m_Writing; }
+	bool IsStreaming() { return m_StreamThread.joinable(); }
+	unsigned int GetFramesStreamed() { return m_FramesStreamed; }
+	unsigned int GetFramesSpilled() { return m_FramesSpilled; }
+	unsigned int GetSpillQueued() { return m_SpillQueued; }
+	unsigned int GetSpillHighWater() { return m_SpillHighWater; }
+	size_t GetFrameSize() { return (size_t)m_FrameWidth * m_FrameHeight * 4; }
+
+	const PipelineStage& GetStage(const StreamStage& stage) const { return m_Stages[(int)stage]; }
+	static const char* GetStageName(const StreamStage& stage);
+
+	double GetAverageLatencyMs() const;
+	double GetMaxLatencyMs() const { return m_LatencyMaxNs / 1000000.0; }
+
+	// false for backends that don't write a file behind themselves
+	bool GetWriteStats(WriteStats& stats) const;
+
+	unsigned int GetFramesEncoded() const { return m_FramesEncoded; }
+	unsigned int GetFramesToEncode() const { return m_FramesToEncode; }
+	unsigned int GetFramesRemaining() const;
+
+	// encoded bytes the backend has written so far
+	unsigned long long GetBytesOutput() const { return m_BytesOutput; }
+
+	// time in the encoder for each frame it was handed, and output frames per second since the save or stream began
+	double GetAverageEncodeMs() const;
+	double GetEncodeFps() const;
+
+	// seconds left at the current rate, negative while there isn't a rate yet
+	double GetSecondsRemaining() const;
+
+	VideoWriter() = default;
+	VideoWriter(const VideoWriter&) = delete;
+	VideoWriter& operator=(const VideoWriter&) = delete;
 
 	~VideoWriter();
 	
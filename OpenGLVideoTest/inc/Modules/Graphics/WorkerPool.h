@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// threads kept alive between batches of work, for jobs split up many times a second where starting threads each time would cost too much
+// the calling thread works on the batch too, and Run returns once every task in it has finished
+class WorkerPool
+{
+	std::vector<std::thread> m_Threads{};
+
+	std::mutex m_Mutex;
+	std::condition_variable m_StartCondition;
+	std::condition_variable m_DoneCondition;
+
+	const std::function<void(const int&)>* m_Task = nullptr;
+	int m_TaskCount = 0;
+	std::atomic<int> m_NextTask = 0;
+
+	// bumped for each batch so a worker knows it hasn't seen it yet, and how many workers are still in it
+	unsigned long long m_Batch = 0;
+	int m_Working = 0;
+	bool m_Stopping = false;
+
+	void Work();
+	void RunTasks();
+
+public:
+	// threads counts the caller, so one fewer are started
+	explicit WorkerPool(const int& threads);
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	// calls task(i) for every i in [0, taskCount), spread over the pool
+	void Run(const int& taskCount, const std::function<void(const int&)>& task);
+
+	inline int GetThreadCount() const { return (int)m_Threads.size() + 1; }
+};
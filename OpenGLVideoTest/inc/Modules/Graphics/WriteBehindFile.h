@@ -0,0 +1,158 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+// how the writes behind a file are going, safe to take from any thread while it is being written
+struct WriteStats
+{
+	const char* m_Engine = "";
+
+	unsigned long long m_Chunks = 0;
+	unsigned long long m_Bytes = 0;
+
+	// from a chunk being handed over to it being in the file
+	double m_AverageLatencyMs = 0.0;
+	double m_MaxLatencyMs = 0.0;
+
+	// chunks handed over and not yet written, out of how many can be, all of them only while a write waits on one
+	size_t m_Depth = 0;
+	size_t m_MaxDepth = 0;
+	size_t m_Capacity = 0;
+
+	// times a write had to wait for the disk to free a chunk
+	unsigned long long m_Stalls = 0;
+};
+
+// appends go into large page aligned chunks that are written out behind the caller, so it only ever copies into memory
+// every full chunk lands at a multiple of the chunk size, one big sequential write each, with several in flight at once
+// on Linux the writes go through io_uring from the registered chunks, elsewhere or where that isn't allowed a thread makes positioned writes
+class WriteBehindFile
+{
+public:
+	enum class Engine
+	{
+		Thread,
+		IoUring,
+		Count
+	};
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Chunk
+	{
+		uint8_t* m_Data = nullptr;
+		size_t m_Size = 0;
+		unsigned long long m_Offset = 0;
+
+		// which of m_Buffers it is, and when it was handed over
+		size_t m_Index = 0;
+		Clock::time_point m_QueuedAt{};
+	};
+
+	// ring state, only defined where io_uring is
+	struct IoUring;
+
+#ifdef _WIN32
+	void* m_File = nullptr;
+#else
+	int m_File = -1;
+#endif
+
+	Engine m_Engine = Engine::Thread;
+	std::unique_ptr<IoUring> m_Ring;
+	bool m_FixedBuffers = false;
+
+	size_t m_ChunkSize = 0;
+	size_t m_ChunkCount = 0;
+
+	// every chunk ever allocated, and the ones free to fill
+	std::vector<uint8_t*> m_Buffers{};
+	std::vector<size_t> m_FreeBuffers{};
+
+	// the chunk being filled, and the file offset it starts at
+	Chunk m_Current{};
+
+	// handed over and not yet written, the thread takes them in order, io_uring finishes them in any order
+	std::deque<Chunk> m_Queue{};
+	std::vector<Chunk> m_InFlight{};
+	size_t m_Pending = 0;
+
+	std::thread m_Writer;
+	std::mutex m_Mutex;
+	std::condition_variable m_QueuedCondition;
+	std::condition_variable m_FreeCondition;
+	bool m_Stopping = false;
+
+	// set by the writer, every write after a failure is refused
+	std::atomic<bool> m_Failed = false;
+
+	std::atomic<unsigned long long> m_BytesWritten = 0;
+	std::atomic<unsigned long long> m_ChunksWritten = 0;
+	std::atomic<long long> m_LatencyTotalUs = 0;
+	std::atomic<long long> m_LatencyMaxUs = 0;
+	std::atomic<size_t> m_Depth = 0;
+	std::atomic<size_t> m_MaxDepth = 0;
+	std::atomic<unsigned long long> m_Stalls = 0;
+
+	void WriteChunks();
+	void ReapChunks();
+	void ChunkWritten(const Chunk& chunk, const bool& success);
+	bool WriteNative(const void* data, const size_t& size, const unsigned long long& offset);
+
+	bool OpenRing();
+	void CloseRing();
+	bool SubmitRing(const Chunk& chunk);
+
+	bool QueueCurrent();
+	bool Drain();
+
+	static uint8_t* AllocateBuffer(const size_t& size);
+	static void FreeBuffer(uint8_t* buffer);
+
+public:
+	// chunks are a multiple of this, which suits both pages and disk sectors
+	static const size_t Alignment = 4096;
+
+	WriteBehindFile();
+	~WriteBehindFile();
+
+	WriteBehindFile(const WriteBehindFile&) = delete;
+	WriteBehindFile& operator=(const WriteBehindFile&) = delete;
+
+	// chunkCount chunks of chunkSize are allocated up front, a writer that gets that far behind holds up Write until one is free
+	int Open(const std::string& filePath, const size_t& chunkSize, const size_t& chunkCount);
+
+	bool Write(const void* data, const size_t& size);
+
+	// overwrites bytes already written, for headers that are only known at the end, in memory if they haven't gone out yet
+	bool WriteAt(const unsigned long long& offset, const void* data, const size_t& size);
+
+	// blocks until everything written so far is in the file
+	bool Flush();
+	void Close();
+
+	inline bool IsOpen() const { return !m_Buffers.empty(); }
+	inline bool HasFailed() const { return m_Failed; }
+
+	// where the next Write lands
+	inline unsigned long long GetPosition() const { return m_Current.m_Offset + m_Current.m_Size; }
+
+	inline Engine GetEngine() const { return m_Engine; }
+	inline size_t GetChunkSize() const { return m_ChunkSize; }
+
+	// the last file's stay until the next Open
+	WriteStats GetStats() const;
+
+	static const char* GetEngineName(const Engine& engine);
+};
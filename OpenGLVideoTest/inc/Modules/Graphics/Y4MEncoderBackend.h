@@ -0,0 +1,55 @@
+#pragma once
+#include <Modules/Graphics/EncoderBackend.h>
+#include <Modules/Graphics/OutputSink.h>
+
+// conversion to I420 is the only real work a Y4M frame needs, so that is what gets spread across threads
+class Y4MSegmentEncoder : public SegmentEncoder
+{
+	ColourConverter m_Converter;
+
+public:
+	Y4MSegmentEncoder(const EncoderSettings& settings);
+
+	bool Encode(const void* frameData, EncodedPacket& packet) override;
+};
+
+// uncompressed 4:2:0 written straight to disk, a portable baseline that needs nothing but the CRT
+class Y4MEncoderBackend : public EncoderBackend
+{
+	EncoderSettings m_Settings{};
+
+	// a file, or a live connection another process can watch while recording
+	std::unique_ptr<OutputSink> m_Sink = nullptr;
+
+	std::unique_ptr<Y4MSegmentEncoder> m_Encoder = nullptr;
+	EncodedPacket m_Packet{};
+
+	// kept from the file once it is closed
+	WriteStats m_WriteStats{};
+	bool m_HasWriteStats = false;
+
+	unsigned long long m_BytesOutput = 0;
+
+	// raw mode skips the stream and frame headers, leaving bare I420 planes
+	bool m_Raw = false;
+
+public:
+	explicit Y4MEncoderBackend(const bool& raw) : m_Raw(raw) {}
+	~Y4MEncoderBackend() override;
+
+	int Open(const EncoderSettings& settings) override;
+	bool WriteFrame(const void* frameData, const long long& timestamp, const long long& duration) override;
+	bool Finalize() override;
+	void Close() override;
+
+	const char* GetName() const override { return m_Raw ? "Raw I420" : "Y4M"; }
+
+	bool IsLive() const override { return m_Sink != nullptr && m_Sink->IsLive(); }
+
+	bool SupportsSegments() const override { return true; }
+	std::unique_ptr<SegmentEncoder> CreateSegmentEncoder() const override;
+	bool WritePacket(const EncodedPacket& packet) override;
+
+	unsigned long long GetBytesOutput() const override { return m_BytesOutput; }
+	bool GetWriteStats(WriteStats& stats) const override;
+};
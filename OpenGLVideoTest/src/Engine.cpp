@@ -6,7 +6,7 @@
 
 int Engine::Start()
 {
-	m_GraphicsModule = std::make_shared<Graphics>(Graphics());
+	m_GraphicsModule = std::make_shared<Graphics>(Graphics(m_Options));
 
 	if (m_GraphicsModule != nullptr)
 	{
@@ -40,6 +40,13 @@ int Engine::Tick()
 
 	m_FrameCount++;
 
+	if (m_Options.m_MaxFrames > 0 && m_FrameCount >= m_Options.m_MaxFrames)
+	{
+		std::cout << "Engine - Frame limit of " << m_Options.m_MaxFrames << " reached." << std::endl;
+
+		return 1;
+	}
+
 	return 0;
 }
 
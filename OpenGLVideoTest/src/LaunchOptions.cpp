@@ -0,0 +1,144 @@
+#include <LaunchOptions.h>
+#include <Modules/Graphics/EncoderBackend.h>
+#include <Modules/Graphics/OutputSink.h>
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+
+bool LaunchOptions::Parse(const int& argc, char** argv)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+		if (std::strcmp(arg, "--headless") == 0)
+		{
+			m_Headless = true;
+		}
+		else if (std::strcmp(arg, "--software") == 0)
+		{
+			m_SoftwareContext = true;
+		}
+		else if (std::strcmp(arg, "--offline") == 0)
+		{
+			m_Offline = true;
+		}
+		else if (std::strcmp(arg, "--record") == 0 && value != nullptr)
+		{
+			m_RecordName = value;
+			++i;
+		}
+		else if (std::strcmp(arg, "--live") == 0 && value != nullptr)
+		{
+			m_LiveTarget = value;
+			++i;
+		}
+		else if (std::strcmp(arg, "--fps") == 0 && value != nullptr)
+		{
+			m_RecordFPS = std::atoi(value);
+			++i;
+		}
+		else if (std::strcmp(arg, "--time") == 0 && value != nullptr)
+		{
+			m_RecordTime = std::atoi(value);
+			++i;
+		}
+		else if (std::strcmp(arg, "--frames") == 0 && value != nullptr)
+		{
+			m_MaxFrames = std::atoi(value);
+			++i;
+		}
+		else if (std::strcmp(arg, "--decode") == 0 && value != nullptr && i + 2 < argc)
+		{
+			m_DecodeInput = value;
+			m_DecodeOutput = argv[i + 2];
+			i += 2;
+		}
+		else if (std::strcmp(arg, "--encoder") == 0 && value != nullptr)
+		{
+			if (std::strcmp(value, "mf") == 0)
+				m_Encoder = (int)EncoderType::MediaFoundation;
+			else if (std::strcmp(value, "y4m") == 0)
+				m_Encoder = (int)EncoderType::Y4M;
+			else if (std::strcmp(value, "raw") == 0)
+				m_Encoder = (int)EncoderType::RawI420;
+			else if (std::strcmp(value, "mjpeg") == 0)
+				m_Encoder = (int)EncoderType::MJPEG;
+			else if (std::strcmp(value, "screen") == 0)
+				m_Encoder = (int)EncoderType::Screen;
+			else
+			{
+				std::cout << "Unknown encoder '" << value << "'!" << std::endl;
+
+				return false;
+			}
+
+			++i;
+		}
+		else
+		{
+			std::cout << "Unknown argument '" << arg << "'!" << std::endl;
+
+			PrintUsage();
+
+			return false;
+		}
+	}
+
+	if (!m_DecodeInput.empty())
+	{
+		if (m_Encoder == -1)
+			m_Encoder = (int)EncoderType::Y4M;
+
+		if (OutputSink::IsLiveTarget(m_DecodeOutput) || m_Encoder == (int)EncoderType::Screen)
+		{
+			std::cout << "Decode output '" << m_DecodeOutput << "' should be a file for an encoder other than screen!" << std::endl;
+
+			return false;
+		}
+
+		return true;
+	}
+
+	if (!m_LiveTarget.empty())
+	{
+		if (!OutputSink::IsLiveTarget(m_LiveTarget))
+		{
+			std::cout << "Live target '" << m_LiveTarget << "' should be tcp://<port>, pipe://<name> or unix://<path>!" << std::endl;
+
+			return false;
+		}
+
+		// a live stream still needs a name for the status text
+		if (m_RecordName.empty())
+			m_RecordName = "live";
+	}
+
+	if (m_RecordName.size() > 15)
+	{
+		// same limit as the file name box in the Render To File popup
+		std::cout << "Recording name '" << m_RecordName << "' is too long, 15 characters at most!" << std::endl;
+
+		return false;
+	}
+
+	return true;
+}
+
+void LaunchOptions::PrintUsage()
+{
+	std::cout << "Usage: OpenGLVideoTest [options]" << std::endl;
+	std::cout << "  --headless         hidden window, UI is rendered and captured offscreen" << std::endl;
+	std::cout << "                     still needs a display off Windows, e.g. run under 'xvfb-run -a'" << std::endl;
+	std::cout << "  --software         use an OSMesa software GL context" << std::endl;
+	std::cout << "  --record <name>    start recording 'Videos/<name>' at once and close when saved" << std::endl;
+	std::cout << "  --fps <n>          recording frame rate" << std::endl;
+	std::cout << "  --time <seconds>   recording length" << std::endl;
+	std::cout << "  --encoder <type>   mf, y4m, raw, mjpeg or screen" << std::endl;
+	std::cout << "  --live <target>    stream to tcp://<port>, pipe://<name> or unix://<path> rather than a file" << std::endl;
+	std::cout << "  --offline          record on a fixed time step, as fast as frames can be made" << std::endl;
+	std::cout << "  --frames <n>       close after n frames" << std::endl;
+	std::cout << "  --decode <in> <out> convert a .glsc recording with --encoder (y4m by default) and exit" << std::endl;
+}
@@ -0,0 +1,37 @@
+#include <Modules/Graphics/CaptureScheduler.h>
+
+#include <cmath>
+
+void CaptureScheduler::Reset(const double& startTime, const int& fps)
+{
+	m_StartTime = startTime;
+	m_SlotDuration = 1.0 / (fps > 0 ? fps : 1);
+
+	m_NextSlot = 0;
+	m_FramesScheduled = 0;
+	m_MaxSlotsPerFrame = 0;
+}
+
+unsigned int CaptureScheduler::Advance(const double& time)
+{
+	if (time < m_StartTime)
+		return 0;
+
+	// slot times are worked out from the start each time rather than summed, so they don't drift over long recordings
+	const unsigned long long due = (unsigned long long)std::floor((time - m_StartTime) / m_SlotDuration) + 1;
+
+	if (due <= m_NextSlot)
+		return 0;
+
+	const unsigned int slots = (unsigned int)(due - m_NextSlot);
+
+	m_NextSlot = due;
+	++m_FramesScheduled;
+
+	if (slots > m_MaxSlotsPerFrame)
+	{
+		m_MaxSlotsPerFrame = slots;
+	}
+
+	return slots;
+}
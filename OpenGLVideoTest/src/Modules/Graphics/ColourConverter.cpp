@@ -0,0 +1,478 @@
+#include <Modules/Graphics/ColourConverter.h>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define COLOUR_CONVERT_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC lets us use AVX2 intrinsics anywhere, GCC and Clang need the functions marked
+#if defined(COLOUR_CONVERT_X86) && (defined(__GNUC__) || defined(__clang__))
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define AVX2_TARGET
+#endif
+
+namespace
+{
+	const int YOffset = (16 << 15) + (1 << 14);
+	const int UVOffset = (128 << 17) + (1 << 16);
+
+	int16_t ToQ15(const double& value)
+	{
+		return (int16_t)std::lround(value * 32768.0);
+	}
+
+	inline uint8_t ClampByte(const int& value)
+	{
+		return (uint8_t)std::clamp(value, 0, 255);
+	}
+
+	inline uint8_t Luma(const uint8_t* px, const int16_t* coeffs)
+	{
+		return ClampByte((coeffs[0] * px[0] + coeffs[1] * px[1] + coeffs[2] * px[2] + YOffset) >> 15);
+	}
+
+	// sums are of four pixels, so shift two further than luma
+	inline uint8_t Chroma(const int& sumB, const int& sumG, const int& sumR, const int16_t* coeffs)
+	{
+		return ClampByte((coeffs[0] * sumB + coeffs[1] * sumG + coeffs[2] * sumR + UVOffset) >> 17);
+	}
+}
+
+ColourConverter::ColourConverter(const int& width, const int& height, const Format& format, const Matrix& matrix) : m_Width(width), m_Height(height), m_Format(format), m_Matrix(matrix)
+{
+	const double kr = matrix == Matrix::BT709 ? 0.2126 : 0.299;
+	const double kb = matrix == Matrix::BT709 ? 0.0722 : 0.114;
+	const double kg = 1.0 - kr - kb;
+
+	// limited (studio) range, luma spans 16-235 and chroma 16-240
+	const double yScale = 219.0 / 255.0;
+	const double cScale = 224.0 / 255.0 / 2.0;
+
+	m_YCoeffs[0] = ToQ15(kb * yScale);
+	m_YCoeffs[1] = ToQ15(kg * yScale);
+	m_YCoeffs[2] = ToQ15(kr * yScale);
+
+	m_UCoeffs[0] = ToQ15(cScale);
+	m_UCoeffs[1] = ToQ15(-cScale * kg / (1.0 - kb));
+	m_UCoeffs[2] = ToQ15(-cScale * kr / (1.0 - kb));
+
+	m_VCoeffs[0] = ToQ15(-cScale * kb / (1.0 - kr));
+	m_VCoeffs[1] = ToQ15(-cScale * kg / (1.0 - kr));
+	m_VCoeffs[2] = ToQ15(cScale);
+
+	m_Path = GetBestPath();
+}
+
+size_t ColourConverter::GetOutputSize() const
+{
+	const size_t chromaWidth = (m_Width + 1) / 2;
+	const size_t chromaHeight = (m_Height + 1) / 2;
+
+	return (size_t)m_Width * m_Height + chromaWidth * chromaHeight * 2;
+}
+
+ColourConverter::RowPair ColourConverter::GetRowPair(const void* bgra, uint8_t* dst, const int& pair, const bool& flip) const
+{
+	const size_t srcStride = (size_t)m_Width * 4;
+	const size_t chromaWidth = (m_Width + 1) / 2;
+	const size_t chromaHeight = (m_Height + 1) / 2;
+
+	const int row0 = pair * 2;
+	const int row1 = std::min(row0 + 1, m_Height - 1);
+
+	// GL hands us the bottom row first
+	const int srcRow0 = flip ? m_Height - 1 - row0 : row0;
+	const int srcRow1 = flip ? m_Height - 1 - row1 : row1;
+
+	RowPair rows{};
+	rows.m_Src0 = (const uint8_t*)bgra + srcRow0 * srcStride;
+	rows.m_Src1 = (const uint8_t*)bgra + srcRow1 * srcStride;
+	rows.m_Y0 = dst + (size_t)row0 * m_Width;
+	rows.m_Y1 = row1 != row0 ? dst + (size_t)row1 * m_Width : nullptr;
+
+	uint8_t* chroma = dst + (size_t)m_Width * m_Height;
+
+	if (m_Format == Format::NV12)
+	{
+		rows.m_U = chroma + pair * chromaWidth * 2;
+		rows.m_V = nullptr;
+	}
+	else
+	{
+		rows.m_U = chroma + pair * chromaWidth;
+		rows.m_V = chroma + chromaWidth * chromaHeight + pair * chromaWidth;
+	}
+
+	return rows;
+}
+
+void ColourConverter::Convert(const void* bgra, uint8_t* dst, const bool& flip) const
+{
+	ConvertRows(bgra, dst, flip, 0, GetRowPairCount());
+}
+
+void ColourConverter::ConvertRows(const void* bgra, uint8_t* dst, const bool& flip, const int& firstPair, const int& endPair) const
+{
+	const int lastPair = std::min(endPair, GetRowPairCount());
+
+	for (int pair = std::max(firstPair, 0); pair < lastPair; ++pair)
+	{
+		const RowPair rows = GetRowPair(bgra, dst, pair, flip);
+
+		int x = 0;
+
+		switch (m_Path)
+		{
+		case Path::AVX2:
+			x = ConvertAVX2(rows);
+			break;
+		case Path::SSE2:
+			x = ConvertSSE2(rows);
+			break;
+		default:
+			break;
+		}
+
+		// whatever the vector path could not cover
+		ConvertScalar(rows, x);
+	}
+}
+
+void ColourConverter::ConvertScalar(const RowPair& rows, const int& startX) const
+{
+	for (int x = startX; x < m_Width; x += 2)
+	{
+		const int x1 = std::min(x + 1, m_Width - 1);
+
+		const uint8_t* p00 = rows.m_Src0 + x * 4;
+		const uint8_t* p01 = rows.m_Src0 + x1 * 4;
+		const uint8_t* p10 = rows.m_Src1 + x * 4;
+		const uint8_t* p11 = rows.m_Src1 + x1 * 4;
+
+		rows.m_Y0[x] = Luma(p00, m_YCoeffs);
+
+		if (x1 != x)
+			rows.m_Y0[x1] = Luma(p01, m_YCoeffs);
+
+		if (rows.m_Y1 != nullptr)
+		{
+			rows.m_Y1[x] = Luma(p10, m_YCoeffs);
+
+			if (x1 != x)
+				rows.m_Y1[x1] = Luma(p11, m_YCoeffs);
+		}
+
+		const int sumB = p00[0] + p01[0] + p10[0] + p11[0];
+		const int sumG = p00[1] + p01[1] + p10[1] + p11[1];
+		const int sumR = p00[2] + p01[2] + p10[2] + p11[2];
+
+		const int cx = x / 2;
+
+		if (m_Format == Format::NV12)
+		{
+			rows.m_U[cx * 2] = Chroma(sumB, sumG, sumR, m_UCoeffs);
+			rows.m_U[cx * 2 + 1] = Chroma(sumB, sumG, sumR, m_VCoeffs);
+		}
+		else
+		{
+			rows.m_U[cx] = Chroma(sumB, sumG, sumR, m_UCoeffs);
+			rows.m_V[cx] = Chroma(sumB, sumG, sumR, m_VCoeffs);
+		}
+	}
+}
+
+#ifdef COLOUR_CONVERT_X86
+
+namespace
+{
+	// eight BGRA pixels to three vectors of eight 16 bit channel values
+	inline void Deinterleave8(const uint8_t* src, __m128i& b, __m128i& g, __m128i& r)
+	{
+		const __m128i mask = _mm_set1_epi32(0xFF);
+
+		const __m128i px0 = _mm_loadu_si128((const __m128i*)src);
+		const __m128i px1 = _mm_loadu_si128((const __m128i*)(src + 16));
+
+		b = _mm_packs_epi32(_mm_and_si128(px0, mask), _mm_and_si128(px1, mask));
+		g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(px0, 8), mask), _mm_and_si128(_mm_srli_epi32(px1, 8), mask));
+		r = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(px0, 16), mask), _mm_and_si128(_mm_srli_epi32(px1, 16), mask));
+	}
+
+	// (b * cb + g * cg + r * cr + offset) >> shift on eight 16 bit lanes
+	inline __m128i Weigh8(const __m128i& b, const __m128i& g, const __m128i& r, const __m128i& cbg, const __m128i& cr, const __m128i& offset, const int& shift)
+	{
+		const __m128i zero = _mm_setzero_si128();
+
+		__m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(b, g), cbg), _mm_madd_epi16(_mm_unpacklo_epi16(r, zero), cr));
+		__m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(b, g), cbg), _mm_madd_epi16(_mm_unpackhi_epi16(r, zero), cr));
+
+		lo = _mm_sra_epi32(_mm_add_epi32(lo, offset), _mm_cvtsi32_si128(shift));
+		hi = _mm_sra_epi32(_mm_add_epi32(hi, offset), _mm_cvtsi32_si128(shift));
+
+		return _mm_packs_epi32(lo, hi);
+	}
+
+	inline __m128i PairCoeffs(const int16_t& first, const int16_t& second)
+	{
+		return _mm_set1_epi32((int)(((uint32_t)(uint16_t)second << 16) | (uint16_t)first));
+	}
+
+	AVX2_TARGET inline void Deinterleave16(const uint8_t* src, __m256i& b, __m256i& g, __m256i& r)
+	{
+		const __m256i mask = _mm256_set1_epi32(0xFF);
+
+		const __m256i px0 = _mm256_loadu_si256((const __m256i*)src);
+		const __m256i px1 = _mm256_loadu_si256((const __m256i*)(src + 32));
+
+		// lanes end up as pixels [0-3, 8-11 | 4-7, 12-15], put back in order once packed to bytes
+		b = _mm256_packs_epi32(_mm256_and_si256(px0, mask), _mm256_and_si256(px1, mask));
+		g = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(px0, 8), mask), _mm256_and_si256(_mm256_srli_epi32(px1, 8), mask));
+		r = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(px0, 16), mask), _mm256_and_si256(_mm256_srli_epi32(px1, 16), mask));
+	}
+
+	AVX2_TARGET inline __m256i Weigh16(const __m256i& b, const __m256i& g, const __m256i& r, const __m256i& cbg, const __m256i& cr, const __m256i& offset, const int& shift)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+
+		__m256i lo = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(b, g), cbg), _mm256_madd_epi16(_mm256_unpacklo_epi16(r, zero), cr));
+		__m256i hi = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(b, g), cbg), _mm256_madd_epi16(_mm256_unpackhi_epi16(r, zero), cr));
+
+		lo = _mm256_sra_epi32(_mm256_add_epi32(lo, offset), _mm_cvtsi32_si128(shift));
+		hi = _mm256_sra_epi32(_mm256_add_epi32(hi, offset), _mm_cvtsi32_si128(shift));
+
+		return _mm256_packs_epi32(lo, hi);
+	}
+
+	AVX2_TARGET inline __m256i PairCoeffs256(const int16_t& first, const int16_t& second)
+	{
+		return _mm256_set1_epi32((int)(((uint32_t)(uint16_t)second << 16) | (uint16_t)first));
+	}
+}
+
+int ColourConverter::ConvertSSE2(const RowPair& rows) const
+{
+	const __m128i ones = _mm_set1_epi16(1);
+	const __m128i byteMax = _mm_set1_epi16(255);
+	const __m128i zero = _mm_setzero_si128();
+
+	const __m128i yBG = PairCoeffs(m_YCoeffs[0], m_YCoeffs[1]);
+	const __m128i yR = PairCoeffs(m_YCoeffs[2], 0);
+	const __m128i uBG = PairCoeffs(m_UCoeffs[0], m_UCoeffs[1]);
+	const __m128i uR = PairCoeffs(m_UCoeffs[2], 0);
+	const __m128i vBG = PairCoeffs(m_VCoeffs[0], m_VCoeffs[1]);
+	const __m128i vR = PairCoeffs(m_VCoeffs[2], 0);
+
+	const __m128i yOffset = _mm_set1_epi32(YOffset);
+	const __m128i uvOffset = _mm_set1_epi32(UVOffset);
+
+	int x = 0;
+
+	for (; x + 16 <= m_Width; x += 16)
+	{
+		__m128i b00, g00, r00, b01, g01, r01;
+		__m128i b10, g10, r10, b11, g11, r11;
+
+		Deinterleave8(rows.m_Src0 + x * 4, b00, g00, r00);
+		Deinterleave8(rows.m_Src0 + x * 4 + 32, b01, g01, r01);
+		Deinterleave8(rows.m_Src1 + x * 4, b10, g10, r10);
+		Deinterleave8(rows.m_Src1 + x * 4 + 32, b11, g11, r11);
+
+		const __m128i y0 = _mm_packus_epi16(Weigh8(b00, g00, r00, yBG, yR, yOffset, 15), Weigh8(b01, g01, r01, yBG, yR, yOffset, 15));
+		_mm_storeu_si128((__m128i*)(rows.m_Y0 + x), y0);
+
+		if (rows.m_Y1 != nullptr)
+		{
+			const __m128i y1 = _mm_packus_epi16(Weigh8(b10, g10, r10, yBG, yR, yOffset, 15), Weigh8(b11, g11, r11, yBG, yR, yOffset, 15));
+			_mm_storeu_si128((__m128i*)(rows.m_Y1 + x), y1);
+		}
+
+		// 2x2 sums, horizontal pairs with madd then the row below
+		const __m128i sumB = _mm_packs_epi32(_mm_add_epi32(_mm_madd_epi16(b00, ones), _mm_madd_epi16(b10, ones)), _mm_add_epi32(_mm_madd_epi16(b01, ones), _mm_madd_epi16(b11, ones)));
+		const __m128i sumG = _mm_packs_epi32(_mm_add_epi32(_mm_madd_epi16(g00, ones), _mm_madd_epi16(g10, ones)), _mm_add_epi32(_mm_madd_epi16(g01, ones), _mm_madd_epi16(g11, ones)));
+		const __m128i sumR = _mm_packs_epi32(_mm_add_epi32(_mm_madd_epi16(r00, ones), _mm_madd_epi16(r10, ones)), _mm_add_epi32(_mm_madd_epi16(r01, ones), _mm_madd_epi16(r11, ones)));
+
+		const __m128i u = _mm_max_epi16(_mm_min_epi16(Weigh8(sumB, sumG, sumR, uBG, uR, uvOffset, 17), byteMax), zero);
+		const __m128i v = _mm_max_epi16(_mm_min_epi16(Weigh8(sumB, sumG, sumR, vBG, vR, uvOffset, 17), byteMax), zero);
+
+		if (m_Format == Format::NV12)
+		{
+			_mm_storeu_si128((__m128i*)(rows.m_U + x), _mm_or_si128(u, _mm_slli_epi16(v, 8)));
+		}
+		else
+		{
+			const __m128i uv = _mm_packus_epi16(u, v);
+
+			_mm_storel_epi64((__m128i*)(rows.m_U + x / 2), uv);
+			_mm_storel_epi64((__m128i*)(rows.m_V + x / 2), _mm_srli_si128(uv, 8));
+		}
+	}
+
+	return x;
+}
+
+AVX2_TARGET int ColourConverter::ConvertAVX2(const RowPair& rows) const
+{
+	const __m256i ones = _mm256_set1_epi16(1);
+	const __m256i byteMax = _mm256_set1_epi16(255);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+	const __m256i yBG = PairCoeffs256(m_YCoeffs[0], m_YCoeffs[1]);
+	const __m256i yR = PairCoeffs256(m_YCoeffs[2], 0);
+	const __m256i uBG = PairCoeffs256(m_UCoeffs[0], m_UCoeffs[1]);
+	const __m256i uR = PairCoeffs256(m_UCoeffs[2], 0);
+	const __m256i vBG = PairCoeffs256(m_VCoeffs[0], m_VCoeffs[1]);
+	const __m256i vR = PairCoeffs256(m_VCoeffs[2], 0);
+
+	const __m256i yOffset = _mm256_set1_epi32(YOffset);
+	const __m256i uvOffset = _mm256_set1_epi32(UVOffset);
+
+	int x = 0;
+
+	for (; x + 32 <= m_Width; x += 32)
+	{
+		__m256i b00, g00, r00, b01, g01, r01;
+		__m256i b10, g10, r10, b11, g11, r11;
+
+		Deinterleave16(rows.m_Src0 + x * 4, b00, g00, r00);
+		Deinterleave16(rows.m_Src0 + x * 4 + 64, b01, g01, r01);
+		Deinterleave16(rows.m_Src1 + x * 4, b10, g10, r10);
+		Deinterleave16(rows.m_Src1 + x * 4 + 64, b11, g11, r11);
+
+		const __m256i y0 = _mm256_packus_epi16(Weigh16(b00, g00, r00, yBG, yR, yOffset, 15), Weigh16(b01, g01, r01, yBG, yR, yOffset, 15));
+		_mm256_storeu_si256((__m256i*)(rows.m_Y0 + x), _mm256_permutevar8x32_epi32(y0, order));
+
+		if (rows.m_Y1 != nullptr)
+		{
+			const __m256i y1 = _mm256_packus_epi16(Weigh16(b10, g10, r10, yBG, yR, yOffset, 15), Weigh16(b11, g11, r11, yBG, yR, yOffset, 15));
+			_mm256_storeu_si256((__m256i*)(rows.m_Y1 + x), _mm256_permutevar8x32_epi32(y1, order));
+		}
+
+		const __m256i sumB = _mm256_packs_epi32(_mm256_add_epi32(_mm256_madd_epi16(b00, ones), _mm256_madd_epi16(b10, ones)), _mm256_add_epi32(_mm256_madd_epi16(b01, ones), _mm256_madd_epi16(b11, ones)));
+		const __m256i sumG = _mm256_packs_epi32(_mm256_add_epi32(_mm256_madd_epi16(g00, ones), _mm256_madd_epi16(g10, ones)), _mm256_add_epi32(_mm256_madd_epi16(g01, ones), _mm256_madd_epi16(g11, ones)));
+		const __m256i sumR = _mm256_packs_epi32(_mm256_add_epi32(_mm256_madd_epi16(r00, ones), _mm256_madd_epi16(r10, ones)), _mm256_add_epi32(_mm256_madd_epi16(r01, ones), _mm256_madd_epi16(r11, ones)));
+
+		__m256i u = Weigh16(sumB, sumG, sumR, uBG, uR, uvOffset, 17);
+		__m256i v = Weigh16(sumB, sumG, sumR, vBG, vR, uvOffset, 17);
+
+		u = _mm256_max_epi16(_mm256_min_epi16(_mm256_permutevar8x32_epi32(u, order), byteMax), zero);
+		v = _mm256_max_epi16(_mm256_min_epi16(_mm256_permutevar8x32_epi32(v, order), byteMax), zero);
+
+		if (m_Format == Format::NV12)
+		{
+			_mm256_storeu_si256((__m256i*)(rows.m_U + x), _mm256_or_si256(u, _mm256_slli_epi16(v, 8)));
+		}
+		else
+		{
+			// [u 0-7, v 0-7 | u 8-15, v 8-15] to [u 0-15 | v 0-15]
+			const __m256i uv = _mm256_permute4x64_epi64(_mm256_packus_epi16(u, v), 0xD8);
+
+			_mm_storeu_si128((__m128i*)(rows.m_U + x / 2), _mm256_castsi256_si128(uv));
+			_mm_storeu_si128((__m128i*)(rows.m_V + x / 2), _mm256_extracti128_si256(uv, 1));
+		}
+	}
+
+	return x;
+}
+
+#else
+
+int ColourConverter::ConvertSSE2(const RowPair& rows) const
+{
+	return 0;
+}
+
+int ColourConverter::ConvertAVX2(const RowPair& rows) const
+{
+	return 0;
+}
+
+#endif
+
+bool ColourConverter::SetPath(const Path& path)
+{
+	if (!IsPathSupported(path))
+		return false;
+
+	m_Path = path;
+
+	return true;
+}
+
+bool ColourConverter::IsPathSupported(const Path& path)
+{
+	switch (path)
+	{
+	case Path::Scalar:
+		return true;
+#ifdef COLOUR_CONVERT_X86
+	case Path::SSE2:
+		return true;
+	case Path::AVX2:
+	{
+#ifdef _MSC_VER
+		int info[4]{};
+
+		__cpuid(info, 0);
+
+		if (info[0] < 7)
+			return false;
+
+		// AVX needs OS support for saving the ymm registers as well as the CPU flag
+		__cpuid(info, 1);
+
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+
+		if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+			return false;
+
+		__cpuidex(info, 7, 0);
+
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+#endif
+	default:
+		return false;
+	}
+}
+
+ColourConverter::Path ColourConverter::GetBestPath()
+{
+	static const Path best = IsPathSupported(Path::AVX2) ? Path::AVX2 : IsPathSupported(Path::SSE2) ? Path::SSE2 : Path::Scalar;
+
+	return best;
+}
+
+const char* ColourConverter::GetPathName(const Path& path)
+{
+	switch (path)
+	{
+	case Path::SSE2:
+		return "SSE2";
+	case Path::AVX2:
+		return "AVX2";
+	default:
+		return "Scalar";
+	}
+}
+
+const char* ColourConverter::GetFormatName(const Format& format)
+{
+	return format == Format::NV12 ? "NV12" : "I420";
+}
+
+const char* ColourConverter::GetMatrixName(const Matrix& matrix)
+{
+	return matrix == Matrix::BT709 ? "BT.709" : "BT.601";
+}
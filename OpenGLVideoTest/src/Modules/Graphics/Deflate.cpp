@@ -0,0 +1,634 @@
+#include <Modules/Graphics/Deflate.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	const size_t MinMatch = 3;
+	const size_t MaxMatch = 258;
+	const size_t WindowMask = Deflate::WindowSize - 1;
+
+	const int HashBits = 15;
+
+	// a block's table costs around a hundred bytes, this keeps that small next to what it codes
+	const size_t BlockSymbols = 32768;
+
+	const int LengthCodes = 29;
+	const int LiteralCodes = 286;
+	const int DistanceCodes = 30;
+	const int CodeLengthCodes = 19;
+
+	const uint16_t LengthBase[LengthCodes] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const uint8_t LengthExtra[LengthCodes] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+
+	const uint16_t DistanceBase[DistanceCodes] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const uint8_t DistanceExtra[DistanceCodes] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	const uint8_t CodeLengthOrder[CodeLengthCodes] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	// match length and distance to their codes, distances past 256 share an entry per 128 as every code there covers a multiple of 128
+	struct CodeTables
+	{
+		uint8_t m_Length[MaxMatch + 1]{};
+		uint8_t m_Distance[512]{};
+		uint32_t m_Crc[256]{};
+
+		CodeTables()
+		{
+			for (int code = 0; code < LengthCodes; ++code)
+			{
+				for (int length = LengthBase[code]; length < LengthBase[code] + (1 << LengthExtra[code]) && length <= (int)MaxMatch; ++length)
+				{
+					m_Length[length] = (uint8_t)code;
+				}
+			}
+
+			for (int code = 0; code < DistanceCodes; ++code)
+			{
+				for (int distance = DistanceBase[code]; distance < DistanceBase[code] + (1 << DistanceExtra[code]); ++distance)
+				{
+					const int index = distance - 1;
+
+					m_Distance[index < 256 ? index : 256 + (index >> 7)] = (uint8_t)code;
+				}
+			}
+
+			for (uint32_t i = 0; i < 256; ++i)
+			{
+				uint32_t crc = i;
+
+				for (int bit = 0; bit < 8; ++bit)
+				{
+					crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+				}
+
+				m_Crc[i] = crc;
+			}
+		}
+
+		inline int DistanceCode(const uint32_t& distance) const
+		{
+			const uint32_t index = distance - 1;
+
+			return m_Distance[index < 256 ? index : 256 + (index >> 7)];
+		}
+	};
+
+	const CodeTables Tables;
+
+	// deflate packs bits from the least significant end
+	struct BitWriter
+	{
+		std::vector<uint8_t>& m_Out;
+		uint64_t m_Bits = 0;
+		int m_Count = 0;
+
+		inline void Put(const uint32_t& value, const int& count)
+		{
+			m_Bits |= (uint64_t)value << m_Count;
+			m_Count += count;
+
+			while (m_Count >= 8)
+			{
+				m_Out.push_back((uint8_t)m_Bits);
+				m_Bits >>= 8;
+				m_Count -= 8;
+			}
+		}
+
+		inline void Align()
+		{
+			if (m_Count > 0)
+			{
+				m_Out.push_back((uint8_t)m_Bits);
+			}
+
+			m_Bits = 0;
+			m_Count = 0;
+		}
+	};
+
+	inline uint32_t Hash(const uint8_t* data)
+	{
+		const uint32_t bytes = (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16);
+
+		return (bytes * 2654435761u) >> (32 - HashBits);
+	}
+
+	// huffman code lengths no longer than maxBits, rare symbols are made less rare until the tree is shallow enough
+	void BuildLengths(const uint32_t* frequencies, const int& count, const int& maxBits, uint8_t* lengths)
+	{
+		std::vector<uint32_t> scaled(frequencies, frequencies + count);
+
+		while (true)
+		{
+			std::fill(lengths, lengths + count, (uint8_t)0);
+
+			std::vector<std::pair<uint32_t, int>> leaves;
+
+			for (int i = 0; i < count; ++i)
+			{
+				if (scaled[i] > 0)
+					leaves.push_back({ scaled[i], i });
+			}
+
+			if (leaves.empty())
+				return;
+
+			if (leaves.size() == 1)
+			{
+				// a lone code still needs a partner for the code to be complete
+				lengths[leaves[0].second] = 1;
+				lengths[leaves[0].second == 0 ? 1 : 0] = 1;
+
+				return;
+			}
+
+			std::sort(leaves.begin(), leaves.end());
+
+			// leaves and merged nodes both come out in weight order, so two queues stand in for a heap
+			const int leafCount = (int)leaves.size();
+			const int nodeCount = leafCount * 2 - 1;
+
+			std::vector<uint64_t> weight(nodeCount);
+			std::vector<int> parent(nodeCount, -1);
+
+			for (int i = 0; i < leafCount; ++i)
+			{
+				weight[i] = leaves[i].first;
+			}
+
+			int nextLeaf = 0;
+			int nextNode = leafCount;
+
+			for (int created = leafCount; created < nodeCount; ++created)
+			{
+				int pair[2];
+
+				for (int& pick : pair)
+				{
+					if (nextLeaf < leafCount && (nextNode >= created || weight[nextLeaf] <= weight[nextNode]))
+						pick = nextLeaf++;
+					else
+						pick = nextNode++;
+				}
+
+				weight[created] = weight[pair[0]] + weight[pair[1]];
+				parent[pair[0]] = created;
+				parent[pair[1]] = created;
+			}
+
+			// parents always come after their children, so one pass down from the root finds every depth
+			std::vector<int> depth(nodeCount, 0);
+			int deepest = 0;
+
+			for (int i = nodeCount - 2; i >= 0; --i)
+			{
+				depth[i] = depth[parent[i]] + 1;
+			}
+
+			for (int i = 0; i < leafCount; ++i)
+			{
+				lengths[leaves[i].second] = (uint8_t)depth[i];
+				deepest = std::max(deepest, depth[i]);
+			}
+
+			if (deepest <= maxBits)
+				return;
+
+			for (uint32_t& frequency : scaled)
+			{
+				if (frequency > 0)
+					frequency = (frequency + 1) / 2;
+			}
+		}
+	}
+
+	// canonical codes, bit reversed so they can be written least significant bit first
+	void BuildCodes(const uint8_t* lengths, const int& count, uint16_t* codes)
+	{
+		int lengthCount[16]{};
+
+		for (int i = 0; i < count; ++i)
+		{
+			lengthCount[lengths[i]]++;
+		}
+
+		lengthCount[0] = 0;
+
+		int nextCode[16]{};
+		int code = 0;
+
+		for (int bits = 1; bits < 16; ++bits)
+		{
+			code = (code + lengthCount[bits - 1]) << 1;
+			nextCode[bits] = code;
+		}
+
+		for (int i = 0; i < count; ++i)
+		{
+			const int length = lengths[i];
+
+			if (length == 0)
+			{
+				codes[i] = 0;
+
+				continue;
+			}
+
+			const int value = nextCode[length]++;
+			int reversed = 0;
+
+			for (int bit = 0; bit < length; ++bit)
+			{
+				reversed |= ((value >> bit) & 1) << (length - 1 - bit);
+			}
+
+			codes[i] = (uint16_t)reversed;
+		}
+	}
+
+	void WriteStored(BitWriter& bits, const uint8_t* data, const size_t& size)
+	{
+		size_t offset = 0;
+
+		do
+		{
+			const size_t chunk = std::min<size_t>(size - offset, 65535);
+
+			bits.Put(0, 3);
+			bits.Align();
+			bits.Put((uint32_t)chunk, 16);
+			bits.Put((uint32_t)~chunk & 0xFFFF, 16);
+
+			bits.m_Out.insert(bits.m_Out.end(), data + offset, data + offset + chunk);
+
+			offset += chunk;
+		} while (offset < size);
+	}
+
+	// a dynamic huffman block, or stored if the data didn't compress
+	void WriteBlock(BitWriter& bits, const std::vector<uint32_t>& symbols, const uint8_t* data, const size_t& size)
+	{
+		uint32_t literalFrequencies[LiteralCodes]{};
+		uint32_t distanceFrequencies[DistanceCodes]{};
+
+		for (const uint32_t symbol : symbols)
+		{
+			const uint32_t distance = symbol >> 16;
+
+			if (distance == 0)
+			{
+				literalFrequencies[symbol & 0xFFFF]++;
+			}
+			else
+			{
+				literalFrequencies[257 + Tables.m_Length[symbol & 0xFFFF]]++;
+				distanceFrequencies[Tables.DistanceCode(distance)]++;
+			}
+		}
+
+		literalFrequencies[256] = 1;
+
+		uint8_t literalLengths[LiteralCodes];
+		uint8_t distanceLengths[DistanceCodes];
+
+		BuildLengths(literalFrequencies, LiteralCodes, 15, literalLengths);
+		BuildLengths(distanceFrequencies, DistanceCodes, 15, distanceLengths);
+
+		if (std::all_of(distanceLengths, distanceLengths + DistanceCodes, [](const uint8_t& length) { return length == 0; }))
+		{
+			distanceLengths[0] = 1;
+			distanceLengths[1] = 1;
+		}
+
+		int literalCount = LiteralCodes;
+		int distanceCount = DistanceCodes;
+
+		while (literalCount > 257 && literalLengths[literalCount - 1] == 0)
+			literalCount--;
+
+		while (distanceCount > 1 && distanceLengths[distanceCount - 1] == 0)
+			distanceCount--;
+
+		// both tables' lengths are sent as one run length coded list
+		std::vector<uint8_t> lengths(literalLengths, literalLengths + literalCount);
+		lengths.insert(lengths.end(), distanceLengths, distanceLengths + distanceCount);
+
+		std::vector<std::pair<uint8_t, uint8_t>> runs;
+		uint32_t codeLengthFrequencies[CodeLengthCodes]{};
+
+		for (size_t i = 0; i < lengths.size();)
+		{
+			const uint8_t length = lengths[i];
+			size_t run = 1;
+
+			while (i + run < lengths.size() && lengths[i + run] == length)
+				run++;
+
+			i += run;
+
+			if (length == 0)
+			{
+				while (run >= 11)
+				{
+					const size_t repeat = std::min<size_t>(run, 138);
+					runs.push_back({ 18, (uint8_t)(repeat - 11) });
+					run -= repeat;
+				}
+
+				if (run >= 3)
+				{
+					runs.push_back({ 17, (uint8_t)(run - 3) });
+					run = 0;
+				}
+			}
+			else
+			{
+				runs.push_back({ length, 0 });
+				run--;
+
+				while (run >= 3)
+				{
+					const size_t repeat = std::min<size_t>(run, 6);
+					runs.push_back({ 16, (uint8_t)(repeat - 3) });
+					run -= repeat;
+				}
+			}
+
+			for (; run > 0; --run)
+			{
+				runs.push_back({ length, 0 });
+			}
+		}
+
+		for (const std::pair<uint8_t, uint8_t>& run : runs)
+		{
+			codeLengthFrequencies[run.first]++;
+		}
+
+		uint8_t codeLengthLengths[CodeLengthCodes];
+		BuildLengths(codeLengthFrequencies, CodeLengthCodes, 7, codeLengthLengths);
+
+		int codeLengthCount = CodeLengthCodes;
+
+		while (codeLengthCount > 4 && codeLengthLengths[CodeLengthOrder[codeLengthCount - 1]] == 0)
+			codeLengthCount--;
+
+		const uint8_t runExtra[3] = { 2, 3, 7 };
+
+		// size in bits of both encodings, only kept if it beats the data stored as is
+		unsigned long long dynamicBits = 3 + 14 + 3 * codeLengthCount;
+
+		for (const std::pair<uint8_t, uint8_t>& run : runs)
+		{
+			dynamicBits += codeLengthLengths[run.first] + (run.first >= 16 ? runExtra[run.first - 16] : 0);
+		}
+
+		for (int i = 0; i < LiteralCodes; ++i)
+		{
+			dynamicBits += (unsigned long long)literalFrequencies[i] * (literalLengths[i] + (i > 256 ? LengthExtra[i - 257] : 0));
+		}
+
+		for (int i = 0; i < DistanceCodes; ++i)
+		{
+			dynamicBits += (unsigned long long)distanceFrequencies[i] * (distanceLengths[i] + DistanceExtra[i]);
+		}
+
+		const unsigned long long storedBits = (unsigned long long)size * 8 + (size / 65535 + 1) * 40;
+
+		if (storedBits <= dynamicBits)
+		{
+			WriteStored(bits, data, size);
+
+			return;
+		}
+
+		uint16_t literalCodes[LiteralCodes];
+		uint16_t distanceCodes[DistanceCodes];
+		uint16_t codeLengthCodes[CodeLengthCodes];
+
+		BuildCodes(literalLengths, LiteralCodes, literalCodes);
+		BuildCodes(distanceLengths, DistanceCodes, distanceCodes);
+		BuildCodes(codeLengthLengths, CodeLengthCodes, codeLengthCodes);
+
+		bits.Put(0, 1);
+		bits.Put(2, 2);
+		bits.Put(literalCount - 257, 5);
+		bits.Put(distanceCount - 1, 5);
+		bits.Put(codeLengthCount - 4, 4);
+
+		for (int i = 0; i < codeLengthCount; ++i)
+		{
+			bits.Put(codeLengthLengths[CodeLengthOrder[i]], 3);
+		}
+
+		for (const std::pair<uint8_t, uint8_t>& run : runs)
+		{
+			bits.Put(codeLengthCodes[run.first], codeLengthLengths[run.first]);
+
+			if (run.first >= 16)
+				bits.Put(run.second, runExtra[run.first - 16]);
+		}
+
+		for (const uint32_t symbol : symbols)
+		{
+			const uint32_t value = symbol & 0xFFFF;
+			const uint32_t distance = symbol >> 16;
+
+			if (distance == 0)
+			{
+				bits.Put(literalCodes[value], literalLengths[value]);
+
+				continue;
+			}
+
+			const int lengthCode = Tables.m_Length[value];
+			const int distanceCode = Tables.DistanceCode(distance);
+
+			bits.Put(literalCodes[257 + lengthCode], literalLengths[257 + lengthCode]);
+			bits.Put(value - LengthBase[lengthCode], LengthExtra[lengthCode]);
+			bits.Put(distanceCodes[distanceCode], distanceLengths[distanceCode]);
+			bits.Put(distance - DistanceBase[distanceCode], DistanceExtra[distanceCode]);
+		}
+
+		bits.Put(literalCodes[256], literalLengths[256]);
+	}
+}
+
+Deflate::Deflate(const int& level) :
+	m_Head(1 << HashBits),
+	m_Prev(WindowSize)
+{
+	const int chains[10] = { 1, 4, 8, 12, 16, 32, 64, 128, 512, 2048 };
+
+	m_MaxChain = chains[std::clamp(level, 1, 9)];
+}
+
+void Deflate::Compress(const uint8_t* data, const size_t& size, std::vector<uint8_t>& out, const bool& last)
+{
+	BitWriter bits{ out };
+
+	// chunks are independent, nothing from the last call may be matched against
+	std::fill(m_Head.begin(), m_Head.end(), -1);
+	m_Symbols.clear();
+
+	size_t blockStart = 0;
+	size_t pos = 0;
+
+	while (pos < size)
+	{
+		size_t bestLength = 0;
+		size_t bestDistance = 0;
+
+		if (pos + MinMatch <= size)
+		{
+			const uint32_t hash = Hash(data + pos);
+			const size_t maxLength = std::min(MaxMatch, size - pos);
+
+			int32_t candidate = m_Head[hash];
+			int chain = m_MaxChain;
+
+			while (candidate >= 0 && pos - candidate <= WindowSize && chain-- > 0)
+			{
+				const uint8_t* match = data + candidate;
+				const uint8_t* current = data + pos;
+
+				// only worth comparing if the byte that would make it the longest match agrees
+				if (match[bestLength] == current[bestLength])
+				{
+					size_t length = 0;
+
+					while (length < maxLength && match[length] == current[length])
+						length++;
+
+					if (length > bestLength)
+					{
+						bestLength = length;
+						bestDistance = pos - candidate;
+
+						if (length == maxLength)
+							break;
+					}
+				}
+
+				const int32_t next = m_Prev[candidate & WindowMask];
+
+				// anything at or after the candidate has been overwritten by a newer position
+				if (next >= candidate)
+					break;
+
+				candidate = next;
+			}
+
+			m_Prev[pos & WindowMask] = m_Head[hash];
+			m_Head[hash] = (int32_t)pos;
+		}
+
+		if (bestLength >= MinMatch)
+		{
+			m_Symbols.push_back((uint32_t)bestLength | ((uint32_t)bestDistance << 16));
+
+			// long matches are mostly runs of one colour, the positions inside them are rarely the best place to match from
+			if (bestLength <= 32)
+			{
+				for (size_t i = pos + 1; i < pos + bestLength && i + MinMatch <= size; ++i)
+				{
+					const uint32_t hash = Hash(data + i);
+
+					m_Prev[i & WindowMask] = m_Head[hash];
+					m_Head[hash] = (int32_t)i;
+				}
+			}
+
+			pos += bestLength;
+		}
+		else
+		{
+			m_Symbols.push_back(data[pos]);
+			pos++;
+		}
+
+		if (m_Symbols.size() >= BlockSymbols)
+		{
+			WriteBlock(bits, m_Symbols, data + blockStart, pos - blockStart);
+
+			blockStart = pos;
+			m_Symbols.clear();
+		}
+	}
+
+	if (!m_Symbols.empty())
+	{
+		WriteBlock(bits, m_Symbols, data + blockStart, pos - blockStart);
+	}
+
+	// an empty stored block, a sync flush if more chunks follow or the end of the stream
+	bits.Put(last ? 1 : 0, 1);
+	bits.Put(0, 2);
+	bits.Align();
+	bits.Put(0, 16);
+	bits.Put(0xFFFF, 16);
+}
+
+uint32_t Deflate::Adler32(const uint8_t* data, const size_t& size, uint32_t adler)
+{
+	const uint32_t Base = 65521;
+
+	// the largest run that can be summed before the 32 bit sums could overflow
+	const size_t MaxRun = 5552;
+
+	uint32_t a = adler & 0xFFFF;
+	uint32_t b = adler >> 16;
+
+	size_t offset = 0;
+
+	while (offset < size)
+	{
+		const size_t run = std::min(MaxRun, size - offset);
+
+		for (size_t i = 0; i < run; ++i)
+		{
+			a += data[offset + i];
+			b += a;
+		}
+
+		a %= Base;
+		b %= Base;
+
+		offset += run;
+	}
+
+	return a | (b << 16);
+}
+
+uint32_t Deflate::CombineAdler32(const uint32_t& a, const uint32_t& b, const size_t& sizeB)
+{
+	const unsigned long long Base = 65521;
+
+	const unsigned long long remainder = sizeB % Base;
+
+	unsigned long long sum1 = a & 0xFFFF;
+	unsigned long long sum2 = (remainder * sum1) % Base;
+
+	sum1 += (b & 0xFFFF) + Base - 1;
+	sum2 += (a >> 16) + (b >> 16) + Base - remainder;
+
+	sum1 %= Base;
+	sum2 %= Base;
+
+	return (uint32_t)(sum1 | (sum2 << 16));
+}
+
+uint32_t Deflate::Crc32(const uint8_t* data, const size_t& size, uint32_t crc)
+{
+	crc = ~crc;
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		crc = Tables.m_Crc[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+
+	return ~crc;
+}
@@ -0,0 +1,86 @@
+#include <Modules/Graphics/EncoderBackend.h>
+#include <Modules/Graphics/MFEncoderBackend.h>
+#include <Modules/Graphics/Y4MEncoderBackend.h>
+#include <Modules/Graphics/MJPEGEncoderBackend.h>
+#include <Modules/Graphics/ScreenEncoderBackend.h>
+
+std::unique_ptr<EncoderBackend> EncoderBackend::Create(const EncoderType& type)
+{
+	if (!IsAvailable(type))
+		return nullptr;
+
+	switch (type)
+	{
+	case EncoderType::MediaFoundation:
+		return std::make_unique<MFEncoderBackend>();
+	case EncoderType::Y4M:
+		return std::make_unique<Y4MEncoderBackend>(false);
+	case EncoderType::RawI420:
+		return std::make_unique<Y4MEncoderBackend>(true);
+	case EncoderType::MJPEG:
+		return std::make_unique<MJPEGEncoderBackend>();
+	case EncoderType::Screen:
+		return std::make_unique<ScreenEncoderBackend>();
+	default:
+		return nullptr;
+	}
+}
+
+bool EncoderBackend::IsAvailable(const EncoderType& type)
+{
+	switch (type)
+	{
+	case EncoderType::MediaFoundation:
+		return MFEncoderBackend::IsSupported();
+	case EncoderType::Y4M:
+	case EncoderType::RawI420:
+	case EncoderType::MJPEG:
+	case EncoderType::Screen:
+		return true;
+	default:
+		return false;
+	}
+}
+
+const char* EncoderBackend::GetName(const EncoderType& type)
+{
+	switch (type)
+	{
+	case EncoderType::MediaFoundation:
+		return "Media Foundation (WMV)";
+	case EncoderType::Y4M:
+		return "Y4M (Uncompressed)";
+	case EncoderType::RawI420:
+		return "Raw I420 (Uncompressed)";
+	case EncoderType::MJPEG:
+		return "MJPEG (Intra Only)";
+	case EncoderType::Screen:
+		return "Screen Codec (Lossless)";
+	default:
+		return "Unknown";
+	}
+}
+
+const char* EncoderBackend::GetFileExtension(const EncoderType& type)
+{
+	switch (type)
+	{
+	case EncoderType::MediaFoundation:
+		return ".wmv";
+	case EncoderType::Y4M:
+		return ".y4m";
+	case EncoderType::RawI420:
+		return ".yuv";
+	case EncoderType::MJPEG:
+		return ".mkv";
+	case EncoderType::Screen:
+		return ".glsc";
+	default:
+		return "";
+	}
+}
+
+EncoderType EncoderBackend::GetDefault()
+{
+	return IsAvailable(EncoderType::MediaFoundation) ? EncoderType::MediaFoundation : EncoderType::Y4M;
+}
@@ -0,0 +1,240 @@
+#include <Modules/Graphics/FrameCompressor.h>
+
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+	const int HashBits = 16;
+	const size_t MinMatch = 4;
+
+	// offsets are stored as varints so the window only needs to fit the position type
+	const size_t MaxOffset = 1u << 24;
+
+	inline uint32_t Read32(const uint8_t* p)
+	{
+		uint32_t value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	inline uint64_t Read64(const uint8_t* p)
+	{
+		uint64_t value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	inline uint32_t Hash(const uint32_t& sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - HashBits);
+	}
+
+	inline void WriteVarint(std::vector<uint8_t>& dst, size_t value)
+	{
+		while (value >= 0x80)
+		{
+			dst.push_back((uint8_t)(value | 0x80));
+			value >>= 7;
+		}
+
+		dst.push_back((uint8_t)value);
+	}
+
+	inline bool ReadVarint(const uint8_t*& src, const uint8_t* end, size_t& value)
+	{
+		value = 0;
+
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			if (src >= end)
+				return false;
+
+			const uint8_t byte = *src++;
+
+			value |= (size_t)(byte & 0x7F) << shift;
+
+			if ((byte & 0x80) == 0)
+				return true;
+		}
+
+		return false;
+	}
+
+	inline size_t MatchLength(const uint8_t* a, const uint8_t* b, const uint8_t* end)
+	{
+		const uint8_t* start = b;
+
+		while (b + 8 <= end)
+		{
+			const uint64_t diff = Read64(a) ^ Read64(b);
+
+			if (diff != 0)
+			{
+				// little endian, the lowest set bit is the first differing byte
+				size_t same = 0;
+
+				for (uint64_t d = diff; (d & 0xFF) == 0; d >>= 8)
+					++same;
+
+				return (b - start) + same;
+			}
+
+			a += 8;
+			b += 8;
+		}
+
+		while (b < end && *a == *b)
+		{
+			++a;
+			++b;
+		}
+
+		return b - start;
+	}
+}
+
+FrameCompressor::FrameCompressor()
+{
+	m_HashTable.resize((size_t)1 << HashBits);
+}
+
+size_t FrameCompressor::Compress(const uint8_t* src, const size_t& size, std::vector<uint8_t>& dst)
+{
+	dst.clear();
+	dst.reserve(size / 16 + 64);
+
+	std::fill(m_HashTable.begin(), m_HashTable.end(), 0u);
+
+	// sequences are [literal count][literals][match length][match offset], a zero match length ends the block
+	size_t anchor = 0;
+	size_t pos = 1;
+
+	while (size >= 8 && pos + 8 <= size)
+	{
+		const uint32_t sequence = Read32(src + pos);
+		const uint32_t hash = Hash(sequence);
+		const size_t candidate = m_HashTable[hash];
+
+		m_HashTable[hash] = (uint32_t)pos;
+
+		if (candidate < pos && pos - candidate <= MaxOffset && Read32(src + candidate) == sequence)
+		{
+			const size_t length = MinMatch + MatchLength(src + candidate + MinMatch, src + pos + MinMatch, src + size);
+
+			WriteVarint(dst, pos - anchor);
+			dst.insert(dst.end(), src + anchor, src + pos);
+
+			WriteVarint(dst, length);
+			WriteVarint(dst, pos - candidate);
+
+			pos += length;
+			anchor = pos;
+
+			// keep the table warm at the end of the match so the next run is picked up straight away
+			if (pos + 8 <= size)
+				m_HashTable[Hash(Read32(src + pos - 1))] = (uint32_t)(pos - 1);
+		}
+		else
+		{
+			// step faster through data that isn't compressing
+			pos += 1 + ((pos - anchor) >> 6);
+		}
+	}
+
+	WriteVarint(dst, size - anchor);
+	dst.insert(dst.end(), src + anchor, src + size);
+	WriteVarint(dst, 0);
+
+	return dst.size();
+}
+
+bool FrameCompressor::Decompress(const uint8_t* src, const size_t& size, uint8_t* dst, const size_t& dstSize)
+{
+	const uint8_t* end = src + size;
+	uint8_t* out = dst;
+	uint8_t* outEnd = dst + dstSize;
+
+	while (true)
+	{
+		size_t literals = 0;
+
+		if (!ReadVarint(src, end, literals) || literals > (size_t)(end - src) || literals > (size_t)(outEnd - out))
+			return false;
+
+		std::memcpy(out, src, literals);
+
+		out += literals;
+		src += literals;
+
+		size_t length = 0;
+
+		if (!ReadVarint(src, end, length))
+			return false;
+
+		if (length == 0)
+			break;
+
+		size_t offset = 0;
+
+		if (!ReadVarint(src, end, offset) || offset == 0 || offset > (size_t)(out - dst) || length > (size_t)(outEnd - out))
+			return false;
+
+		const uint8_t* match = out - offset;
+
+		if (offset == 1)
+		{
+			std::memset(out, *match, length);
+		}
+		else
+		{
+			// overlapping copy, grow the chunk in whole periods so each memcpy reads bytes that are already written
+			size_t copied = 0;
+
+			while (copied < length)
+			{
+				const size_t chunk = std::min(length - copied, copied + offset);
+
+				std::memcpy(out + copied, match, chunk);
+
+				copied += chunk;
+			}
+		}
+
+		out += length;
+	}
+
+	return out == outEnd;
+}
+
+void FrameCompressor::Xor(uint8_t* dst, const uint8_t* src, const size_t& size)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= size; i += 8)
+	{
+		const uint64_t value = Read64(dst + i) ^ Read64(src + i);
+		std::memcpy(dst + i, &value, sizeof(value));
+	}
+
+	for (; i < size; ++i)
+	{
+		dst[i] ^= src[i];
+	}
+}
+
+void FrameCompressor::Xor(uint8_t* dst, const uint8_t* a, const uint8_t* b, const size_t& size)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= size; i += 8)
+	{
+		const uint64_t value = Read64(a + i) ^ Read64(b + i);
+		std::memcpy(dst + i, &value, sizeof(value));
+	}
+
+	for (; i < size; ++i)
+	{
+		dst[i] = a[i] ^ b[i];
+	}
+}
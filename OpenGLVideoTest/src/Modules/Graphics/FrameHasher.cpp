@@ -0,0 +1,327 @@
+#include <Modules/Graphics/FrameHasher.h>
+
+#include <array>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define FRAME_HASH_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(FRAME_HASH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define AVX2_TARGET
+#endif
+
+namespace
+{
+	// accumulation is done on 64 byte stripes of 8 lanes, every 16 stripes the lanes are scrambled
+	const size_t StripeSize = 64;
+	const size_t StripesPerBlock = 16;
+	const size_t BlockSize = StripeSize * StripesPerBlock;
+
+	const uint64_t Prime32 = 0x9E3779B1ull;
+	const uint64_t Prime64_1 = 0x9E3779B185EBCA87ull;
+	const uint64_t Prime64_2 = 0xC2B2AE3D27D4EB4Full;
+	const uint64_t Prime64_3 = 0x165667B19E3779F9ull;
+
+	// each stripe uses the keys from its own offset, so moving a stripe within a block still changes the hash
+	constexpr std::array<uint64_t, StripesPerBlock + 8> MakeKeys()
+	{
+		std::array<uint64_t, StripesPerBlock + 8> keys{};
+
+		uint64_t state = 0x4F70656E474C5669ull;
+
+		for (uint64_t& key : keys)
+		{
+			// splitmix64
+			state += 0x9E3779B97F4A7C15ull;
+
+			uint64_t z = state;
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+
+			key = z ^ (z >> 31);
+		}
+
+		return keys;
+	}
+
+	alignas(32) const std::array<uint64_t, StripesPerBlock + 8> Keys = MakeKeys();
+
+	inline uint64_t Read64(const uint8_t* p)
+	{
+		uint64_t value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	inline uint64_t RotateLeft(const uint64_t& value, const int& bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	void InitAccumulators(uint64_t* acc)
+	{
+		for (size_t i = 0; i < 8; ++i)
+		{
+			acc[i] = Keys[i] * Prime64_1;
+		}
+	}
+
+	void AccumulateScalar(uint64_t* acc, const uint8_t* data, const size_t& stripes)
+	{
+		for (size_t s = 0; s < stripes; ++s)
+		{
+			for (size_t i = 0; i < 8; ++i)
+			{
+				const uint64_t value = Read64(data + s * StripeSize + i * 8);
+				const uint64_t keyed = value ^ Keys[s + i];
+
+				acc[i ^ 1] += value;
+				acc[i] += (keyed & 0xFFFFFFFFull) * (keyed >> 32);
+			}
+		}
+	}
+
+	void ScrambleScalar(uint64_t* acc)
+	{
+		for (size_t i = 0; i < 8; ++i)
+		{
+			acc[i] ^= acc[i] >> 47;
+			acc[i] ^= Keys[StripesPerBlock + i];
+			acc[i] *= Prime32;
+		}
+	}
+
+	// shared by every path so they all finish the same way
+	uint64_t Finish(const uint64_t* acc, const uint8_t* tail, const size_t& tailSize, const size_t& size)
+	{
+		uint64_t hash = (uint64_t)size * Prime64_1;
+
+		for (size_t i = 0; i < 8; ++i)
+		{
+			hash ^= acc[i] * Prime64_2;
+			hash = RotateLeft(hash, 31) * Prime64_1;
+		}
+
+		for (size_t i = 0; i < tailSize; ++i)
+		{
+			hash ^= tail[i] * Prime64_3;
+			hash = RotateLeft(hash, 11) * Prime64_1;
+		}
+
+		hash ^= hash >> 33;
+		hash *= Prime64_2;
+		hash ^= hash >> 29;
+		hash *= Prime64_3;
+		hash ^= hash >> 32;
+
+		return hash;
+	}
+
+#ifdef FRAME_HASH_X86
+	inline __m128i MultiplyPrime32(const __m128i& value)
+	{
+		const __m128i prime = _mm_set1_epi32((int)Prime32);
+
+		const __m128i low = _mm_mul_epu32(value, prime);
+		const __m128i high = _mm_mul_epu32(_mm_srli_epi64(value, 32), prime);
+
+		return _mm_add_epi64(low, _mm_slli_epi64(high, 32));
+	}
+
+	void AccumulateSSE2(__m128i* acc, const uint8_t* data, const size_t& stripes)
+	{
+		for (size_t s = 0; s < stripes; ++s)
+		{
+			for (size_t i = 0; i < 4; ++i)
+			{
+				const __m128i value = _mm_loadu_si128((const __m128i*)(data + s * StripeSize + i * 16));
+				const __m128i keyed = _mm_xor_si128(value, _mm_loadu_si128((const __m128i*)(Keys.data() + s + i * 2)));
+
+				// low half of each lane times its high half, plus the neighbouring lane's raw value
+				const __m128i product = _mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32));
+				const __m128i swapped = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+
+				acc[i] = _mm_add_epi64(acc[i], _mm_add_epi64(product, swapped));
+			}
+		}
+	}
+
+	void ScrambleSSE2(__m128i* acc)
+	{
+		for (size_t i = 0; i < 4; ++i)
+		{
+			__m128i value = _mm_xor_si128(acc[i], _mm_srli_epi64(acc[i], 47));
+			value = _mm_xor_si128(value, _mm_loadu_si128((const __m128i*)(Keys.data() + StripesPerBlock + i * 2)));
+
+			acc[i] = MultiplyPrime32(value);
+		}
+	}
+
+	AVX2_TARGET void AccumulateAVX2(__m256i* acc, const uint8_t* data, const size_t& stripes)
+	{
+		for (size_t s = 0; s < stripes; ++s)
+		{
+			for (size_t i = 0; i < 2; ++i)
+			{
+				const __m256i value = _mm256_loadu_si256((const __m256i*)(data + s * StripeSize + i * 32));
+				const __m256i keyed = _mm256_xor_si256(value, _mm256_loadu_si256((const __m256i*)(Keys.data() + s + i * 4)));
+
+				const __m256i product = _mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32));
+				const __m256i swapped = _mm256_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+
+				acc[i] = _mm256_add_epi64(acc[i], _mm256_add_epi64(product, swapped));
+			}
+		}
+	}
+
+	AVX2_TARGET void ScrambleAVX2(__m256i* acc)
+	{
+		const __m256i prime = _mm256_set1_epi32((int)Prime32);
+
+		for (size_t i = 0; i < 2; ++i)
+		{
+			__m256i value = _mm256_xor_si256(acc[i], _mm256_srli_epi64(acc[i], 47));
+			value = _mm256_xor_si256(value, _mm256_loadu_si256((const __m256i*)(Keys.data() + StripesPerBlock + i * 4)));
+
+			const __m256i low = _mm256_mul_epu32(value, prime);
+			const __m256i high = _mm256_mul_epu32(_mm256_srli_epi64(value, 32), prime);
+
+			acc[i] = _mm256_add_epi64(low, _mm256_slli_epi64(high, 32));
+		}
+	}
+#endif
+}
+
+uint64_t FrameHasher::HashScalar(const uint8_t* data, const size_t& size)
+{
+	uint64_t acc[8];
+	InitAccumulators(acc);
+
+	const size_t blocks = size / BlockSize;
+
+	for (size_t b = 0; b < blocks; ++b)
+	{
+		AccumulateScalar(acc, data + b * BlockSize, StripesPerBlock);
+		ScrambleScalar(acc);
+	}
+
+	const size_t stripes = (size - blocks * BlockSize) / StripeSize;
+	const size_t tail = blocks * BlockSize + stripes * StripeSize;
+
+	AccumulateScalar(acc, data + blocks * BlockSize, stripes);
+
+	return Finish(acc, data + tail, size - tail, size);
+}
+
+#ifdef FRAME_HASH_X86
+uint64_t FrameHasher::HashSSE2(const uint8_t* data, const size_t& size)
+{
+	alignas(16) uint64_t lanes[8];
+	InitAccumulators(lanes);
+
+	__m128i acc[4];
+
+	for (size_t i = 0; i < 4; ++i)
+	{
+		acc[i] = _mm_load_si128((const __m128i*)(lanes + i * 2));
+	}
+
+	const size_t blocks = size / BlockSize;
+
+	for (size_t b = 0; b < blocks; ++b)
+	{
+		AccumulateSSE2(acc, data + b * BlockSize, StripesPerBlock);
+		ScrambleSSE2(acc);
+	}
+
+	const size_t stripes = (size - blocks * BlockSize) / StripeSize;
+	const size_t tail = blocks * BlockSize + stripes * StripeSize;
+
+	AccumulateSSE2(acc, data + blocks * BlockSize, stripes);
+
+	for (size_t i = 0; i < 4; ++i)
+	{
+		_mm_store_si128((__m128i*)(lanes + i * 2), acc[i]);
+	}
+
+	return Finish(lanes, data + tail, size - tail, size);
+}
+
+AVX2_TARGET uint64_t FrameHasher::HashAVX2(const uint8_t* data, const size_t& size)
+{
+	alignas(32) uint64_t lanes[8];
+	InitAccumulators(lanes);
+
+	__m256i acc[2];
+
+	for (size_t i = 0; i < 2; ++i)
+	{
+		acc[i] = _mm256_load_si256((const __m256i*)(lanes + i * 4));
+	}
+
+	const size_t blocks = size / BlockSize;
+
+	for (size_t b = 0; b < blocks; ++b)
+	{
+		AccumulateAVX2(acc, data + b * BlockSize, StripesPerBlock);
+		ScrambleAVX2(acc);
+	}
+
+	const size_t stripes = (size - blocks * BlockSize) / StripeSize;
+	const size_t tail = blocks * BlockSize + stripes * StripeSize;
+
+	AccumulateAVX2(acc, data + blocks * BlockSize, stripes);
+
+	for (size_t i = 0; i < 2; ++i)
+	{
+		_mm256_store_si256((__m256i*)(lanes + i * 4), acc[i]);
+	}
+
+	return Finish(lanes, data + tail, size - tail, size);
+}
+#else
+uint64_t FrameHasher::HashSSE2(const uint8_t* data, const size_t& size)
+{
+	return HashScalar(data, size);
+}
+
+uint64_t FrameHasher::HashAVX2(const uint8_t* data, const size_t& size)
+{
+	return HashScalar(data, size);
+}
+#endif
+
+uint64_t FrameHasher::Hash(const void* data, const size_t& size)
+{
+	return Hash(data, size, ColourConverter::GetBestPath());
+}
+
+uint64_t FrameHasher::Hash(const void* data, const size_t& size, const ColourConverter::Path& path)
+{
+	if (!ColourConverter::IsPathSupported(path))
+		return HashScalar((const uint8_t*)data, size);
+
+	switch (path)
+	{
+	case ColourConverter::Path::AVX2:
+		return HashAVX2((const uint8_t*)data, size);
+	case ColourConverter::Path::SSE2:
+		return HashSSE2((const uint8_t*)data, size);
+	default:
+		return HashScalar((const uint8_t*)data, size);
+	}
+}
+
+uint64_t FrameHasher::Combine(const uint64_t& seed, const uint64_t& value)
+{
+	uint64_t hash = seed ^ (value * Prime64_2);
+
+	hash = RotateLeft(hash, 31) * Prime64_1;
+	hash ^= hash >> 29;
+
+	return hash;
+}
@@ -0,0 +1,214 @@
+#include <Modules/Graphics/FramePool.h>
+
+#include <cstdlib>
+#include <iostream>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+FrameHandle::FrameHandle(FrameHandle&& other) noexcept : m_Pool(std::move(other.m_Pool)), m_Data(other.m_Data)
+{
+	other.m_Data = nullptr;
+}
+
+FrameHandle& FrameHandle::operator=(FrameHandle&& other) noexcept
+{
+	if (this != &other)
+	{
+		Reset();
+
+		m_Pool = std::move(other.m_Pool);
+		m_Data = other.m_Data;
+
+		other.m_Data = nullptr;
+	}
+
+	return *this;
+}
+
+void FrameHandle::Reset()
+{
+	if (m_Data != nullptr && m_Pool != nullptr)
+	{
+		m_Pool->Release(m_Data);
+	}
+
+	m_Data = nullptr;
+	m_Pool = nullptr;
+}
+
+FramePool::FramePool(const size_t& frameSize, const size_t& preallocate) : m_FrameSize(frameSize)
+{
+	// round up so every slab starts and ends on a cache line
+	m_SlabSize = (frameSize + Alignment - 1) / Alignment * Alignment;
+
+	Reserve(preallocate);
+}
+
+FramePool::~FramePool()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	if (m_Outstanding > 0)
+	{
+		std::cout << "FramePool - " << m_Outstanding << " frames still in use on destruction!" << std::endl;
+	}
+
+	for (void* slab : m_FreeSlabs)
+	{
+		FreeSlab(slab);
+	}
+
+	m_FreeSlabs.clear();
+}
+
+void* FramePool::AllocateSlab(const size_t& size)
+{
+#ifdef _WIN32
+	return _aligned_malloc(size, Alignment);
+#else
+	return std::aligned_alloc(Alignment, size);
+#endif
+}
+
+void FramePool::FreeSlab(void* slab)
+{
+#ifdef _WIN32
+	_aligned_free(slab);
+#else
+	std::free(slab);
+#endif
+}
+
+FrameHandle FramePool::Acquire()
+{
+	void* slab = nullptr;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (!m_FreeSlabs.empty())
+		{
+			slab = m_FreeSlabs.back();
+			m_FreeSlabs.pop_back();
+
+			++m_Hits;
+		}
+		else
+		{
+			++m_Misses;
+		}
+	}
+
+	// allocate outside the lock, the writer thread may be returning slabs meanwhile
+	if (slab == nullptr)
+	{
+		slab = AllocateSlab(m_SlabSize);
+
+		if (slab == nullptr)
+		{
+			std::cout << "FramePool - Failed to allocate a " << m_SlabSize << " byte frame!" << std::endl;
+
+			return FrameHandle();
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		++m_SlabCount;
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	++m_Outstanding;
+
+	if (m_Outstanding > m_HighWater)
+		m_HighWater = m_Outstanding;
+
+	return FrameHandle(shared_from_this(), slab);
+}
+
+void FramePool::Release(void* slab)
+{
+	if (slab == nullptr)
+		return;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	m_FreeSlabs.push_back(slab);
+
+	if (m_Outstanding > 0)
+		--m_Outstanding;
+}
+
+void FramePool::Reserve(const size_t& count)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	while (m_SlabCount < count)
+	{
+		void* slab = AllocateSlab(m_SlabSize);
+
+		if (slab == nullptr)
+		{
+			std::cout << "FramePool - Failed to reserve " << count << " frames!" << std::endl;
+
+			return;
+		}
+
+		m_FreeSlabs.push_back(slab);
+		++m_SlabCount;
+	}
+}
+
+void FramePool::Trim(const size_t& maxSlabs)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	// only free slabs can be given back, anything outstanding stays with its owner
+	while (m_SlabCount > maxSlabs && !m_FreeSlabs.empty())
+	{
+		FreeSlab(m_FreeSlabs.back());
+		m_FreeSlabs.pop_back();
+
+		--m_SlabCount;
+	}
+}
+
+void FramePool::ResetStats()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	m_Hits = 0;
+	m_Misses = 0;
+	m_HighWater = m_Outstanding;
+}
+
+size_t FramePool::GetSlabCount() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_SlabCount;
+}
+
+size_t FramePool::GetOutstanding() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Outstanding;
+}
+
+size_t FramePool::GetHighWater() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_HighWater;
+}
+
+unsigned long long FramePool::GetHits() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Hits;
+}
+
+unsigned long long FramePool::GetMisses() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Misses;
+}
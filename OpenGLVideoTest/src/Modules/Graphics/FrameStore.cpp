@@ -0,0 +1,211 @@
+#include <Modules/Graphics/FrameStore.h>
+
+#include <cstring>
+
+FrameStore::FrameStore(const size_t& frameSize, const size_t& keyFrameInterval) :
+	m_FrameSize(frameSize),
+	m_KeyFrameInterval(keyFrameInterval > 0 ? keyFrameInterval : 1)
+{
+	m_Worker = std::thread(&FrameStore::CompressFrames, this);
+}
+
+FrameStore::~FrameStore()
+{
+	Finish();
+}
+
+void FrameStore::Push(FrameHandle frame)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (m_Finishing)
+			return;
+
+		m_Pending.push_back(std::move(frame));
+	}
+
+	m_Condition.notify_one();
+}
+
+void FrameStore::Finish()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Finishing = true;
+	}
+
+	m_Condition.notify_one();
+
+	if (m_Worker.joinable())
+	{
+		m_Worker.join();
+	}
+}
+
+size_t FrameStore::GetPending() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	return m_Pending.size();
+}
+
+double FrameStore::GetCompressionRatio() const
+{
+	const unsigned long long compressed = m_CompressedBytes;
+
+	return compressed > 0 ? (double)m_RawBytes / (double)compressed : 0.0;
+}
+
+void FrameStore::CompressFrames()
+{
+	FrameCompressor compressor;
+
+	std::vector<uint8_t> delta(m_FrameSize);
+	std::vector<uint8_t> packed;
+
+	// the previous raw frame is held on to rather than copied, it costs one extra pool slab
+	FrameHandle previous;
+	size_t lastKeyFrame = 0;
+
+	while (true)
+	{
+		FrameHandle frame;
+
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+
+			m_Condition.wait(lock, [this] { return !m_Pending.empty() || m_Finishing; });
+
+			if (m_Pending.empty())
+				break;
+
+			frame = std::move(m_Pending.front());
+			m_Pending.pop_front();
+		}
+
+		const size_t index = m_Frames.size();
+
+		StoredFrame stored;
+
+		if (!frame)
+		{
+			stored.m_KeyFrame = false;
+			stored.m_Repeat = true;
+
+			m_RawBytes += m_FrameSize;
+
+			m_Frames.push_back(std::move(stored));
+			++m_FramesStored;
+
+			continue;
+		}
+
+		const uint8_t* data = (const uint8_t*)frame.GetData();
+
+		// first real frame of each interval, repeats can't be keyframes
+		stored.m_KeyFrame = !previous || index / m_KeyFrameInterval != lastKeyFrame / m_KeyFrameInterval;
+
+		if (stored.m_KeyFrame)
+		{
+			lastKeyFrame = index;
+		}
+
+		if (stored.m_KeyFrame)
+		{
+			compressor.Compress(data, m_FrameSize, packed);
+		}
+		else
+		{
+			// gui frames barely change, xor against the last one leaves long zero runs
+			FrameCompressor::Xor(delta.data(), data, (const uint8_t*)previous.GetData(), m_FrameSize);
+			compressor.Compress(delta.data(), m_FrameSize, packed);
+		}
+
+		stored.m_Data.assign(packed.begin(), packed.end());
+
+		m_RawBytes += m_FrameSize;
+		m_CompressedBytes += stored.m_Data.size();
+
+		m_Frames.push_back(std::move(stored));
+		++m_FramesStored;
+
+		previous = std::move(frame);
+	}
+}
+
+FrameStore::Reader::Reader(const FrameStore& store) :
+	m_Store(store)
+{
+	m_Frame.resize(m_Store.m_FrameSize);
+	m_Delta.resize(m_Store.m_FrameSize);
+
+	// nothing decoded yet, forces the first read to seek to a keyframe
+	m_Next = (size_t)-1;
+}
+
+bool FrameStore::Reader::Decode(const size_t& index)
+{
+	const StoredFrame& stored = m_Store.m_Frames[index];
+
+	// the frame is already sitting in the buffer
+	if (stored.m_Repeat)
+		return true;
+
+	if (stored.m_KeyFrame)
+	{
+		return FrameCompressor::Decompress(stored.m_Data.data(), stored.m_Data.size(), m_Frame.data(), m_Frame.size());
+	}
+
+	if (!FrameCompressor::Decompress(stored.m_Data.data(), stored.m_Data.size(), m_Delta.data(), m_Delta.size()))
+		return false;
+
+	FrameCompressor::Xor(m_Frame.data(), m_Delta.data(), m_Frame.size());
+
+	return true;
+}
+
+const void* FrameStore::Reader::Read(const size_t& index)
+{
+	if (index >= m_Store.GetFrameCount())
+		return nullptr;
+
+	// repeats in between leave the buffer as it is
+	while (m_Next < index && m_Store.m_Frames[m_Next].m_Repeat)
+		++m_Next;
+
+	if (index != m_Next)
+	{
+		// out of order, step back to the keyframe this frame depends on and decode forward
+		size_t key = index;
+
+		while (key > 0 && !m_Store.m_Frames[key].m_KeyFrame)
+			--key;
+
+		for (m_Next = key; m_Next < index; ++m_Next)
+		{
+			if (!Decode(m_Next))
+			{
+				m_Next = (size_t)-1;
+
+				return nullptr;
+			}
+		}
+	}
+
+	if (!Decode(index))
+	{
+		m_Next = (size_t)-1;
+
+		return nullptr;
+	}
+
+	m_Next = index + 1;
+
+	return m_Frame.data();
+}
+
+bool FrameStore::Reader::IsRepeat(const size_t& index) const
+{
+	return index < m_Store.GetFrameCount() && m_Store.m_Frames[index].m_Repeat;
+}
@@ -1,21 +1,37 @@
 #include "Modules/Graphics/Graphics.h"
 
-#include <imgui\imgui.h>
-#include <imgui\imgui_impl_glfw.h>
-#include <imgui\imgui_impl_opengl3.h>
-#include <imgui\imgui_internal.h>
+#include <imgui/imgui.h>
+#include <imgui/imgui_impl_glfw.h>
+#include <imgui/imgui_impl_opengl3.h>
+#include <imgui/imgui_internal.h>
 
 #include <glew/glew.h>
 #include <GLFW/glfw3.h>
 
 #include <Modules/Graphics/Renderer.h>
 #include <Modules/Graphics/VideoWriter.h>
+#include <Modules/Graphics/PixelReadback.h>
+#include <Modules/Graphics/FramePool.h>
+#include <Modules/Graphics/FrameStore.h>
+#include <Modules/Graphics/FrameHasher.h>
+#include <Modules/Graphics/RenderTarget.h>
+#include <Modules/Graphics/OutputSink.h>
+#include <Modules/Graphics/ScreenshotWriter.h>
+#include <Modules/Graphics/ColourConverter.h>
+#include <Modules/Graphics/JpegEncoder.h>
+#include <Modules/Graphics/ScreenCodec.h>
+#include <Modules/Graphics/EncoderBackend.h>
 
 #include <iostream>
 #include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <future>
+#include <chrono>
+#include <thread>
+#include <ctime>
+#include <cstring>
+#include <cstdlib>
 
 static void GLFW_ERROR_LOG(int error, const char* description)
 {
@@ -24,8 +40,11 @@ static void GLFW_ERROR_LOG(int error, const char* description)
 
 int Graphics::Start()
 {
-	sprintf_s(m_RenderFilePathBase, "%s\\Videos", std::filesystem::current_path().string().c_str());
-	sprintf_s(m_PrintFilePathBase, "%s\\Logs", std::filesystem::current_path().string().c_str());
+	const std::string workingPath = std::filesystem::current_path().string();
+
+	m_RenderFilePathBase = workingPath + "/Videos";
+	m_PrintFilePathBase = workingPath + "/Logs";
+	m_ScreenshotFilePathBase = workingPath + "/Screenshots";
 
 	if (!std::filesystem::exists(m_RenderFilePathBase))
 	{
@@ -37,11 +56,55 @@ int Graphics::Start()
 		std::filesystem::create_directory(m_PrintFilePathBase);
 	}
 
+	if (!std::filesystem::exists(m_ScreenshotFilePathBase))
+	{
+		std::filesystem::create_directory(m_ScreenshotFilePathBase);
+	}
+
 	m_ClearColour = std::make_shared<ImVec4>(ImVec4(0.45f, 0.55f, 0.60f, 1.00f));
 	m_WindowSize = std::make_shared<ImVec2>(ImVec2(1600.0f, 900.0f));
 
 	m_BufferSize = m_WindowSize->x * m_WindowSize->y * 4;
 
+	m_RenderFileEncoder = (int)EncoderBackend::GetDefault();
+	m_RenderFileExtension = EncoderBackend::GetFileExtension(EncoderBackend::GetDefault());
+	m_RenderFileThreads = std::max(1, (int)std::thread::hardware_concurrency());
+
+	if (m_Options.m_Headless)
+	{
+		// a hidden window's back buffer isn't guaranteed to hold anything, so draw into a target we own
+		m_RenderOffscreen = true;
+		m_OffscreenSize[0] = (int)m_WindowSize->x;
+		m_OffscreenSize[1] = (int)m_WindowSize->y;
+	}
+
+	if (!m_Options.m_RecordName.empty())
+	{
+		std::copy_n(m_Options.m_RecordName.c_str(), m_Options.m_RecordName.size() + 1, m_RenderFileName);
+
+		if (m_Options.m_Encoder >= 0 && EncoderBackend::IsAvailable((EncoderType)m_Options.m_Encoder))
+		{
+			m_RenderFileEncoder = m_Options.m_Encoder;
+		}
+
+		m_RenderFileFPS = std::clamp(m_Options.m_RecordFPS, 1, 60);
+		m_RenderFileTime = std::clamp(m_Options.m_RecordTime, 1, 600);
+		m_RenderFileDelay = 0;
+		m_OfflineRender = m_Options.m_Offline;
+		m_RenderFileExtension = EncoderBackend::GetFileExtension((EncoderType)m_RenderFileEncoder);
+
+		m_RenderFilePath = m_RenderFilePathBase + "/" + m_RenderFileName + m_RenderFileExtension;
+
+		if (!m_Options.m_LiveTarget.empty())
+		{
+			// the target stands in for the file path, the writer opens a live sink for it
+			m_RenderFilePath = m_Options.m_LiveTarget;
+		}
+
+		m_AutoRecord = true;
+		m_CloseAfterSave = true;
+	}
+
 	int err = SetupGLFW();
 
 	if (err != 0)
@@ -49,6 +112,9 @@ int Graphics::Start()
 		return err;
 	}
 
+	// enough frames for a full stream queue and the ones either side of it
+	m_FramePool = std::make_shared<FramePool>(m_BufferSize, m_StreamQueueDepth + StreamSpareFrames);
+
 	SetupParts();
 
 	err = SetupImGUI();
@@ -60,15 +126,9 @@ int Graphics::Start()
 
 	ImGui::GetIO().MouseDrawCursor = true;
 
-	glGenBuffers(2, m_PixelBuffers);
-
-	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_PixelBuffers[0]);
-	glBufferData(GL_PIXEL_PACK_BUFFER, m_BufferSize, 0, GL_STREAM_READ);
+	m_Readback = std::make_shared<PixelReadback>(m_BufferSize, m_ReadbackDepth);
 
-	glBindBuffer(GL_PIXEL_PACK_BUFFER, m_PixelBuffers[1]);
-	glBufferData(GL_PIXEL_PACK_BUFFER, m_BufferSize, 0, GL_STREAM_READ);
-
-	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	m_ScreenshotWriter = std::make_shared<ScreenshotWriter>(std::max(1, (int)std::thread::hardware_concurrency()));
 
 	m_Init = true;
 
@@ -102,6 +162,15 @@ int Graphics::Tick()
 
 		ImGui_ImplOpenGL3_NewFrame();
 		ImGui_ImplGlfw_NewFrame();
+
+		if (m_OfflineActive)
+		{
+			// time only moves on by one output frame per tick, however long the tick really took
+			ImGui::GetIO().DeltaTime = 1.0f / m_RenderFileFPS;
+		}
+
+		BeginOffscreenFrame();
+
 		ImGui::NewFrame();
 
 		static bool closeShown = false;
@@ -119,6 +188,23 @@ int Graphics::Tick()
 		static bool beginRendering = false;
 		static bool isDelayed = false;
 
+		if (m_AutoRecord)
+		{
+			m_AutoRecord = false;
+
+			// nobody is there to answer the overwrite popup
+			if (std::filesystem::exists(m_RenderFilePath) && std::remove(m_RenderFilePath.c_str()) != 0)
+			{
+				std::cout << "Could not overwrite '" << m_RenderFilePath << "'!" << std::endl;
+
+				return -1;
+			}
+
+			std::cout << "Recording '" << m_RenderFileName << m_RenderFileExtension << "' from the command line..." << std::endl;
+
+			beginRendering = true;
+		}
+
 		ImVec2 centre = ImGui::GetMainViewport()->GetWorkCenter();
 
 		ImGui::SetNextWindowPos(centre, ImGuiCond_FirstUseEver, ImVec2(0.5f, 0.5f));
@@ -210,7 +296,7 @@ int Graphics::Tick()
 
 		if (ShowOverwriteWindow() == 1)
 		{
-			if (std::remove(m_RenderFilePath) == 0)
+			if (std::remove(m_RenderFilePath.c_str()) == 0)
 			{
 				beginRendering = true;
 			}
@@ -238,16 +324,64 @@ int Graphics::Tick()
 		int display_w, display_h;
 		glfwGetFramebufferSize(m_Window, &display_w, &display_h);
 
-		glViewport(0, 0, display_w, display_h);
+		if (m_OffscreenTarget != nullptr)
+		{
+			m_CaptureFramebuffer = m_OffscreenTarget->GetID();
+			m_FramebufferWidth = m_OffscreenTarget->GetWidth();
+			m_FramebufferHeight = m_OffscreenTarget->GetHeight();
+
+			m_OffscreenTarget->Bind(true);
+		}
+		else
+		{
+			m_CaptureFramebuffer = 0;
+			m_FramebufferWidth = display_w;
+			m_FramebufferHeight = display_h;
+		}
+
+		// captures are skipped while this matches the last captured frame
+		if (beginRendering && m_SkipUnchangedDraws)
+		{
+			m_DrawDataHash = HashDrawData(m_FramebufferWidth, m_FramebufferHeight);
+		}
+
+		glViewport(0, 0, m_FramebufferWidth, m_FramebufferHeight);
 
 		glClearColor(m_ClearColour->x * m_ClearColour->w, m_ClearColour->y * m_ClearColour->w, m_ClearColour->z * m_ClearColour->w, m_ClearColour->w);
 		glClear(GL_COLOR_BUFFER_BIT);
 
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
+		if (m_OffscreenTarget != nullptr)
+		{
+			m_OffscreenTarget->Bind(false);
+
+			PresentOffscreenFrame(display_w, display_h);
+		}
+
+		if (m_ScreenshotRequest >= 0)
+		{
+			CaptureScreenshot();
+		}
+
+		CollectScreenshots(false);
+
+		if (m_ScreenCodecBenchmarkRequest)
+		{
+			PrintScreenCodecBenchmark();
+
+			m_ScreenCodecBenchmarkRequest = false;
+		}
+
 		if (beginRendering)
 		{
-			if (m_RecordDelayTime < m_RenderFileDelay)
+			if (m_OfflineRender && !m_OfflineActive)
+			{
+				// start on the next tick, so every captured frame was laid out with the fixed time step
+				m_OfflineActive = true;
+				m_RecordTicks = 0;
+			}
+			else if (m_RecordDelayTime < m_RenderFileDelay && !m_OfflineActive)
 			{
 				isDelayed = true;
 
@@ -259,56 +393,200 @@ int Graphics::Tick()
 
 				m_RecordTime += ImGui::GetIO().DeltaTime;
 
-				if (m_RecordTime < m_RenderFileTime)
-				{
-					m_Recording = true;
+				// offline recordings count frames rather than time, so they always end up with exactly fps * time frames
+				const bool recordingDone = m_OfflineActive ? m_RecordTicks >= (unsigned int)(m_RenderFileFPS * m_RenderFileTime) : m_RecordTime >= m_RenderFileTime;
 
+				if (!recordingDone)
+				{
 					if (m_RecordRefreshTime == 0.0)
+					{
 						m_RecordRefreshTime = ImGui::GetTime();
+						m_CaptureScheduler.Reset(m_RecordRefreshTime, m_RenderFileFPS);
+						m_FramesCaptured = 0;
+						m_DuplicateFrames = 0;
+						m_HasLastFrameHash = false;
 
-					// render at desired frame rate
-					while (m_RecordRefreshTime < ImGui::GetTime())
-					{
-						//swap read and write indices
-						m_WriteIndex = (m_WriteIndex + 1) % 2;
-						m_ReadIndex = (m_WriteIndex + 1) % 2;
+						// a region keeps the size it starts with, so every frame is the same size wherever it moves
+						GetCaptureRegion(m_SourceRect[0], m_SourceRect[1], m_SourceRect[2], m_SourceRect[3], false);
+						m_RegionSize[0] = m_SourceRect[2];
+						m_RegionSize[1] = m_SourceRect[3];
+
+						// frame size follows the capture size, so the pool and readback ring may need rebuilding
+						GetCaptureSize(m_CaptureWidth, m_CaptureHeight);
+						m_BufferSize = m_CaptureWidth * m_CaptureHeight * 4;
+
+						SetupCaptureTargets();
+
+						if (m_FramePool->GetFrameSize() != m_BufferSize)
+						{
+							m_FramePool = std::make_shared<FramePool>(m_BufferSize, m_StreamQueueDepth + StreamSpareFrames);
+						}
+
+						m_FramePool->ResetStats();
+
+						if (m_Readback->GetDepth() != m_ReadbackDepth || m_Readback->GetBufferSize() != m_BufferSize)
+						{
+							m_Readback = std::make_shared<PixelReadback>(m_BufferSize, m_ReadbackDepth);
+						}
+						else
+						{
+							m_Readback->Reset();
+						}
+
+						m_ReadRepeats.clear();
+						m_HasCapturedDrawHash = false;
+						m_SkippedReadbacks = 0;
+						m_RecordingStatus = RecordingStatus();
+
+						const bool live = OutputSink::IsLiveTarget(m_RenderFilePath);
 
-						glBindBuffer(GL_PIXEL_PACK_BUFFER, m_PixelBuffers[m_WriteIndex]);
-						glReadPixels(0, 0, m_WindowSize->x, m_WindowSize->y, GL_BGRA, GL_UNSIGNED_BYTE, NULL);
-						glBindBuffer(GL_PIXEL_PACK_BUFFER, m_PixelBuffers[m_ReadIndex]);
+						// nothing can be stored for later when another process is watching, and Media Foundation can only write to a file
+						// only this recording is changed, the next file recording gets the settings that were picked
+						const bool streamEncode = m_StreamEncode || live;
+						EncoderType encoder = (EncoderType)m_RenderFileEncoder;
 
-						void* mapData = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+						if (live && encoder == EncoderType::MediaFoundation)
+						{
+							encoder = EncoderType::Y4M;
+						}
+
+						if (vidWrite != nullptr)
+						{
+							vidWrite->SetColourMatrix(m_RenderFileMatrix == 1 ? ColourConverter::Matrix::BT709 : ColourConverter::Matrix::BT601);
+							vidWrite->SetEncoderType(encoder);
+							vidWrite->SetEncodeThreads(m_RenderFileThreads);
+							vidWrite->SetQuality(m_RenderFileQuality);
+							// a fixed time step recording has to come out the same however fast the encoder is, so it never drops frames
+							vidWrite->SetQueuePolicy(m_OfflineRender || m_OfflineActive ? VideoWriter::QueuePolicy::Block : (VideoWriter::QueuePolicy)m_StreamQueuePolicy);
+						}
 
-						if (mapData != nullptr)
+						if (streamEncode && vidWrite != nullptr)
 						{
-							void* frameCopy = malloc(m_BufferSize);
+							// the memory ceiling decides how many frames can wait in memory, the rest go to the spill file
+							size_t maxQueued = std::max((size_t)m_StreamQueueDepth, (size_t)m_StreamMemoryMB * 1024 * 1024 / m_BufferSize);
+
+							if (live)
+							{
+								// about 50ms of frames, with the readback ring that keeps a viewer under 100ms behind, older frames make way for new ones
+								maxQueued = std::max(1, m_RenderFileFPS / 20);
+
+								if (!m_OfflineRender && !m_OfflineActive)
+									vidWrite->SetQueuePolicy(VideoWriter::QueuePolicy::DropOldest);
 
-							if (memcpy_s(frameCopy, m_BufferSize, mapData, m_BufferSize) == 0)
+								vidWrite->SetSpillFile("", 0);
+							}
+							else if (m_SpillToDisk)
+							{
+								const std::string spillPath = m_RenderFilePathBase + "/" + m_RenderFileName + ".spill";
+
+								vidWrite->SetSpillFile(spillPath, std::max((size_t)1, (size_t)m_SpillFileMB * 1024 * 1024 / m_BufferSize));
+							}
+							else
+							{
+								vidWrite->SetSpillFile("", 0);
+							}
+
+							// writer has to be ready before the first frame is captured
+							if (vidWrite->Init(m_RenderFilePath.c_str(), m_CaptureWidth, m_CaptureHeight, m_RenderFileFPS, m_RenderFileTime, 6000000) == 0 && vidWrite->BeginStreaming(maxQueued) == 0)
+							{
+								m_Streaming = true;
+							}
+							else
 							{
-								m_StoredFrames.push_back(frameCopy);
+								std::cout << "Could not start streaming to '" << m_RenderFilePath << "', frames will be stored until recording ends." << std::endl;
 							}
+						}
 
-							glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+						if (!m_Streaming && m_CompressFrames)
+						{
+							// keyframes every second so the save can still be split into segments
+							m_FrameStore = std::make_shared<FrameStore>(m_BufferSize, m_RenderFileFPS);
 						}
+					}
+
+					m_Recording = true;
+
+					// collect any reads the GPU has already finished with
+					while (CollectFrame(false));
+
+					if (m_OfflineActive)
+					{
+						// exactly one frame per tick
+						CaptureFrame();
+
+						++m_RecordTicks;
+					}
+					else
+					{
+						// render at desired frame rate, a slow frame is read once and repeated rather than read again
+						const unsigned int slots = m_CaptureScheduler.Advance(ImGui::GetTime());
 
-						glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+						if (slots > 0)
+						{
+							CaptureFrame();
 
-						m_RecordRefreshTime += 1.0f / m_RenderFileFPS;
+							for (unsigned int i = 1; i < slots; ++i)
+							{
+								RepeatFrame();
+							}
+						}
 					}
 				}
 				else
 				{
 					if (vidWrite != nullptr && !m_Saving)
 					{
-						std::cout << m_StoredFrames.size() << " frames have been recorded, attempting to write to '" << m_RenderFileName << ".wmv'" << std::endl;
+						// make sure every frame still in the readback ring reaches the writer
+						while (CollectFrame(true));
+
+						std::cout << "Readback - " << m_Readback->GetReadCount() << " reads, " << m_Readback->GetFencePendingCount() << " fence polls still pending, " << m_Readback->GetStallCount() << " ring stalls (depth " << m_Readback->GetDepth() << ")" << std::endl;
+
+						if (m_Readback->GetFenceFailCount() > 0 || m_Readback->GetMapFailCount() > 0)
+						{
+							std::cout << "Readback - " << m_Readback->GetFenceFailCount() << " fences failed and were mapped without polling, " << m_Readback->GetMapFailCount() << " reads wouldn't map and were skipped" << std::endl;
+						}
+
+						std::cout << "Frame pool - " << m_FramePool->GetHits() << " hits, " << m_FramePool->GetMisses() << " misses, high water " << m_FramePool->GetHighWater() << " frames" << std::endl;
+
+						if (!m_OfflineActive)
+						{
+							std::cout << "Capture scheduler - " << m_CaptureScheduler.GetFramesScheduled() << " drawn frames covered " << m_CaptureScheduler.GetSlotCount() << " output frames, " << m_CaptureScheduler.GetRepeatedSlots() << " repeated without a readback (longest frame covered " << m_CaptureScheduler.GetMaxSlotsPerFrame() << ")" << std::endl;
+						}
+
+						if (m_SkipUnchangedDraws)
+						{
+							std::cout << "Draw data - " << m_SkippedReadbacks << " of " << m_FramesCaptured << " readbacks skipped as nothing was drawn differently" << std::endl;
+						}
+
+						if (m_SkipDuplicates)
+						{
+							std::cout << "Duplicate frames - " << m_DuplicateFrames << " of " << m_FramesCaptured << " frames repeated the one before" << std::endl;
+						}
+
+						std::cout << m_FramesCaptured << " frames have been recorded, attempting to write to '" << m_RenderFileName << m_RenderFileExtension << "'" << std::endl;
 
 						m_Recording = false;
 
-						std::cout << vidWrite << std::endl;
+						if (m_Streaming)
+						{
+							// only the queued frames are left to encode, finalise off the main thread
+							m_VideoWriteTask = std::async(std::launch::async, &VideoWriter::EndStreaming, vidWrite);
 
-						if (vidWrite->Init(m_RenderFilePath, m_WindowSize->x, m_WindowSize->y, m_RenderFileFPS, m_RenderFileTime, 6000000) == 0)
+							m_Saving = true;
+						}
+						else if (vidWrite->Init(m_RenderFilePath.c_str(), m_CaptureWidth, m_CaptureHeight, m_RenderFileFPS, m_RenderFileTime, 6000000) == 0)
 						{
-							m_VideoWriteTask = std::async(std::launch::async, &VideoWriter::WriteAllFrames, *vidWrite, m_StoredFrames);
+							if (m_FrameStore != nullptr)
+							{
+								// writer waits for the store to finish compressing, then decodes each frame as it encodes
+								m_VideoWriteTask = std::async(std::launch::async, &VideoWriter::WriteStoredFrames, vidWrite, m_FrameStore);
+							}
+							else
+							{
+								// hand the frames over rather than copying them, the writer returns each one to the pool once encoded
+								m_VideoWriteTask = std::async(std::launch::async, &VideoWriter::WriteAllFrames, vidWrite, std::move(m_StoredFrames));
+								m_StoredFrames.clear();
+							}
 
 							m_Saving = true;
 						}
@@ -320,19 +598,66 @@ int Graphics::Tick()
 							beginRendering = false;
 							m_Saving = false;
 
-							std::cout << "'" << m_RenderFileName << ".wmv' has successfully saved! (Path: " << m_RenderFilePath << ")" << std::endl;
+							if (m_Streaming && vidWrite != nullptr)
+							{
+								for (int i = 0; i < (int)VideoWriter::StreamStage::Count; ++i)
+								{
+									const PipelineStage& stage = vidWrite->GetStage((VideoWriter::StreamStage)i);
+
+									std::cout << "Pipeline " << VideoWriter::GetStageName((VideoWriter::StreamStage)i) << " - " << stage.GetItems() << " frames at " << stage.GetThroughput() << " fps, " << (int)(stage.GetLoad() * 100.0) << "% busy, " << stage.GetIdleMs() << "ms idle, " << stage.GetStallMs() << "ms stalled, " << stage.GetDropped() << " dropped, queue high water " << stage.GetMaxDepth() << std::endl;
+								}
+
+								std::cout << "Pipeline latency - " << vidWrite->GetAverageLatencyMs() << "ms average, " << vidWrite->GetMaxLatencyMs() << "ms worst from capture to write" << std::endl;
+							}
+
+							m_Streaming = false;
+
+							if (m_VideoWriteTask.get())
+							{
+								std::cout << "'" << m_RenderFileName << m_RenderFileExtension << "' has successfully saved! (Path: " << m_RenderFilePath << ")" << std::endl;
+							}
+							else
+							{
+								std::cout << "'" << m_RenderFileName << m_RenderFileExtension << "' failed to save! (Path: " << m_RenderFilePath << ")" << std::endl;
+							}
+
+							if (m_CloseAfterSave)
+							{
+								closeRequested = true;
+							}
+
+							if (m_FrameStore != nullptr)
+							{
+								std::cout << "Frame store - " << m_FrameStore->GetFrameCount() << " frames, " << m_FrameStore->GetRawBytes() / (1024 * 1024) << "MB compressed to " << m_FrameStore->GetCompressedBytes() / (1024 * 1024) << "MB (" << m_FrameStore->GetCompressionRatio() << ":1)" << std::endl;
+							}
+
+							if (vidWrite != nullptr && vidWrite->GetFramesEncoded() > 0)
+							{
+								std::cout << "Encoder - " << vidWrite->GetFramesEncoded() << " frames at " << vidWrite->GetEncodeFps() << " fps, " << vidWrite->GetAverageEncodeMs() << "ms per encoded frame, " << vidWrite->GetBytesOutput() / (1024 * 1024) << "MB output" << std::endl;
+							}
+
+							WriteStats writeStats;
+
+							if (vidWrite != nullptr && vidWrite->GetWriteStats(writeStats))
+							{
+								std::cout << "File writes - " << writeStats.m_Engine << ", " << writeStats.m_Chunks << " chunks, " << writeStats.m_Bytes / (1024 * 1024) << "MB, " << writeStats.m_AverageLatencyMs << "ms average, " << writeStats.m_MaxLatencyMs << "ms worst, " << writeStats.m_MaxDepth << "/" << writeStats.m_Capacity << " most in flight, " << writeStats.m_Stalls << " stalls" << std::endl;
+							}
+
+							if (vidWrite != nullptr && vidWrite->GetFramesSpilled() > 0)
+							{
+								std::cout << "Spill file - " << vidWrite->GetFramesSpilled() << " frames paged out while the encoder caught up, high water " << vidWrite->GetSpillHighWater() << " frames" << std::endl;
+							}
 
 							m_RecordDelayTime = 0;
 							m_RecordTime = 0;
 							m_RecordRefreshTime = 0.0;
+							m_RecordTicks = 0;
+							m_OfflineActive = false;
 
-							for (auto frame : m_StoredFrames)
-							{
-								if (frame != nullptr);
-								delete frame;
-							}
+							ReleaseStoredFrames();
 
-							m_StoredFrames.clear();
+							// give back anything a buffered recording or a deep queue grew the pool by
+							m_FramePool->Trim(m_StreamQueueDepth + StreamSpareFrames);
 						}
 					}
 				}
@@ -355,6 +680,12 @@ int Graphics::End()
 	/*if (m_ClearColour != nullptr)
 		delete m_ClearColour;*/
 
+	// let any save in progress finish before the writer is shut down
+	if (m_VideoWriteTask.valid())
+	{
+		m_VideoWriteTask.wait();
+	}
+
 	if (m_Parts.size() > 0)
 	{
 		for (std::shared_ptr<ModulePart> part : m_Parts)
@@ -365,13 +696,17 @@ int Graphics::End()
 
 	if (m_Init)
 	{
-		for (void* frame : m_StoredFrames)
-		{
-			if (frame != nullptr)
-				delete frame;
-		}
+		ReleaseStoredFrames();
 
-		m_StoredFrames.clear();
+		// screenshots still in flight are saved before the app closes
+		CollectScreenshots(true);
+
+		m_ScreenshotWriter = nullptr;
+		m_ScreenshotReadback = nullptr;
+
+		m_Readback = nullptr;
+		m_CaptureTargets.clear();
+		m_OffscreenTarget = nullptr;
 
 		ImGui_ImplOpenGL3_Shutdown();
 		ImGui_ImplGlfw_Shutdown();
@@ -384,116 +719,676 @@ int Graphics::End()
 	return 0;
 }
 
-void Graphics::SetupParts()
+void Graphics::BeginOffscreenFrame()
 {
-	m_Parts = {};
-
-	std::shared_ptr<Renderer> rend = std::make_shared<Renderer>(Renderer());
-
-	if (rend != nullptr)
+	if (!m_RenderOffscreen)
 	{
-		rend->Start();
+		m_OffscreenTarget = nullptr;
 
-		m_Parts.push_back(rend);
+		return;
 	}
 
-	std::shared_ptr<VideoWriter> vidWriter = std::make_shared<VideoWriter>(VideoWriter());
+	m_OffscreenSize[0] = std::clamp(m_OffscreenSize[0], 16, 8192) & ~1;
+	m_OffscreenSize[1] = std::clamp(m_OffscreenSize[1], 16, 8192) & ~1;
 
-	if (vidWriter != nullptr)
+	if (m_OffscreenTarget == nullptr || m_OffscreenTarget->GetWidth() != m_OffscreenSize[0] || m_OffscreenTarget->GetHeight() != m_OffscreenSize[1])
 	{
-		vidWriter->Start();
+		m_OffscreenTarget = std::make_shared<RenderTarget>(m_OffscreenSize[0], m_OffscreenSize[1]);
+	}
 
-		m_Parts.push_back(vidWriter);
+	int windowWidth = 0;
+	int windowHeight = 0;
+
+	glfwGetWindowSize(m_Window, &windowWidth, &windowHeight);
+
+	float x = 0.0f;
+	float y = 0.0f;
+	float scale = 1.0f;
+
+	GetPresentRect(windowWidth, windowHeight, x, y, scale);
+
+	// the target is letterboxed in the window, so mouse positions from the backend are moved into target space
+	for (ImGuiInputEvent& inputEvent : ImGui::GetCurrentContext()->InputEventsQueue)
+	{
+		if (inputEvent.Type == ImGuiInputEventType_MousePos && inputEvent.MousePos.PosX != -FLT_MAX && scale > 0.0f)
+		{
+			inputEvent.MousePos.PosX = (inputEvent.MousePos.PosX - x) / scale;
+			inputEvent.MousePos.PosY = (inputEvent.MousePos.PosY - y) / scale;
+		}
 	}
 
+	// ImGui lays out for the target, not the window
+	ImGuiIO& io = ImGui::GetIO();
+
+	io.DisplaySize = ImVec2((float)m_OffscreenSize[0], (float)m_OffscreenSize[1]);
+	io.DisplayFramebufferScale = ImVec2(1.0f, 1.0f);
 }
 
-int Graphics::SetupGLFW()
+void Graphics::PresentOffscreenFrame(const int& displayWidth, const int& displayHeight)
 {
-	glfwSetErrorCallback(GLFW_ERROR_LOG);
+	float x = 0.0f;
+	float y = 0.0f;
+	float scale = 1.0f;
 
-	if (!glfwInit())
-	{
-		std::cout << "Graphics Module - GLFW init failed!" << std::endl;
-
-		return -1;
-	}
+	GetPresentRect(displayWidth, displayHeight, x, y, scale);
 
-	m_Window = glfwCreateWindow(m_WindowSize->x, m_WindowSize->y, "OpenGL GUI and Video Renderer", NULL, NULL);
+	glViewport(0, 0, displayWidth, displayHeight);
 
-	if (m_Window == nullptr)
-	{
-		glfwTerminate();
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
 
-		std::cout << "Graphics Module - GLFW window creation failed!" << std::endl;
+	// window is y down, GL is y up, the letterbox is centred so it is the same either way
+	m_OffscreenTarget->BlitTo(0, (int)x, (int)y, (int)(m_OffscreenTarget->GetWidth() * scale), (int)(m_OffscreenTarget->GetHeight() * scale), true);
+}
 
-		return -2;
-	}
+void Graphics::GetPresentRect(const int& width, const int& height, float& x, float& y, float& scale) const
+{
+	scale = std::min((float)width / m_OffscreenSize[0], (float)height / m_OffscreenSize[1]);
 
-	glfwMakeContextCurrent(m_Window);
+	x = (width - m_OffscreenSize[0] * scale) * 0.5f;
+	y = (height - m_OffscreenSize[1] * scale) * 0.5f;
+}
 
-	// vsync off = 0 , on = 1
-	glfwSwapInterval(0);
+void Graphics::GetCaptureSize(int& width, int& height) const
+{
+	int regionX = 0;
+	int regionY = 0;
+	int regionWidth = 0;
+	int regionHeight = 0;
 
-	std::cout << "OpenGL version: " << glGetString(GL_VERSION) << std::endl;
+	// scaling applies to the region, not the whole framebuffer
+	GetCaptureRegion(regionX, regionY, regionWidth, regionHeight, false);
 
-	GLenum err = glewInit();
-	if (GLEW_OK != err)
+	switch (m_CaptureScale)
 	{
-		/* Problem: glewInit failed, something is seriously wrong. */
-		std::cout << "Error: %s\n" << (unsigned char*)glewGetErrorString(err) << std::endl;
-
-		return -3;
+	case 1:
+		width = regionWidth / 2;
+		height = regionHeight / 2;
+		break;
+	case 2:
+		width = regionWidth / 4;
+		height = regionHeight / 4;
+		break;
+	case 3:
+		width = std::min(m_CaptureCustomSize[0], regionWidth);
+		height = std::min(m_CaptureCustomSize[1], regionHeight);
+		break;
+	default:
+		width = regionWidth;
+		height = regionHeight;
+		break;
 	}
 
-	return 0;
+	// 4:2:0 encoders want even sizes, only a region at Full scale is also a whole number of 16x16 blocks
+	width = std::max(16, width & ~1);
+	height = std::max(16, height & ~1);
 }
 
-int Graphics::SetupImGUI()
+void Graphics::GetCaptureRegion(int& x, int& y, int& width, int& height, const bool& keepSize) const
 {
-	IMGUI_CHECKVERSION();
+	x = 0;
+	y = 0;
+	width = m_FramebufferWidth;
+	height = m_FramebufferHeight;
 
-	auto cont = ImGui::CreateContext();
+	if (m_CaptureRegion == 0)
+		return;
 
-	if (cont != nullptr)
+	float left = 0.0f;
+	float top = 0.0f;
+	float right = 0.0f;
+	float bottom = 0.0f;
+
+	if (m_CaptureRegion == 1)
 	{
-		ImGui::StyleColorsDark();
+		ImGuiWindow* window = ImGui::FindWindowByName(m_CaptureWindowName);
 
-		if (!ImGui_ImplGlfw_InitForOpenGL(m_Window, true))
+		if (window == nullptr || !window->Active || window->Hidden)
 		{
-			std::cout << "Graphics Module - ImGui init failed!" << std::endl;
+			// window has gone, hold the last region until it comes back
+			if (keepSize && m_SourceRect[2] > 0 && m_SourceRect[3] > 0)
+			{
+				x = m_SourceRect[0];
+				y = m_SourceRect[1];
+				width = m_SourceRect[2];
+				height = m_SourceRect[3];
+			}
 
-			return -2;
+			return;
 		}
 
-		if (!ImGui_ImplOpenGL3_Init("#version 130"))
-		{
-			std::cout << "Graphics Module - ImGui renderer backend init failed!" << std::endl;
+		// ImGui works in display units, the framebuffer may have more pixels than that
+		const ImVec2 scale = ImGui::GetIO().DisplayFramebufferScale;
 
-			return -3;
-		}
+		left = window->Pos.x * scale.x;
+		top = window->Pos.y * scale.y;
+		right = (window->Pos.x + window->Size.x) * scale.x;
+		bottom = (window->Pos.y + window->Size.y) * scale.y;
 	}
 	else
 	{
-		std::cout << "Graphics Module - ImGui failed to create a context!" << std::endl;
-
-		return -1;
+		left = (float)m_CaptureRect[0];
+		top = (float)m_CaptureRect[1];
+		right = left + m_CaptureRect[2];
+		bottom = top + m_CaptureRect[3];
 	}
 
-	return 0;
+	left = std::clamp(left, 0.0f, (float)m_FramebufferWidth);
+	top = std::clamp(top, 0.0f, (float)m_FramebufferHeight);
+	right = std::clamp(right, left, (float)m_FramebufferWidth);
+	bottom = std::clamp(bottom, top, (float)m_FramebufferHeight);
 
+	width = keepSize ? m_RegionSize[0] : (int)(right - left + 0.5f);
+	height = keepSize ? m_RegionSize[1] : (int)(bottom - top + 0.5f);
+
+	// rounded up to whole 16x16 blocks, down if that no longer fits, so a region captured at Full scale never needs padding by the encoders
+	// scaled captures are only kept even by GetCaptureSize, rounding them too would resample frames the blit already sized
+	width = (width + 15) & ~15;
+	height = (height + 15) & ~15;
+
+	if (width > m_FramebufferWidth)
+		width = m_FramebufferWidth & ~15;
+
+	if (height > m_FramebufferHeight)
+		height = m_FramebufferHeight & ~15;
+
+	width = std::max(16, width);
+	height = std::max(16, height);
+
+	// the region hangs down and right from the rect's top left corner, pushed back inside the framebuffer if it overhangs
+	x = std::clamp((int)left, 0, std::max(0, m_FramebufferWidth - width));
+	y = std::clamp(m_FramebufferHeight - (int)top - height, 0, std::max(0, m_FramebufferHeight - height));
 }
 
-void Graphics::ShowMenuBar(bool& beginRendering, bool& showRenderScreen, bool& showCurrentlyRenderingScreen, bool& showPrintedScreen, bool& showStats, bool& closeShown)
+void Graphics::SetupCaptureTargets()
 {
-	if (ImGui::BeginMenuBar())
+	m_CaptureTargets.clear();
+
+	m_CaptureSourceWidth = m_SourceRect[2];
+	m_CaptureSourceHeight = m_SourceRect[3];
+
+	int width = m_CaptureSourceWidth;
+	int height = m_CaptureSourceHeight;
+
+	// linear filtering only blends a 2x2 footprint, so step down by at most half per blit to avoid skipping pixels
+	while (width != m_CaptureWidth || height != m_CaptureHeight)
 	{
-		if (ImGui::BeginMenu("File"))
-		{
-			if (ImGui::MenuItem("Render To File..."))
-			{
-				if (!beginRendering)
-				{
+		width = width > m_CaptureWidth ? std::max(m_CaptureWidth, width / 2) : m_CaptureWidth;
+		height = height > m_CaptureHeight ? std::max(m_CaptureHeight, height / 2) : m_CaptureHeight;
+
+		m_CaptureTargets.push_back(std::make_shared<RenderTarget>(width, height));
+	}
+}
+
+bool Graphics::CaptureFrame()
+{
+	// same draw data as the last captured frame gives the same pixels, no need to read them back
+	if (m_SkipUnchangedDraws && m_HasCapturedDrawHash && m_DrawDataHash == m_CapturedDrawHash)
+	{
+		++m_SkippedReadbacks;
+
+		RepeatFrame();
+
+		return true;
+	}
+
+	// a followed window may have moved since the last capture
+	GetCaptureRegion(m_SourceRect[0], m_SourceRect[1], m_SourceRect[2], m_SourceRect[3], true);
+
+	if (m_CaptureSourceWidth != m_SourceRect[2] || m_CaptureSourceHeight != m_SourceRect[3])
+	{
+		// window changed size, the frames stay the same size and the new back buffer is scaled to fit them
+		SetupCaptureTargets();
+	}
+
+	int readX = 0;
+	int readY = 0;
+
+	if (m_CaptureTargets.empty())
+	{
+		// region is read straight out of the framebuffer, nothing outside it is copied
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_CaptureFramebuffer);
+
+		readX = m_SourceRect[0];
+		readY = m_SourceRect[1];
+	}
+	else
+	{
+		unsigned int source = m_CaptureFramebuffer;
+		int sourceX = m_SourceRect[0];
+		int sourceY = m_SourceRect[1];
+		int sourceWidth = m_CaptureSourceWidth;
+		int sourceHeight = m_CaptureSourceHeight;
+
+		for (const std::shared_ptr<RenderTarget>& target : m_CaptureTargets)
+		{
+			target->BlitFrom(source, sourceX, sourceY, sourceWidth, sourceHeight, true);
+
+			source = target->GetID();
+			sourceX = 0;
+			sourceY = 0;
+			sourceWidth = target->GetWidth();
+			sourceHeight = target->GetHeight();
+		}
+
+		m_CaptureTargets.back()->BindRead(true);
+	}
+
+	PixelReadback::ReadResult read = m_Readback->Read(readX, readY, m_CaptureWidth, m_CaptureHeight);
+
+	if (read == PixelReadback::ReadResult::RingFull)
+	{
+		// ring is full, wait for the oldest read so its buffer can be reused
+		CollectFrame(true);
+
+		read = m_Readback->Read(readX, readY, m_CaptureWidth, m_CaptureHeight);
+	}
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+	if (read == PixelReadback::ReadResult::TooLarge)
+	{
+		// collecting can't make room for this, the ring was built for a smaller capture
+		std::cout << "Readback - " << m_CaptureWidth << "x" << m_CaptureHeight << " doesn't fit the " << m_Readback->GetBufferSize() << " byte readback buffers!" << std::endl;
+
+		return false;
+	}
+
+	if (read != PixelReadback::ReadResult::Read)
+		return false;
+
+	m_ReadRepeats.emplace_back();
+
+	m_CapturedDrawHash = m_DrawDataHash;
+	m_HasCapturedDrawHash = m_SkipUnchangedDraws;
+
+	return true;
+}
+
+bool Graphics::CollectFrame(const bool& wait)
+{
+	// the oldest read's time has to be taken before mapping, a read that fails to map is dropped from the ring
+	const int pending = m_Readback->GetPending();
+	const std::chrono::steady_clock::time_point readAt = m_Readback->GetOldestReadTime();
+
+	const void* mapData = m_Readback->Map(wait);
+
+	if (mapData != nullptr)
+	{
+		StoreFrame(mapData, readAt);
+
+		m_Readback->Unmap();
+	}
+	else if (m_Readback->GetPending() < pending)
+	{
+		// the read was skipped rather than still in flight, the last stored frame stands in for it so timing holds
+		SubmitFrame(FrameHandle(), readAt);
+	}
+	else
+	{
+		return false;
+	}
+
+	// any captures skipped while this read was in flight follow it
+	if (!m_ReadRepeats.empty())
+	{
+		for (const std::chrono::steady_clock::time_point& capturedAt : m_ReadRepeats.front())
+		{
+			SubmitFrame(FrameHandle(), capturedAt);
+		}
+
+		m_ReadRepeats.pop_front();
+	}
+
+	return true;
+}
+
+void Graphics::StoreFrame(const void* frameData, const std::chrono::steady_clock::time_point& capturedAt)
+{
+	FrameHandle frameCopy;
+
+	const uint64_t hash = m_SkipDuplicates ? FrameHasher::Hash(frameData, m_BufferSize) : 0;
+
+	if (m_SkipDuplicates && m_HasLastFrameHash && hash == m_LastFrameHash)
+	{
+		// an empty handle tells the writer to repeat the last frame
+		++m_DuplicateFrames;
+	}
+	else
+	{
+		frameCopy = m_FramePool->Acquire();
+
+		if (!frameCopy || m_BufferSize > m_FramePool->GetSlabSize())
+		{
+			// nothing was kept, so the next frame can't be a repeat of this one
+			m_HasLastFrameHash = false;
+
+			return;
+		}
+
+		std::memcpy(frameCopy.GetData(), frameData, m_BufferSize);
+
+		m_LastFrameHash = hash;
+		m_HasLastFrameHash = m_SkipDuplicates;
+	}
+
+	SubmitFrame(std::move(frameCopy), capturedAt);
+}
+
+void Graphics::RepeatFrame()
+{
+	if (m_ReadRepeats.empty())
+	{
+		SubmitFrame(FrameHandle(), std::chrono::steady_clock::now());
+	}
+	else
+	{
+		// the frame being repeated is still in the readback ring
+		m_ReadRepeats.back().push_back(std::chrono::steady_clock::now());
+	}
+}
+
+void Graphics::SubmitFrame(FrameHandle frame, const std::chrono::steady_clock::time_point& capturedAt)
+{
+	VideoWriter* vidWrite = (VideoWriter*)m_Parts[1].get();
+
+	++m_FramesCaptured;
+
+	if (m_Streaming && vidWrite != nullptr)
+	{
+		// writer takes ownership of the frame and returns it to the pool once encoded
+		vidWrite->QueueFrame(std::move(frame), capturedAt);
+	}
+	else if (m_FrameStore != nullptr)
+	{
+		// the store's worker compresses the frame and gives the slab back
+		m_FrameStore->Push(std::move(frame));
+	}
+	else
+	{
+		m_StoredFrames.push_back(std::move(frame));
+	}
+}
+
+uint64_t Graphics::HashDrawData(const int& width, const int& height) const
+{
+	ImDrawData* drawData = ImGui::GetDrawData();
+
+	uint64_t hash = FrameHasher::Combine(0, ((uint64_t)width << 32) | (uint32_t)height);
+
+	const float clear[4] = { m_ClearColour->x, m_ClearColour->y, m_ClearColour->z, m_ClearColour->w };
+	hash = FrameHasher::Combine(hash, FrameHasher::Hash(clear, sizeof(clear)));
+
+	if (drawData == nullptr || !drawData->Valid)
+		return hash;
+
+	const float display[6] = { drawData->DisplayPos.x, drawData->DisplayPos.y, drawData->DisplaySize.x, drawData->DisplaySize.y, drawData->FramebufferScale.x, drawData->FramebufferScale.y };
+	hash = FrameHasher::Combine(hash, FrameHasher::Hash(display, sizeof(display)));
+
+	for (int i = 0; i < drawData->CmdListsCount; ++i)
+	{
+		const ImDrawList* cmdList = drawData->CmdLists[i];
+
+		hash = FrameHasher::Combine(hash, FrameHasher::Hash(cmdList->VtxBuffer.Data, cmdList->VtxBuffer.Size * sizeof(ImDrawVert)));
+		hash = FrameHasher::Combine(hash, FrameHasher::Hash(cmdList->IdxBuffer.Data, cmdList->IdxBuffer.Size * sizeof(ImDrawIdx)));
+
+		for (const ImDrawCmd& cmd : cmdList->CmdBuffer)
+		{
+			// a callback could draw anything, so treat the frame as changed
+			if (cmd.UserCallback != nullptr)
+				return ~m_CapturedDrawHash;
+
+			// hashed field by field, the struct has padding
+			const float clip[4] = { cmd.ClipRect.x, cmd.ClipRect.y, cmd.ClipRect.z, cmd.ClipRect.w };
+
+			hash = FrameHasher::Combine(hash, FrameHasher::Hash(clip, sizeof(clip)));
+			hash = FrameHasher::Combine(hash, (uint64_t)(uintptr_t)cmd.TextureId);
+			hash = FrameHasher::Combine(hash, ((uint64_t)cmd.VtxOffset << 32) | cmd.IdxOffset);
+			hash = FrameHasher::Combine(hash, cmd.ElemCount);
+		}
+	}
+
+	return hash;
+}
+
+void Graphics::ReleaseStoredFrames()
+{
+	// handles give their slabs back to the pool
+	m_StoredFrames.clear();
+
+	m_FrameStore = nullptr;
+}
+
+void Graphics::CaptureScreenshot()
+{
+	const unsigned int bufferSize = (unsigned int)(m_FramebufferWidth * m_FramebufferHeight * 4);
+
+	if (m_ScreenshotReadback == nullptr || m_ScreenshotReadback->GetBufferSize() != bufferSize)
+	{
+		// the window changed size, anything still in the old ring is saved before it goes
+		CollectScreenshots(true);
+
+		m_ScreenshotReadback = std::make_shared<PixelReadback>(bufferSize, PixelReadback::MinDepth);
+	}
+
+	// same read the recording uses, whole framebuffer rather than the scaled capture size
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_CaptureFramebuffer);
+
+	const PixelReadback::ReadResult read = m_ScreenshotReadback->Read(0, 0, m_FramebufferWidth, m_FramebufferHeight);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+	if (read == PixelReadback::ReadResult::TooLarge)
+	{
+		// no later frame would fit either, so the request is dropped rather than retried forever
+		std::cout << "Screenshot - " << m_FramebufferWidth << "x" << m_FramebufferHeight << " doesn't fit the readback buffers, skipped" << std::endl;
+
+		m_ScreenshotRequest = -1;
+
+		return;
+	}
+
+	// ring is full, the request stays for the next frame rather than stalling this one
+	if (read != PixelReadback::ReadResult::Read)
+		return;
+
+	PendingScreenshot pending;
+	pending.m_Width = m_FramebufferWidth;
+	pending.m_Height = m_FramebufferHeight;
+	pending.m_Format = m_ScreenshotRequest;
+
+	m_PendingScreenshots.push_back(pending);
+
+	m_ScreenshotRequest = -1;
+}
+
+void Graphics::CollectScreenshots(const bool& wait)
+{
+	while (!m_PendingScreenshots.empty() && m_ScreenshotReadback != nullptr)
+	{
+		const void* mapData = m_ScreenshotReadback->Map(wait);
+
+		if (mapData == nullptr)
+		{
+			// a failed map is dropped by the ring, only keep waiting on a read that is still there
+			if (m_ScreenshotReadback->GetPending() < (int)m_PendingScreenshots.size())
+			{
+				m_PendingScreenshots.pop_front();
+
+				continue;
+			}
+
+			return;
+		}
+
+		const PendingScreenshot pending = m_PendingScreenshots.front();
+		m_PendingScreenshots.pop_front();
+
+		// the one copy made on this thread, compressing and writing happen on the writer's
+		std::vector<uint8_t> pixels = m_ScreenshotWriter->AcquireBuffer((size_t)pending.m_Width * pending.m_Height * 4);
+		std::memcpy(pixels.data(), mapData, pixels.size());
+
+		m_ScreenshotReadback->Unmap();
+
+		const ImageFormat format = (ImageFormat)pending.m_Format;
+
+		std::time_t now = std::time(nullptr);
+		std::tm local{};
+#ifdef _WIN32
+		localtime_s(&local, &now);
+#else
+		localtime_r(&now, &local);
+#endif
+
+		char timestamp[32]{};
+		std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H-%M-%S", &local);
+
+		const std::string filePath = m_ScreenshotFilePathBase + "/Screenshot " + timestamp + " (" + std::to_string(++m_ScreenshotCount) + ")" + ImageEncoder::GetFileExtension(format);
+
+		if (!m_ScreenshotWriter->Submit(std::move(pixels), pending.m_Width, pending.m_Height, format, filePath))
+		{
+			std::cout << "Screenshot - Too many screenshots waiting to be saved, skipped '" << filePath << "'" << std::endl;
+		}
+	}
+}
+
+void Graphics::SetupParts()
+{
+	m_Parts = {};
+
+	std::shared_ptr<Renderer> rend = std::make_shared<Renderer>(Renderer());
+
+	if (rend != nullptr)
+	{
+		rend->Start();
+
+		m_Parts.push_back(rend);
+	}
+
+	std::shared_ptr<VideoWriter> vidWriter = std::make_shared<VideoWriter>();
+
+	if (vidWriter != nullptr)
+	{
+		vidWriter->Start();
+
+		m_Parts.push_back(vidWriter);
+	}
+
+}
+
+int Graphics::SetupGLFW()
+{
+	glfwSetErrorCallback(GLFW_ERROR_LOG);
+
+#ifdef GLFW_PLATFORM_NULL
+	// glfw 3.4 can run with no window system at all, its null platform only pairs with an osmesa context
+	if (m_Options.m_Headless && m_Options.m_SoftwareContext)
+	{
+		glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+	}
+#endif
+
+	if (!glfwInit())
+	{
+		std::cout << "Graphics Module - GLFW init failed!" << std::endl;
+
+#ifndef _WIN32
+		// a hidden window is still a window, glfw 3.3 won't start without an X11 or Wayland display to put it on
+		if (std::getenv("DISPLAY") == nullptr && std::getenv("WAYLAND_DISPLAY") == nullptr)
+		{
+			std::cout << "Graphics Module - No display found, --headless still needs one, run under a virtual one e.g. 'xvfb-run -a OpenGLVideoTest --headless ...'" << std::endl;
+		}
+#endif
+
+		return -1;
+	}
+
+	if (m_Options.m_Headless)
+	{
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	}
+
+	if (m_Options.m_SoftwareContext)
+	{
+		// needs an OSMesa build (libOSMesa / osmesa.dll) next to the app
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+	}
+
+	m_Window = glfwCreateWindow(m_WindowSize->x, m_WindowSize->y, "OpenGL GUI and Video Renderer", NULL, NULL);
+
+	if (m_Window == nullptr)
+	{
+		glfwTerminate();
+
+		std::cout << "Graphics Module - GLFW window creation failed!" << std::endl;
+
+		return -2;
+	}
+
+	glfwMakeContextCurrent(m_Window);
+
+	// vsync off = 0 , on = 1
+	glfwSwapInterval(0);
+
+	std::cout << "OpenGL version: " << glGetString(GL_VERSION) << std::endl;
+
+	GLenum err = glewInit();
+	if (GLEW_OK != err)
+	{
+		/* Problem: glewInit failed, something is seriously wrong. */
+		std::cout << "Error: %s\n" << (unsigned char*)glewGetErrorString(err) << std::endl;
+
+		return -3;
+	}
+
+	return 0;
+}
+
+int Graphics::SetupImGUI()
+{
+	IMGUI_CHECKVERSION();
+
+	auto cont = ImGui::CreateContext();
+
+	if (cont != nullptr)
+	{
+		ImGui::StyleColorsDark();
+
+		if (!ImGui_ImplGlfw_InitForOpenGL(m_Window, true))
+		{
+			std::cout << "Graphics Module - ImGui init failed!" << std::endl;
+
+			return -2;
+		}
+
+		if (!ImGui_ImplOpenGL3_Init("#version 130"))
+		{
+			std::cout << "Graphics Module - ImGui renderer backend init failed!" << std::endl;
+
+			return -3;
+		}
+	}
+	else
+	{
+		std::cout << "Graphics Module - ImGui failed to create a context!" << std::endl;
+
+		return -1;
+	}
+
+	return 0;
+
+}
+
+void Graphics::ShowMenuBar(bool& beginRendering, bool& showRenderScreen, bool& showCurrentlyRenderingScreen, bool& showPrintedScreen, bool& showStats, bool& closeShown)
+{
+	if (ImGui::BeginMenuBar())
+	{
+		if (ImGui::BeginMenu("File"))
+		{
+			if (ImGui::MenuItem("Render To File..."))
+			{
+				if (!beginRendering)
+				{
 					showRenderScreen = true;
 				}
 				else
@@ -502,6 +1397,21 @@ void Graphics::ShowMenuBar(bool& beginRendering, bool& showRenderScreen, bool& s
 				}
 			}
 
+			if (ImGui::BeginMenu("Capture Screenshot"))
+			{
+				if (ImGui::MenuItem("PNG", "F12"))
+				{
+					m_ScreenshotRequest = (int)ImageFormat::PNG;
+				}
+
+				if (ImGui::MenuItem("QOI", "Shift+F12"))
+				{
+					m_ScreenshotRequest = (int)ImageFormat::QOI;
+				}
+
+				ImGui::EndMenu();
+			}
+
 			if (ImGui::BeginMenu("Print Info"))
 			{
 				if (ImGui::MenuItem("Print OpenGL Info"))
@@ -522,6 +1432,24 @@ void Graphics::ShowMenuBar(bool& beginRendering, bool& showRenderScreen, bool& s
 					showPrintedScreen = true;
 				}
 
+				if (ImGui::MenuItem("Print Colour Conversion Benchmark"))
+				{
+					PrintConversionBenchmark();
+					showPrintedScreen = true;
+				}
+
+				if (ImGui::MenuItem("Print MJPEG Encoder Benchmark"))
+				{
+					PrintMJPEGBenchmark();
+					showPrintedScreen = true;
+				}
+
+				if (ImGui::MenuItem("Print Screen Codec Benchmark"))
+				{
+					m_ScreenCodecBenchmarkRequest = true;
+					showPrintedScreen = true;
+				}
+
 				if (ImGui::MenuItem("Print something fun :)"))
 				{
 					PrintSomethingFun();
@@ -546,6 +1474,11 @@ void Graphics::ShowMenuBar(bool& beginRendering, bool& showRenderScreen, bool& s
 
 		ImGui::EndMenuBar();
 	}
+
+	if (ImGui::IsKeyPressed(ImGuiKey_F12, false))
+	{
+		m_ScreenshotRequest = ImGui::GetIO().KeyShift ? (int)ImageFormat::QOI : (int)ImageFormat::PNG;
+	}
 }
 
 void Graphics::ShowStatsWindow()
@@ -572,39 +1505,242 @@ void Graphics::ShowStatsWindow()
 		// plot delta time of frame in ms
 		while (refresh_time < ImGui::GetTime()) // Create data at fixed 60Hz rate
 		{
-			values[values_offset] = ImGui::GetIO().DeltaTime * 1000;
-			values_offset = (values_offset + 1) % IM_ARRAYSIZE(values);
-			refresh_time += 1.0f / 60.0f;
+			values[values_offset] = ImGui::GetIO().DeltaTime * 1000;
+			values_offset = (values_offset + 1) % IM_ARRAYSIZE(values);
+			refresh_time += 1.0f / 60.0f;
+		}
+
+		// set graph overlay text
+		{
+			char avg[64];
+
+			snprintf(avg, sizeof(avg), "Average Frame Time: %.5fms (FPS: %f)", m_CumulativeFrameTime / ImGui::GetFrameCount(), ImGui::GetIO().Framerate);
+
+			//std::string overlay_text = "Average Frame Time: " + std::to_chars(1000.0f / ImGui::GetIO().Framerate) + "ms (FPS: " + std::to_string(ImGui::GetIO().Framerate) + ")";
+
+			ImGui::PlotLines("", values, IM_ARRAYSIZE(values), values_offset, avg, 0.0f, 5.0f, ImVec2(0, 100.0f));
+		}
+
+		if (m_FramePool != nullptr)
+		{
+			ImGui::Text("Frame pool: %llu hits, %llu misses, %zu/%zu frames in use (high water %zu)", m_FramePool->GetHits(), m_FramePool->GetMisses(), m_FramePool->GetOutstanding(), m_FramePool->GetSlabCount(), m_FramePool->GetHighWater());
+		}
+
+		if (m_FrameStore != nullptr)
+		{
+			ImGui::Text("Frame store: %zu frames, %.1fMB compressed to %.1fMB (%.1f:1), %zu waiting", m_FrameStore->GetFrameCount(), m_FrameStore->GetRawBytes() / (1024.0 * 1024.0), m_FrameStore->GetCompressedBytes() / (1024.0 * 1024.0), m_FrameStore->GetCompressionRatio(), m_FrameStore->GetPending());
+		}
+
+		if (m_Recording && !m_OfflineActive)
+		{
+			ImGui::Text("Capture scheduler: %llu drawn frames covered %llu output frames (%llu repeated, longest covered %u)", m_CaptureScheduler.GetFramesScheduled(), m_CaptureScheduler.GetSlotCount(), m_CaptureScheduler.GetRepeatedSlots(), m_CaptureScheduler.GetMaxSlotsPerFrame());
+		}
+
+		VideoWriter* vidWrite = (VideoWriter*)m_Parts[1].get();
+
+		if (m_Streaming && vidWrite != nullptr && ImGui::BeginTable("Pipeline Table", 8, ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders))
+		{
+			// the stage with the highest load is the one limiting sustained fps, the ones before it stall
+			ImGui::TableSetupColumn("Stage");
+			ImGui::TableSetupColumn("Queue");
+			ImGui::TableSetupColumn("Frames");
+			ImGui::TableSetupColumn("FPS");
+			ImGui::TableSetupColumn("Load");
+			ImGui::TableSetupColumn("Idle (ms)");
+			ImGui::TableSetupColumn("Stalled (ms)");
+			ImGui::TableSetupColumn("Dropped");
+			ImGui::TableHeadersRow();
+
+			for (int i = 0; i < (int)VideoWriter::StreamStage::Count; ++i)
+			{
+				const PipelineStage& stage = vidWrite->GetStage((VideoWriter::StreamStage)i);
+
+				ImGui::TableNextRow();
+				ImGui::TableSetColumnIndex(0);
+				ImGui::Text("%s", VideoWriter::GetStageName((VideoWriter::StreamStage)i));
+				ImGui::TableSetColumnIndex(1);
+
+				if (stage.GetCapacity() > 0)
+					ImGui::Text("%zu/%zu (max %zu)", stage.GetDepth(), stage.GetCapacity(), stage.GetMaxDepth());
+				else
+					ImGui::Text("-");
+
+				ImGui::TableSetColumnIndex(2);
+				ImGui::Text("%llu", stage.GetItems());
+				ImGui::TableSetColumnIndex(3);
+				ImGui::Text("%.1f", stage.GetThroughput());
+				ImGui::TableSetColumnIndex(4);
+				ImGui::Text("%.0f%%", stage.GetLoad() * 100.0);
+				ImGui::TableSetColumnIndex(5);
+				ImGui::Text("%.1f", stage.GetIdleMs());
+				ImGui::TableSetColumnIndex(6);
+				ImGui::Text("%.1f", stage.GetStallMs());
+				ImGui::TableSetColumnIndex(7);
+				ImGui::Text("%llu", stage.GetDropped());
+			}
+
+			ImGui::EndTable();
+
+			ImGui::Text("Capture to write latency: %.1fms average, %.1fms worst", vidWrite->GetAverageLatencyMs(), vidWrite->GetMaxLatencyMs());
+		}
+
+		WriteStats writeStats;
+
+		// a disk that can't keep up shows as chunks waiting at full depth and stalls, before it ever holds up the encoder
+		if (vidWrite != nullptr && vidWrite->GetWriteStats(writeStats))
+		{
+			ImGui::Text("File writes (%s): %llu chunks, %llu MB, %.1fms average, %.1fms worst, %zu/%zu in flight (max %zu), %llu stalls", writeStats.m_Engine, writeStats.m_Chunks, writeStats.m_Bytes / (1024 * 1024), writeStats.m_AverageLatencyMs, writeStats.m_MaxLatencyMs, writeStats.m_Depth, writeStats.m_Capacity, writeStats.m_MaxDepth, writeStats.m_Stalls);
+		}
+
+		if (m_Readback != nullptr)
+		{
+			ImGui::Text("Readback: %llu reads, %llu fence polls still pending, %llu ring stalls (depth %d, %d in flight)", m_Readback->GetReadCount(), m_Readback->GetFencePendingCount(), m_Readback->GetStallCount(), m_Readback->GetDepth(), m_Readback->GetPending());
+		}
+
+		if (m_ScreenshotWriter != nullptr && m_ScreenshotWriter->GetSaved() > 0)
+		{
+			ImGui::Text("Screenshots: %llu saved, %zu waiting, last was %llu KB, compressed in %.1fms and written in %.1fms", m_ScreenshotWriter->GetSaved(), m_ScreenshotWriter->GetPending() + m_PendingScreenshots.size(), m_ScreenshotWriter->GetLastBytes() / 1024, m_ScreenshotWriter->GetLastEncodeMs(), m_ScreenshotWriter->GetLastWriteMs());
+		}
+	}
+}
+
+int Graphics::ShowRenderToFileWindow()
+{
+	if (ImGui::BeginPopupModal("Render To File...", NULL, ImGuiWindowFlags_AlwaysAutoResize))
+	{
+		static char tmpBuf[16]{ 0 };
+
+		ImGui::InputTextWithHint("File Name", "Please enter file name...", tmpBuf, IM_ARRAYSIZE(tmpBuf));
+		ImGui::InputInt("Frame Rate (FPS)", &m_RenderFileFPS);
+		ImGui::InputInt("Time (Seconds)", &m_RenderFileTime);
+		ImGui::InputInt("Delay (Seconds)", &m_RenderFileDelay);
+		ImGui::Combo("Output", &m_RenderOutput, "File\0Live (Loopback TCP)\0Live (Named Pipe)\0");
+
+		if (m_RenderOutput == 1)
+		{
+			ImGui::InputInt("Port", &m_LivePort);
+
+			m_LivePort = std::clamp(m_LivePort, 1, 65535);
+		}
+		else if (m_RenderOutput == 2)
+		{
+			ImGui::InputText("Pipe Name", m_LivePipeName, IM_ARRAYSIZE(m_LivePipeName));
+		}
+
+		// a viewer can't wait for the recording to end
+		const bool streamEncode = m_StreamEncode || m_RenderOutput != 0;
+
+		if (m_RenderOutput != 0)
+		{
+			ImGui::Text("Live output is encoded while recording, with Y4M unless Raw I420, MJPEG or Screen Codec is picked");
+		}
+		else
+		{
+			ImGui::Checkbox("Encode While Recording", &m_StreamEncode);
+		}
+
+		ImGui::Checkbox("Skip Duplicate Frames", &m_SkipDuplicates);
+		ImGui::Checkbox("Offline (Fixed Time Step)", &m_OfflineRender);
+		ImGui::Checkbox("Skip Unchanged Draws", &m_SkipUnchangedDraws);
+		ImGui::SliderInt("Readback Depth", &m_ReadbackDepth, PixelReadback::MinDepth, PixelReadback::MaxDepth);
+		ImGui::Combo("Capture Region", &m_CaptureRegion, "Whole Frame\0ImGui Window\0Fixed Rect\0");
+
+		if (m_CaptureRegion == 1)
+		{
+			// followed every frame, the region keeps the window's size from when recording starts
+			ImGui::InputText("Window Name", m_CaptureWindowName, IM_ARRAYSIZE(m_CaptureWindowName));
+		}
+		else if (m_CaptureRegion == 2)
+		{
+			ImGui::InputInt4("Region X/Y/Width/Height", m_CaptureRect);
+		}
+
+		ImGui::Combo("Capture Size", &m_CaptureScale, "Full\0Half\0Quarter\0Custom\0");
+
+		if (m_CaptureScale == 3)
+		{
+			ImGui::InputInt2("Capture Width/Height", m_CaptureCustomSize);
+		}
+
+		ImGui::Checkbox("Render Offscreen", &m_RenderOffscreen);
+
+		if (m_RenderOffscreen)
+		{
+			// window size no longer matters, the UI is drawn at this size and scaled into the window
+			ImGui::InputInt2("Offscreen Width/Height", m_OffscreenSize);
+		}
+
+		int captureWidth = 0;
+		int captureHeight = 0;
+
+		GetCaptureSize(captureWidth, captureHeight);
+
+		ImGui::Text("Frames will be %dx%d (%.2fMB each)", captureWidth, captureHeight, captureWidth * captureHeight * 4 / (1024.0f * 1024.0f));
+		ImGui::Combo("Colour Matrix", &m_RenderFileMatrix, "BT.601\0BT.709\0");
+
+		if (ImGui::BeginCombo("Encoder", EncoderBackend::GetName((EncoderType)m_RenderFileEncoder)))
+		{
+			for (int i = 0; i < (int)EncoderType::Count; ++i)
+			{
+				// backends this platform can't run are listed but can't be picked
+				const bool available = EncoderBackend::IsAvailable((EncoderType)i);
+
+				if (ImGui::Selectable(EncoderBackend::GetName((EncoderType)i), i == m_RenderFileEncoder, available ? 0 : ImGuiSelectableFlags_Disabled))
+				{
+					m_RenderFileEncoder = i;
+				}
+			}
+
+			ImGui::EndCombo();
+		}
+
+		if (m_RenderFileEncoder == (int)EncoderType::MJPEG)
+		{
+			ImGui::SliderInt("JPEG Quality", &m_RenderFileQuality, 1, 100);
+		}
+
+		if (streamEncode && (m_RenderFileEncoder == (int)EncoderType::MJPEG || m_RenderFileEncoder == (int)EncoderType::Screen))
+		{
+			// frames are encoded one at a time while recording, each is cut into slices or bands encoded side by side
+			ImGui::SliderInt("Encode Threads", &m_RenderFileThreads, 1, std::max(1, (int)std::thread::hardware_concurrency()));
 		}
 
-		// set graph overlay text
+		if (streamEncode)
 		{
-			char avg[64];
+			ImGui::InputInt("Queue Memory (MB)", &m_StreamMemoryMB);
+			ImGui::Checkbox("Spill To Disk", &m_SpillToDisk);
 
-			sprintf_s(avg, "Average Frame Time: %.5fms (FPS: %f)", m_CumulativeFrameTime / ImGui::GetFrameCount(), ImGui::GetIO().Framerate);
+			if (m_SpillToDisk)
+			{
+				// allocated up front in the videos folder and deleted when the recording has been saved
+				ImGui::InputInt("Spill File (MB)", &m_SpillFileMB);
+			}
 
-			//std::string overlay_text = "Average Frame Time: " + std::to_chars(1000.0f / ImGui::GetIO().Framerate) + "ms (FPS: " + std::to_string(ImGui::GetIO().Framerate) + ")";
+			// offline recordings always wait on the encoder
+			ImGui::BeginDisabled(m_OfflineRender);
+			ImGui::Combo("When Queue Is Full", &m_StreamQueuePolicy, "Block\0Drop Oldest\0Drop Newest\0");
+			ImGui::EndDisabled();
 
-			ImGui::PlotLines("", values, IM_ARRAYSIZE(values), values_offset, avg, 0.0f, 5.0f, ImVec2(0, 100.0f));
-		}
-	}
-}
+			if (m_StreamMemoryMB < 16)
+				m_StreamMemoryMB = 16;
 
-int Graphics::ShowRenderToFileWindow()
-{
-	if (ImGui::BeginPopupModal("Render To File...", NULL, ImGuiWindowFlags_AlwaysAutoResize))
-	{
-		static char tmpBuf[16]{ 0 };
+			if (m_SpillFileMB < 64)
+				m_SpillFileMB = 64;
+		}
+		else
+		{
+			// stored frames can be cut into segments and saved on several threads, if the encoder allows it
+			ImGui::SliderInt("Save Threads", &m_RenderFileThreads, 1, std::max(1, (int)std::thread::hardware_concurrency()));
+			ImGui::Checkbox("Compress Stored Frames", &m_CompressFrames);
+		}
 
-		ImGui::InputTextWithHint("File Name", "Please enter file name...", tmpBuf, IM_ARRAYSIZE(tmpBuf));
-		ImGui::InputInt("Frame Rate (FPS)", &m_RenderFileFPS);
-		ImGui::InputInt("Time (Seconds)", &m_RenderFileTime);
-		ImGui::InputInt("Delay (Seconds)", &m_RenderFileDelay);
+		// stored frames are kept in memory until the recording ends, streamed or compressed frames are not as heavy
+		const int maxFPS = streamEncode || m_CompressFrames ? 60 : 30;
 
 		if (m_RenderFileFPS < 1)
 			m_RenderFileFPS = 1;
-		else if (m_RenderFileFPS > 30)
-			m_RenderFileFPS = 30;
+		else if (m_RenderFileFPS > maxFPS)
+			m_RenderFileFPS = maxFPS;
 
 		if (m_RenderFileTime < 1)
 			m_RenderFileTime = 1;
@@ -627,7 +1763,20 @@ int Graphics::ShowRenderToFileWindow()
 				{
 					std::copy_n(tmpBuf, 16, m_RenderFileName);
 
-					sprintf_s(m_RenderFilePath, "%s\\Videos\\%s.wmv", std::filesystem::current_path().string().c_str(), m_RenderFileName);
+					m_RenderFileExtension = EncoderBackend::GetFileExtension((EncoderType)m_RenderFileEncoder);
+
+					if (m_RenderOutput == 1)
+					{
+						m_RenderFilePath = "tcp://" + std::to_string(m_LivePort);
+					}
+					else if (m_RenderOutput == 2)
+					{
+						m_RenderFilePath = std::string("pipe://") + m_LivePipeName;
+					}
+					else
+					{
+						m_RenderFilePath = m_RenderFilePathBase + "/" + m_RenderFileName + m_RenderFileExtension;
+					}
 
 					ImGui::CloseCurrentPopup();
 
@@ -647,7 +1796,7 @@ int Graphics::ShowRenderToFileWindow()
 		return 0;
 	}
 
-
+	return 0;
 }
 
 int Graphics::ShowExitWindow()
@@ -676,7 +1825,7 @@ int Graphics::ShowExitWindow()
 		return 0;
 	}
 
-
+	return 0;
 }
 
 int Graphics::ShowOverwriteWindow()
@@ -684,7 +1833,7 @@ int Graphics::ShowOverwriteWindow()
 	if (ImGui::BeginPopupModal("Overwite existing file?", NULL, ImGuiWindowFlags_AlwaysAutoResize))
 	{
 		char message[128] = "";
-		sprintf_s(message, "'%s' already exists, rendering will overwrite this file!\n\n", m_RenderFileName);
+		snprintf(message, sizeof(message), "'%s' already exists, rendering will overwrite this file!\n\n", m_RenderFileName);
 
 		ImGui::TextWrapped(message);
 		ImGui::Text("Are you sure you want to continue?\n\n");
@@ -708,6 +1857,8 @@ int Graphics::ShowOverwriteWindow()
 
 		return 0;
 	}
+
+	return 0;
 }
 
 int Graphics::ShowPrintCompleteWindow()
@@ -729,6 +1880,8 @@ int Graphics::ShowPrintCompleteWindow()
 
 		return 0;
 	}
+
+	return 0;
 }
 
 int Graphics::ShowCurrentlyRenderingWindow()
@@ -736,7 +1889,7 @@ int Graphics::ShowCurrentlyRenderingWindow()
 	if (ImGui::BeginPopupModal("Rendering still in progress!", NULL, ImGuiWindowFlags_AlwaysAutoResize))
 	{
 		char message[128] = "";
-		sprintf_s(message, "Cannot start another render yet, render of '%s' still in progress!\n\n", m_RenderFileName);
+		snprintf(message, sizeof(message), "Cannot start another render yet, render of '%s' still in progress!\n\n", m_RenderFileName);
 
 		ImGui::TextWrapped(message);
 		ImGui::Separator();
@@ -753,17 +1906,120 @@ int Graphics::ShowCurrentlyRenderingWindow()
 
 		return 0;
 	}
+
+	return 0;
 }
 
 void Graphics::ShowRecordingStatus(const bool& isRecording, const bool& isWriting, const bool& isDelayed, const float& renderDelay)
 {
+	VideoWriter* vidWrite = (VideoWriter*)m_Parts[1].get();
+
 	if (isRecording)
 	{
-		ImGui::Text("Recording '%s.wmv'... %d", m_RenderFileName, (int)m_RecordTime);
+		RecordingStatus& status = m_RecordingStatus;
+
+		if (status.m_Second != (int)m_RecordTime)
+		{
+			status.m_Second = (int)m_RecordTime;
+			status.m_FramesEncoded = vidWrite != nullptr ? vidWrite->GetFramesStreamed() : 0;
+			status.m_FramesCaptured = m_FramesCaptured;
+			status.m_DuplicateFrames = m_DuplicateFrames;
+			status.m_SkippedReadbacks = m_SkippedReadbacks;
+			status.m_FramesSpilled = vidWrite != nullptr ? vidWrite->GetFramesSpilled() : 0;
+			status.m_SpillQueued = vidWrite != nullptr ? vidWrite->GetSpillQueued() : 0;
+			status.m_LatencyMs = vidWrite != nullptr ? vidWrite->GetAverageLatencyMs() : 0.0;
+			status.m_CompressionRatio = m_FrameStore != nullptr ? m_FrameStore->GetCompressionRatio() : 0.0;
+
+			if (vidWrite != nullptr)
+			{
+				status.m_FramesRemaining = vidWrite->GetFramesRemaining();
+				status.m_BytesOutput = vidWrite->GetBytesOutput();
+				status.m_EncodeFps = vidWrite->GetEncodeFps();
+				status.m_EncodeMs = vidWrite->GetAverageEncodeMs();
+			}
+		}
+
+		if (m_OfflineActive)
+		{
+			// only the tick count, the other counters depend on how quickly the GPU and encoder keep up
+			ImGui::Text("Recording '%s%s' offline... frame %u/%d", m_RenderFileName, m_RenderFileExtension, m_RecordTicks, m_RenderFileFPS * m_RenderFileTime);
+		}
+		else if (m_Streaming && OutputSink::IsLiveTarget(m_RenderFilePath))
+		{
+			ImGui::Text("Streaming live to '%s'... %d (%u frames sent, %.0fms behind capture)", m_RenderFilePath.c_str(), status.m_Second, status.m_FramesEncoded, status.m_LatencyMs);
+		}
+		else if (m_Streaming && vidWrite != nullptr)
+		{
+			ImGui::Text("Recording '%s%s'... %d (%u/%u frames encoded)", m_RenderFileName, m_RenderFileExtension, status.m_Second, status.m_FramesEncoded, status.m_FramesCaptured);
+
+			// an encoder that can't keep up shows here as frames behind growing every second
+			ImGui::Text("Encoder: %.1f fps, %.2fms per frame, %.1fMB written, %u frames behind", status.m_EncodeFps, status.m_EncodeMs, status.m_BytesOutput / (1024.0 * 1024.0), status.m_FramesRemaining);
+		}
+		else if (m_FrameStore != nullptr)
+		{
+			ImGui::Text("Recording '%s%s'... %d (%u frames stored, %.1f:1)", m_RenderFileName, m_RenderFileExtension, status.m_Second, status.m_FramesCaptured, status.m_CompressionRatio);
+		}
+		else
+		{
+			ImGui::Text("Recording '%s%s'... %d", m_RenderFileName, m_RenderFileExtension, status.m_Second);
+		}
+
+		if (status.m_DuplicateFrames > 0 && !m_OfflineActive)
+		{
+			ImGui::SameLine();
+			ImGui::Text("(%u duplicate frames dropped)", status.m_DuplicateFrames);
+		}
+
+		if (status.m_SkippedReadbacks > 0 && !m_OfflineActive)
+		{
+			ImGui::SameLine();
+			ImGui::Text("(%u readbacks skipped)", status.m_SkippedReadbacks);
+		}
+
+		if (status.m_FramesSpilled > 0 && m_Streaming)
+		{
+			ImGui::SameLine();
+			ImGui::Text("(%u frames spilled to disk, %u waiting, %.1fMB)", status.m_FramesSpilled, status.m_SpillQueued, status.m_SpillQueued * m_BufferSize / (1024.0f * 1024.0f));
+		}
 	}
 	else if (isWriting)
 	{
-		ImGui::Text("Saving '%s.wmv'...", m_RenderFileName);
+		ImGui::Text("Saving '%s%s'...", m_RenderFileName, m_RenderFileExtension);
+
+		if (vidWrite != nullptr && vidWrite->GetFramesToEncode() > 0)
+		{
+			RecordingStatus& status = m_RecordingStatus;
+
+			const unsigned int framesEncoded = vidWrite->GetFramesEncoded();
+			const unsigned int framesToEncode = vidWrite->GetFramesToEncode();
+
+			// the bar follows every frame, the rates would flicker so they only refresh twice a second
+			if (ImGui::GetTime() - status.m_SaveRefreshTime >= 0.5)
+			{
+				status.m_SaveRefreshTime = ImGui::GetTime();
+				status.m_FramesRemaining = vidWrite->GetFramesRemaining();
+				status.m_BytesOutput = vidWrite->GetBytesOutput();
+				status.m_EncodeFps = vidWrite->GetEncodeFps();
+				status.m_EncodeMs = vidWrite->GetAverageEncodeMs();
+				status.m_SecondsRemaining = vidWrite->GetSecondsRemaining();
+			}
+
+			char progress[64];
+			snprintf(progress, sizeof(progress), "%u/%u frames", framesEncoded > framesToEncode ? framesToEncode : framesEncoded, framesToEncode);
+
+			ImGui::ProgressBar(framesEncoded >= framesToEncode ? 1.0f : (float)framesEncoded / framesToEncode, ImVec2(400.f, 0.f), progress);
+
+			if (status.m_SecondsRemaining >= 0.0)
+			{
+				const int secondsLeft = (int)(status.m_SecondsRemaining + 0.5);
+
+				ImGui::Text("%.1f fps, %.2fms per frame, %.1fMB written, %d:%02d left", status.m_EncodeFps, status.m_EncodeMs, status.m_BytesOutput / (1024.0 * 1024.0), secondsLeft / 60, secondsLeft % 60);
+			}
+			else
+			{
+				ImGui::Text("%.1fMB written, estimating time left...", status.m_BytesOutput / (1024.0 * 1024.0));
+			}
+		}
 	}
 	else if (isDelayed)
 	{
@@ -786,22 +2042,60 @@ void Graphics::ShowUsageTable()
 			ImGui::TableSetColumnIndex(0);
 			ImGui::Text("File -> Render To File...");
 			ImGui::TableSetColumnIndex(1);
-			ImGui::TextWrapped("Here you can 'record' the applications window and render the result to a .WMV file.");
+			ImGui::TextWrapped("Here you can 'record' the applications window and render the result to a video file, a .WMV file by default.");
 			ImGui::TextWrapped("These video files will be saved in the 'Videos' directory located in the working directory.\n\n");
 			ImGui::TextWrapped("Some details on how it works...");
 			ImGui::TextWrapped("When we start the 'recording' process, the pixels from the OpenGL Context are being read into a pixel buffer objects, which are then mapped to a byte array.");
-			ImGui::TextWrapped("We have two pixel buffer objects, one reads the pixels from the back buffer while the other is being mapped to a byte array.");
-			ImGui::TextWrapped("This allows us to get the pixels across to the CPU without needing to wait for the frame to be presented to the screen.");
+			ImGui::TextWrapped("We have a ring of pixel buffer objects (the 'Readback Depth'), each read from the back buffer is followed by a fence.");
+			ImGui::TextWrapped("A buffer is only mapped to a byte array once its fence has signalled, so the CPU never waits on the GPU to finish a read.");
+			ImGui::TextWrapped("With 'Offline (Fixed Time Step)' ticked, ImGui is told exactly 1 / fps seconds pass each frame and one frame is captured per frame drawn, so a recording takes as long as it takes to render and encode rather than its real length, and the same input gives the same video.");
+			ImGui::TextWrapped("Recordings can also be started from the command line, e.g. '--headless --record demo --fps 30 --time 10', the app hides its window, records offscreen and closes once the file has saved.");
+			ImGui::TextWrapped("With 'Render Offscreen' ticked, the UI is drawn into an offscreen framebuffer at a fixed size and blitted into the window, captures read from that framebuffer so resizing, minimising or HiDPI scaling the window can't change the frame size.");
+			ImGui::TextWrapped("'Capture Region' records just one ImGui window, followed as it moves, or a fixed rect of the frame. Only that area is read back, stored and encoded, it is rounded up to whole 16x16 blocks (scaled captures are only kept to even sizes) and keeps the size it had when recording started.");
+			ImGui::TextWrapped("If a smaller 'Capture Size' is chosen, the back buffer is first blitted down into an offscreen framebuffer with linear filtering, halving at most each step, and the read comes from there.");
+			ImGui::TextWrapped("Each drawn frame is read back at most once, if drawing it took longer than a frame of the video it is repeated for every video frame it covered instead of being read again.");
 			ImGui::TextWrapped("Based on the duration specified in the 'Render To File...' popup, these byte arrays will be stored and be used as the frames in our video.\n\n");
 			ImGui::TextWrapped("When the frames for the specified duration and frame rate have been collected, they will then be passsed to the VideoWriter.");
-			ImGui::TextWrapped("The VideoWriter uses the Microsoft Media Foundation API to take our frame data and convert this into the video file.");
+			ImGui::TextWrapped("The VideoWriter hands our frame data to the chosen 'Encoder', which converts this into the video file.");
+			ImGui::TextWrapped("The Media Foundation encoder uses the Microsoft Media Foundation API and writes .WMV files, it is only available on Windows.");
+			ImGui::TextWrapped("The Y4M and Raw I420 encoders write uncompressed frames straight to disk, they work anywhere and give a baseline for how fast the rest of the recording path is.");
+			ImGui::TextWrapped("The MJPEG encoder needs nothing but the CRT either, every frame is a JPEG of 'JPEG Quality' stored in a Matroska (.MKV) file that ffmpeg and VLC can play and seek in.");
+			ImGui::TextWrapped("The file is written with the seek index kept in memory and added once recording ends. Live outputs get the bare JPEGs back to back instead.");
+			ImGui::TextWrapped("Its DCT and quantisation run 8 floats at a time with AVX2 (4 with SSE2), and while encoding as it records each frame is cut into restart interval slices that are encoded on 'Encode Threads' threads.");
+			ImGui::TextWrapped("The Screen Codec encoder is lossless and made for frames like these, 32x32 tiles that haven't changed since the last frame cost a byte for up to 64 of them, flat tiles are one colour and text is palette or run length coded.");
+			ImGui::TextWrapped("A keyframe starts every second of frames, its .GLSC files keep each frame's timestamp and duration so a frame held on screen is only stored once. Run with --decode <in.glsc> <out> to convert one to Y4M, or another format with --encoder.");
+			ImGui::TextWrapped("Before a frame reaches the encoder it is converted from BGRA to NV12 and flipped the right way up in a single SIMD pass, using the chosen 'Colour Matrix'.");
 			ImGui::TextWrapped("The frames have to be processed one by one, so asynchronous functionality is used so that the program does not get halted during this time.");
+			ImGui::TextWrapped("While saving, a progress bar shows how many frames have been encoded, with the encoder's frame rate, time per frame, bytes written so far and how long is left at that rate. While encoding as it records, the same figures show under the recording status along with how far the encoder is behind capture.");
+			ImGui::TextWrapped("Every encoder but Media Foundation writes its file behind itself, in 4 MB chunks with several being written while the next fills, so the encoder only waits on the disk once all 4 are in flight.");
+			ImGui::TextWrapped("On Linux the chunks are registered with io_uring once and submitted as fixed buffer writes, elsewhere, or where io_uring isn't allowed, a thread makes positioned writes. The Stats window shows which, how long chunks take to land and how many are in flight.");
+			ImGui::TextWrapped("With 'Skip Unchanged Draws' ticked, the vertices, indices, clip rects and textures ImGui draws are hashed each frame, while they match the last captured frame nothing is read back at all.");
+			ImGui::TextWrapped("With 'Skip Duplicate Frames' ticked, each read is hashed and a frame identical to the one before is not copied or encoded, the previous frame is held on screen for longer instead.");
+			ImGui::TextWrapped("With 'Compress Stored Frames' ticked, stored frames are XORed against the frame before and compressed on a worker thread, mostly static windows shrink by well over 100:1.");
+			ImGui::TextWrapped("Encoders that allow it (Y4M, Raw I420, MJPEG and Screen Codec) cut the stored frames into one segment per 'Save Threads', encode each segment on its own thread and join the results in order.\n\n");
+			ImGui::TextWrapped("With 'Encode While Recording' ticked, each frame is handed to the VideoWriter as soon as it is read instead of being stored.");
+			ImGui::TextWrapped("The VideoWriter encodes them on its own thread and never holds more than 'Queue Memory (MB)' of frames in memory, so saving finishes shortly after recording stops.");
+			ImGui::TextWrapped("Y4M and Raw I420 split this further, one thread converts and encodes while another writes the file, with lock free rings between capture, encode and write.");
+			ImGui::TextWrapped("If the encoder falls further behind than that and 'Spill To Disk' is ticked, frames page out to a memory mapped file of 'Spill File (MB)' in the Videos folder and are read back in order.");
+			ImGui::TextWrapped("Once that is full too, 'When Queue Is Full' decides whether capture waits or a frame is dropped, a dropped frame is replaced by the one before it so the video keeps its length. Offline recordings always wait, so they come out the same on any machine.");
+			ImGui::TextWrapped("'Output' can send the recording to another local process instead of a file, over a loopback TCP port or a named pipe. Frames are dropped until something connects, and each viewer gets the stream header first so it can join at any time.");
+			ImGui::TextWrapped("Live frames are written as soon as they are encoded rather than held back, only about 50ms of frames are queued and the oldest is dropped past that, so a viewer stays within roughly 100ms of the window.");
+			ImGui::TextWrapped("While streaming, the Stats window shows each stage's queue, frame rate, load and time spent idle or stalled, the stage with the highest load is the one limiting the frame rate.");
+
+			ImGui::TableNextRow();
+			ImGui::TableSetColumnIndex(0);
+			ImGui::Text("File -> Capture Screenshot");
+			ImGui::TableSetColumnIndex(1);
+			ImGui::TextWrapped("Saves what is on screen as a .PNG (F12) or .QOI (Shift+F12) in the 'Screenshots' directory located in the working directory.\n\n");
+			ImGui::TextWrapped("The frame is read into a pixel buffer object of its own once drawn, and only copied out a frame or two later when its fence has signalled, the same way recording reads frames.");
+			ImGui::TextWrapped("Compressing and writing the file happen on a worker thread, a large PNG is cut into bands of rows that are filtered and deflated on separate threads, so taking screenshots in quick succession doesn't hold up the UI.");
+			ImGui::TextWrapped("QOI files are larger but compress many times faster than PNG.");
 
 			ImGui::TableNextRow();
 			ImGui::TableSetColumnIndex(0);
 			ImGui::Text("File -> Print Info");
 			ImGui::TableSetColumnIndex(1);
-			ImGui::TextWrapped("Here, there are four options. Each one will print information to a text file.");
+			ImGui::TextWrapped("Here, there are seven options. Each one will print information to a text file.");
 			ImGui::TextWrapped("The text files will be saved in the 'Logs' directory in the working directory.\n\n");
 			ImGui::TextWrapped("OpenGL Info:");
 			ImGui::BulletText("Vendor Name");
@@ -812,6 +2106,12 @@ void Graphics::ShowUsageTable()
 			ImGui::BulletText("Version\n\n");
 			ImGui::TextWrapped("GLEW Info:");
 			ImGui::BulletText("Available Extensions\n\n");
+			ImGui::TextWrapped("Colour Conversion Benchmark:");
+			ImGui::BulletText("Time taken to convert a frame to NV12 and I420 with each conversion path (Scalar, SSE2, AVX2)\n\n");
+			ImGui::TextWrapped("MJPEG Encoder Benchmark:");
+			ImGui::BulletText("Frames per second encoding a window sized frame to JPEG with each DCT path, and with 1 up to every thread\n\n");
+			ImGui::TextWrapped("Screen Codec Benchmark:");
+			ImGui::BulletText("Size and frames per second of the current frame as a keyframe and with a small change as an inter frame, against what the raw I420 writer would store\n\n");
 			ImGui::TextWrapped("Something fun?:");
 			ImGui::BulletText("Just a memento to one of my favourite gaming franchises!");
 
@@ -849,17 +2149,21 @@ void Graphics::ShowKnownIssuesTable()
 			ImGui::TextWrapped("In the interest of time, I have limited the videos to be 30 seconds at 30fps maximum to hard cap it going over this already ridiculously large figure.\n\n");
 			ImGui::TextWrapped("Solutions:");
 			ImGui::TextWrapped("Have each frame encoded as soon as it is read from the pixel buffer object.");
-			ImGui::TextWrapped("This would immediately cut the memory usage to single frame figures (could open the door for live video streaming later).\n\n");
+			ImGui::TextWrapped("This would immediately cut the memory usage to single frame figures (could open the door for live video streaming later).");
+			ImGui::TextWrapped("This is now available through 'Encode While Recording', the 30fps cap only applies when it is unticked.");
+			ImGui::TextWrapped("Live streaming is available through 'Output', Y4M, raw I420, MJPEG or Screen Codec frames go to a loopback TCP port or named pipe as they are encoded. MPEG-TS would need an H.264 encoder the Y4M path doesn't have.\n\n");
 			ImGui::TextWrapped("This could introduce significant latency as we'd be sampling each frame of the video while we are simultaneously reading the next frame from the GPU");
 			ImGui::TextWrapped("Care would need to be taken to make sure we are only processing complete frames.\n\n");
 			ImGui::TextWrapped("Half the render resolution.");
 			ImGui::TextWrapped("This would cut the memory footprint in half and the drawback of reduced video quality.");
+			ImGui::TextWrapped("This is now available through 'Capture Size', the back buffer is scaled down on the GPU before it is read back, so a half size capture needs a quarter of the memory.\n\n");
 
 			ImGui::TableNextRow();
 			ImGui::TableSetColumnIndex(0);
 			ImGui::Text("Windows reliance");
 			ImGui::TableSetColumnIndex(1);
 			ImGui::TextWrapped("I have used Windows Media Foundation as a means to encode my frames to video. This is not a cross platform solution.");
+			ImGui::TextWrapped("The VideoWriter now sits in front of swappable encoder backends, the uncompressed Y4M backend works without Windows but does not compress anything.");
 			ImGui::TextWrapped("If I were to take this further, I would investaigate into writing my own wrapper for avcodec as a means to provide a cross platform solution.");
 
 			ImGui::TableNextRow();
@@ -898,8 +2202,7 @@ void Graphics::PrintOpenGLInfo()
 {
 	std::ofstream file;
 
-	char filePath[128] = "";
-	sprintf_s(filePath, "%s\\opengl_info.txt", m_PrintFilePathBase);
+	const std::string filePath = m_PrintFilePathBase + "/opengl_info.txt";
 
 	std::cout << "Print Opengl " << filePath << std::endl;
 
@@ -923,8 +2226,7 @@ void Graphics::PrintGLFWInfo()
 {
 	std::ofstream file;
 
-	char filePath[128] = "";
-	sprintf_s(filePath, "%s\\glfw_info.txt", m_PrintFilePathBase);
+	const std::string filePath = m_PrintFilePathBase + "/glfw_info.txt";
 
 	file.open(filePath, std::ios::out);
 
@@ -946,8 +2248,7 @@ void Graphics::PrintGLEWInfo()
 
 	std::ofstream file;
 
-	char filePath[128] = "";
-	sprintf_s(filePath, "%s\\glew_info.txt", m_PrintFilePathBase);
+	const std::string filePath = m_PrintFilePathBase + "/glew_info.txt";
 
 	file.open(filePath, std::ios::out);
 
@@ -958,7 +2259,7 @@ void Graphics::PrintGLEWInfo()
 		file << "GLEW Version: " << glewGetString(GLEW_VERSION) << "\n";
 		file << "Extensions Available:\n";
 
-		for (size_t i = 0; i < n; ++i)
+		for (size_t i = 0; i < (size_t)n; ++i)
 		{
 			file << glGetStringi(GL_EXTENSIONS, i) << "\n";
 		}
@@ -967,12 +2268,327 @@ void Graphics::PrintGLEWInfo()
 	}
 }
 
+void Graphics::PrintConversionBenchmark()
+{
+	const int width = (int)m_WindowSize->x;
+	const int height = (int)m_WindowSize->y;
+	const int iterations = 20;
+
+	std::vector<uint8_t> frame((size_t)width * height * 4);
+
+	// something with a bit of variety in it rather than a flat colour
+	for (size_t i = 0; i < frame.size(); ++i)
+	{
+		frame[i] = (uint8_t)((i * 2654435761u) >> 13);
+	}
+
+	std::ofstream file;
+
+	const std::string filePath = m_PrintFilePathBase + "/colour_conversion_benchmark.txt";
+
+	file.open(filePath, std::ios::out);
+
+	if (file.is_open())
+	{
+		file << "Colour Conversion Benchmark (" << width << "x" << height << " BGRA, " << iterations << " iterations)\n";
+		file << "-----------------------------------------\n";
+
+		const ColourConverter::Format formats[] = { ColourConverter::Format::NV12, ColourConverter::Format::I420 };
+		const ColourConverter::Matrix matrices[] = { ColourConverter::Matrix::BT601, ColourConverter::Matrix::BT709 };
+		const ColourConverter::Path paths[] = { ColourConverter::Path::Scalar, ColourConverter::Path::SSE2, ColourConverter::Path::AVX2 };
+
+		for (const ColourConverter::Format& format : formats)
+		{
+			for (const ColourConverter::Matrix& matrix : matrices)
+			{
+				ColourConverter converter(width, height, format, matrix);
+
+				std::vector<uint8_t> reference(converter.GetOutputSize());
+				std::vector<uint8_t> output(converter.GetOutputSize());
+
+				converter.SetPath(ColourConverter::Path::Scalar);
+				converter.Convert(frame.data(), reference.data(), true);
+
+				for (const ColourConverter::Path& path : paths)
+				{
+					if (!converter.SetPath(path))
+					{
+						file << ColourConverter::GetFormatName(format) << " " << ColourConverter::GetMatrixName(matrix) << " " << ColourConverter::GetPathName(path) << ": not supported\n";
+
+						continue;
+					}
+
+					auto start = std::chrono::high_resolution_clock::now();
+
+					for (int i = 0; i < iterations; ++i)
+					{
+						converter.Convert(frame.data(), output.data(), true);
+					}
+
+					std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+					const double msPerFrame = elapsed.count() / iterations;
+					const double megaPixels = (double)width * height / 1000000.0;
+
+					file << ColourConverter::GetFormatName(format) << " " << ColourConverter::GetMatrixName(matrix) << " " << ColourConverter::GetPathName(path) << ": ";
+					file << msPerFrame << "ms per frame, " << megaPixels / (msPerFrame / 1000.0) << " MP/s";
+					file << (output == reference ? "" : " (MISMATCH against scalar!)") << "\n";
+				}
+			}
+		}
+
+		file << "\nBytes per frame: " << frame.size() << " BGRA, " << ColourConverter(width, height, ColourConverter::Format::NV12, ColourConverter::Matrix::BT601).GetOutputSize() << " 4:2:0\n";
+
+		file.close();
+	}
+}
+
+void Graphics::PrintMJPEGBenchmark()
+{
+	// a fixed size so results from different machines and window sizes line up
+	const int width = 1600;
+	const int height = 900;
+	const int iterations = 20;
+
+	std::vector<uint8_t> frame((size_t)width * height * 4);
+
+	// gradients with some noise on top, closer to a real frame than pure noise which no JPEG compresses well
+	for (int y = 0; y < height; ++y)
+	{
+		for (int x = 0; x < width; ++x)
+		{
+			const size_t i = ((size_t)y * width + x) * 4;
+			const int noise = (int)(((i * 2654435761u) >> 13) & 15);
+
+			frame[i + 0] = (uint8_t)(x * 240 / width + noise);
+			frame[i + 1] = (uint8_t)(y * 240 / height + noise);
+			frame[i + 2] = (uint8_t)((x + y) * 240 / (width + height) + noise);
+			frame[i + 3] = 255;
+		}
+	}
+
+	std::ofstream file;
+
+	const std::string filePath = m_PrintFilePathBase + "/mjpeg_benchmark.txt";
+
+	file.open(filePath, std::ios::out);
+
+	if (file.is_open())
+	{
+		file << "MJPEG Encoder Benchmark (" << width << "x" << height << " BGRA, quality " << m_RenderFileQuality << ", " << iterations << " iterations)\n";
+		file << "-----------------------------------------\n";
+
+		std::vector<uint8_t> output{};
+
+		// one thread, so only the DCT path changes
+		const JpegEncoder::Path paths[] = { JpegEncoder::Path::Scalar, JpegEncoder::Path::SSE2, JpegEncoder::Path::AVX2 };
+
+		JpegEncoder encoder(width, height, m_RenderFileQuality, 1);
+
+		for (const JpegEncoder::Path& path : paths)
+		{
+			if (!encoder.SetPath(path))
+			{
+				file << ColourConverter::GetPathName(path) << ", 1 thread: not supported\n";
+
+				continue;
+			}
+
+			encoder.Encode(frame.data(), output);
+
+			auto start = std::chrono::high_resolution_clock::now();
+
+			for (int i = 0; i < iterations; ++i)
+			{
+				encoder.Encode(frame.data(), output);
+			}
+
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+			file << ColourConverter::GetPathName(path) << ", 1 thread: " << elapsed.count() / iterations << "ms per frame, " << iterations / (elapsed.count() / 1000.0) << " fps, " << output.size() << " bytes\n";
+		}
+
+		file << "\n";
+
+		// then the best path, with every thread count up to what the machine has
+		const int maxThreads = std::max(1, (int)std::thread::hardware_concurrency());
+
+		encoder.SetPath(ColourConverter::GetBestPath());
+
+		for (int threads = 1; threads <= maxThreads; ++threads)
+		{
+			encoder.SetThreads(threads);
+			encoder.Encode(frame.data(), output);
+
+			auto start = std::chrono::high_resolution_clock::now();
+
+			for (int i = 0; i < iterations; ++i)
+			{
+				encoder.Encode(frame.data(), output);
+			}
+
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+			file << ColourConverter::GetPathName(encoder.GetPath()) << ", " << threads << (threads == 1 ? " thread" : " threads") << " (" << encoder.GetSliceCount() << " slices): ";
+			file << elapsed.count() / iterations << "ms per frame, " << iterations / (elapsed.count() / 1000.0) << " fps, " << output.size() << " bytes\n";
+		}
+
+		file << "\nBytes per frame: " << frame.size() << " BGRA, " << output.size() << " JPEG (" << (double)frame.size() / output.size() << ":1)\n";
+
+		file.close();
+	}
+}
+
+void Graphics::PrintScreenCodecBenchmark()
+{
+	const int width = m_FramebufferWidth;
+	const int height = m_FramebufferHeight;
+	const int iterations = 20;
+
+	if (width <= 0 || height <= 0)
+		return;
+
+	// the frame that was just drawn, GUI content is what the codec is for and nothing synthetic looks quite like it
+	std::vector<uint8_t> frame((size_t)width * height * 4);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_CaptureFramebuffer);
+	glReadPixels(0, 0, width, height, GL_BGRA, GL_UNSIGNED_BYTE, frame.data());
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+	// the next frame changes a line of text and a cursor, about what typing into a box does
+	std::vector<uint8_t> changed = frame;
+
+	const int changeWidth = std::min(width, 300);
+	const int changeHeight = std::min(height, 16);
+	const int changeX = (width - changeWidth) / 2;
+	const int changeY = (height - changeHeight) / 2;
+
+	for (int y = changeY; y < changeY + changeHeight; ++y)
+	{
+		for (int x = changeX; x < changeX + changeWidth; ++x)
+		{
+			uint8_t* pixel = &changed[((size_t)y * width + x) * 4];
+
+			pixel[0] = (uint8_t)(255 - pixel[0]);
+			pixel[1] = (uint8_t)(255 - pixel[1]);
+			pixel[2] = (uint8_t)(255 - pixel[2]);
+		}
+	}
+
+	const std::vector<uint8_t>* frames[2] = { &frame, &changed };
+
+	std::ofstream file;
+
+	const std::string filePath = m_PrintFilePathBase + "/screen_codec_benchmark.txt";
+
+	file.open(filePath, std::ios::out);
+
+	if (file.is_open())
+	{
+		file << "Screen Codec Benchmark (" << width << "x" << height << " BGRA, " << iterations << " iterations)\n";
+		file << "-----------------------------------------\n";
+
+		// lossless or it isn't worth timing, both frames go through the decoder
+		std::vector<uint8_t> keyFrame{};
+		std::vector<uint8_t> interFrame{};
+		std::vector<uint8_t> decoded(frame.size());
+
+		ScreenCodec encoder(width, height, 1);
+		ScreenCodec decoder(width, height, 1);
+
+		bool lossless = true;
+
+		for (int i = 0; i < 2; ++i)
+		{
+			std::vector<uint8_t>& encoded = i == 0 ? keyFrame : interFrame;
+
+			encoder.Encode(frames[i]->data(), i == 0, encoded);
+
+			if (!decoder.Decode(encoded.data(), encoded.size(), decoded.data()))
+			{
+				lossless = false;
+
+				continue;
+			}
+
+			for (size_t p = 0; p < decoded.size(); p += 4)
+			{
+				if (memcmp(&decoded[p], &(*frames[i])[p], 3) != 0)
+				{
+					lossless = false;
+
+					break;
+				}
+			}
+		}
+
+		file << "Keyframe: " << keyFrame.size() << " bytes, tiles";
+
+		encoder.Encode(frame.data(), true, keyFrame);
+
+		for (int mode = 0; mode < (int)ScreenCodec::TileMode::Count; ++mode)
+		{
+			file << " " << ScreenCodec::GetModeName((ScreenCodec::TileMode)mode) << " " << encoder.GetTileCount((ScreenCodec::TileMode)mode);
+		}
+
+		file << "\nInter frame: " << interFrame.size() << " bytes, " << changeWidth << "x" << changeHeight << " pixels changed\n";
+		file << (lossless ? "Decoded frames match the source\n\n" : "Decoded frames DON'T match the source!\n\n");
+
+		const int maxThreads = std::max(1, (int)std::thread::hardware_concurrency());
+
+		for (int threads = 1; threads <= maxThreads; ++threads)
+		{
+			encoder.SetThreads(threads);
+
+			// keyframes code every tile, inter frames flip between the two frames so only the changed tiles are coded
+			auto start = std::chrono::high_resolution_clock::now();
+
+			for (int i = 0; i < iterations; ++i)
+			{
+				encoder.Encode(frame.data(), true, keyFrame);
+			}
+
+			std::chrono::duration<double, std::milli> keyElapsed = std::chrono::high_resolution_clock::now() - start;
+
+			start = std::chrono::high_resolution_clock::now();
+
+			for (int i = 0; i < iterations; ++i)
+			{
+				encoder.Encode(frames[(i + 1) % 2]->data(), false, interFrame);
+			}
+
+			std::chrono::duration<double, std::milli> interElapsed = std::chrono::high_resolution_clock::now() - start;
+
+			file << threads << (threads == 1 ? " thread" : " threads") << " (" << encoder.GetBandCount() << " bands): ";
+			file << "keyframes " << iterations / (keyElapsed.count() / 1000.0) << " fps, inter frames " << iterations / (interElapsed.count() / 1000.0) << " fps\n";
+		}
+
+		// the raw sink stores I420 as it comes out of the converter, so that is the time and size to beat
+		ColourConverter converter(width, height, ColourConverter::Format::I420, ColourConverter::Matrix::BT601);
+		std::vector<uint8_t> converted(converter.GetOutputSize());
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		for (int i = 0; i < iterations; ++i)
+		{
+			converter.Convert(frame.data(), converted.data(), true);
+		}
+
+		std::chrono::duration<double, std::milli> rawElapsed = std::chrono::high_resolution_clock::now() - start;
+
+		file << "\nRaw I420 (" << ColourConverter::GetPathName(converter.GetPath()) << "): " << converted.size() << " bytes, " << iterations / (rawElapsed.count() / 1000.0) << " fps, and not lossless\n";
+		file << "Keyframe is " << (double)converted.size() / keyFrame.size() << "x smaller than raw I420, inter frame " << (double)converted.size() / std::max((size_t)1, interFrame.size()) << "x smaller\n";
+		file << "Bytes per frame: " << frame.size() << " BGRA, " << (size_t)width * height * 3 << " BGR\n";
+
+		file.close();
+	}
+}
+
 void Graphics::PrintSomethingFun()
 {
 	std::ofstream file;
 
-	char filePath[128] = "";
-	sprintf_s(filePath, "%s\\surprise.txt", m_PrintFilePathBase);
+	const std::string filePath = m_PrintFilePathBase + "/surprise.txt";
 
 	file.open(filePath, std::ios::out);
 
@@ -0,0 +1,336 @@
+#include <Modules/Graphics/ImageEncoder.h>
+#include <Modules/Graphics/Deflate.h>
+
+#include <algorithm>
+#include <thread>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	// bands smaller than this cost more in table headers and lost matches than the extra thread saves
+	const int MinBandRows = 32;
+
+	void PutBigEndian(std::vector<uint8_t>& out, const uint32_t& value)
+	{
+		out.push_back((uint8_t)(value >> 24));
+		out.push_back((uint8_t)(value >> 16));
+		out.push_back((uint8_t)(value >> 8));
+		out.push_back((uint8_t)value);
+	}
+
+	void PutChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, const size_t& size)
+	{
+		PutBigEndian(out, (uint32_t)size);
+
+		const size_t start = out.size();
+
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data, data + size);
+
+		PutBigEndian(out, Deflate::Crc32(out.data() + start, out.size() - start));
+	}
+
+	// the readback is bottom up BGRA, image files want top down RGB
+	void ConvertRow(const uint8_t* bgra, const int& width, const int& height, const int& y, uint8_t* rgb)
+	{
+		const uint8_t* src = bgra + (size_t)(height - 1 - y) * width * 4;
+
+		for (int x = 0; x < width; ++x)
+		{
+			rgb[x * 3 + 0] = src[x * 4 + 2];
+			rgb[x * 3 + 1] = src[x * 4 + 1];
+			rgb[x * 3 + 2] = src[x * 4 + 0];
+		}
+	}
+
+	inline uint8_t Paeth(const int& a, const int& b, const int& c)
+	{
+		const int p = a + b - c;
+		const int pa = std::abs(p - a);
+		const int pb = std::abs(p - b);
+		const int pc = std::abs(p - c);
+
+		if (pa <= pb && pa <= pc)
+			return (uint8_t)a;
+
+		return (uint8_t)(pb <= pc ? b : c);
+	}
+
+	// filters rows [first, last) into filter byte + row each, picking per row the filter with the smallest sum of signed residuals
+	void FilterRows(const uint8_t* bgra, const int& width, const int& height, const int& first, const int& last, std::vector<uint8_t>& filtered)
+	{
+		const size_t rowSize = (size_t)width * 3;
+		const size_t Bpp = 3;
+
+		std::vector<uint8_t> previous(rowSize, 0);
+		std::vector<uint8_t> current(rowSize);
+		std::vector<uint8_t> candidates[5];
+
+		for (std::vector<uint8_t>& candidate : candidates)
+		{
+			candidate.resize(rowSize);
+		}
+
+		if (first > 0)
+		{
+			ConvertRow(bgra, width, height, first - 1, previous.data());
+		}
+
+		filtered.resize((rowSize + 1) * (last - first));
+
+		for (int y = first; y < last; ++y)
+		{
+			ConvertRow(bgra, width, height, y, current.data());
+
+			unsigned long long costs[5]{};
+
+			for (size_t i = 0; i < rowSize; ++i)
+			{
+				const int a = i >= Bpp ? current[i - Bpp] : 0;
+				const int b = previous[i];
+				const int c = i >= Bpp ? previous[i - Bpp] : 0;
+				const int x = current[i];
+
+				candidates[0][i] = (uint8_t)x;
+				candidates[1][i] = (uint8_t)(x - a);
+				candidates[2][i] = (uint8_t)(x - b);
+				candidates[3][i] = (uint8_t)(x - ((a + b) >> 1));
+				candidates[4][i] = (uint8_t)(x - Paeth(a, b, c));
+
+				for (int filter = 0; filter < 5; ++filter)
+				{
+					costs[filter] += std::abs((int)(int8_t)candidates[filter][i]);
+				}
+			}
+
+			const int best = (int)(std::min_element(costs, costs + 5) - costs);
+
+			uint8_t* row = filtered.data() + (rowSize + 1) * (y - first);
+
+			row[0] = (uint8_t)best;
+			std::memcpy(row + 1, candidates[best].data(), rowSize);
+
+			std::swap(previous, current);
+		}
+	}
+}
+
+bool ImageEncoder::EncodePNG(const uint8_t* bgra, const int& width, const int& height, const int& threads, std::vector<uint8_t>& out)
+{
+	out.clear();
+
+	if (bgra == nullptr || width <= 0 || height <= 0)
+		return false;
+
+	const int bandCount = std::clamp(std::min(threads, height / MinBandRows), 1, height);
+
+	std::vector<std::vector<uint8_t>> bands(bandCount);
+	std::vector<uint32_t> adlers(bandCount);
+	std::vector<size_t> bandSizes(bandCount);
+
+	// each band is filtered and deflated on its own, deflate ends each one on a sync flush so they join as one stream
+	auto compressBand = [&](const int& band)
+	{
+		const int first = height * band / bandCount;
+		const int last = height * (band + 1) / bandCount;
+
+		std::vector<uint8_t> filtered;
+		FilterRows(bgra, width, height, first, last, filtered);
+
+		std::vector<uint8_t>& compressed = bands[band];
+
+		if (band == 0)
+		{
+			// zlib header, deflate with a 32KB window
+			compressed.push_back(0x78);
+			compressed.push_back(0x01);
+		}
+
+		Deflate deflate(5);
+		deflate.Compress(filtered.data(), filtered.size(), compressed, band == bandCount - 1);
+
+		adlers[band] = Deflate::Adler32(filtered.data(), filtered.size());
+		bandSizes[band] = filtered.size();
+	};
+
+	std::vector<std::thread> workers;
+
+	for (int band = 1; band < bandCount; ++band)
+	{
+		workers.emplace_back(compressBand, band);
+	}
+
+	compressBand(0);
+
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	uint32_t adler = adlers[0];
+
+	for (int band = 1; band < bandCount; ++band)
+	{
+		adler = Deflate::CombineAdler32(adler, adlers[band], bandSizes[band]);
+	}
+
+	PutBigEndian(bands.back(), adler);
+
+	const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	out.insert(out.end(), signature, signature + 8);
+
+	// 8 bit RGB, deflate, adaptive filtering, not interlaced
+	std::vector<uint8_t> header;
+	PutBigEndian(header, (uint32_t)width);
+	PutBigEndian(header, (uint32_t)height);
+	header.insert(header.end(), { 8, 2, 0, 0, 0 });
+
+	PutChunk(out, "IHDR", header.data(), header.size());
+
+	for (const std::vector<uint8_t>& band : bands)
+	{
+		PutChunk(out, "IDAT", band.data(), band.size());
+	}
+
+	PutChunk(out, "IEND", nullptr, 0);
+
+	return true;
+}
+
+bool ImageEncoder::EncodeQOI(const uint8_t* bgra, const int& width, const int& height, std::vector<uint8_t>& out)
+{
+	out.clear();
+
+	if (bgra == nullptr || width <= 0 || height <= 0)
+		return false;
+
+	// worst case is a tag and three bytes a pixel
+	out.reserve((size_t)width * height * 4 + 22);
+
+	out.insert(out.end(), { 'q', 'o', 'i', 'f' });
+	PutBigEndian(out, (uint32_t)width);
+	PutBigEndian(out, (uint32_t)height);
+
+	// RGB, sRGB with linear alpha
+	out.push_back(3);
+	out.push_back(0);
+
+	uint32_t index[64]{};
+	uint8_t previous[4] = { 0, 0, 0, 255 };
+	int run = 0;
+
+	for (int y = 0; y < height; ++y)
+	{
+		const uint8_t* src = bgra + (size_t)(height - 1 - y) * width * 4;
+
+		for (int x = 0; x < width; ++x)
+		{
+			const uint8_t pixel[4] = { src[x * 4 + 2], src[x * 4 + 1], src[x * 4 + 0], 255 };
+
+			if (std::memcmp(pixel, previous, 4) == 0)
+			{
+				run++;
+
+				if (run == 62)
+				{
+					out.push_back((uint8_t)(0xC0 | (run - 1)));
+					run = 0;
+				}
+
+				continue;
+			}
+
+			if (run > 0)
+			{
+				out.push_back((uint8_t)(0xC0 | (run - 1)));
+				run = 0;
+			}
+
+			const int hash = (pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) % 64;
+
+			uint32_t packed;
+			std::memcpy(&packed, pixel, 4);
+
+			if (index[hash] == packed)
+			{
+				out.push_back((uint8_t)hash);
+			}
+			else
+			{
+				index[hash] = packed;
+
+				const int dr = (int8_t)(pixel[0] - previous[0]);
+				const int dg = (int8_t)(pixel[1] - previous[1]);
+				const int db = (int8_t)(pixel[2] - previous[2]);
+
+				const int drg = dr - dg;
+				const int dbg = db - dg;
+
+				if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+				{
+					out.push_back((uint8_t)(0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2)));
+				}
+				else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7)
+				{
+					out.push_back((uint8_t)(0x80 | (dg + 32)));
+					out.push_back((uint8_t)(((drg + 8) << 4) | (dbg + 8)));
+				}
+				else
+				{
+					out.insert(out.end(), { 0xFE, pixel[0], pixel[1], pixel[2] });
+				}
+			}
+
+			std::memcpy(previous, pixel, 4);
+		}
+	}
+
+	if (run > 0)
+	{
+		out.push_back((uint8_t)(0xC0 | (run - 1)));
+	}
+
+	out.insert(out.end(), { 0, 0, 0, 0, 0, 0, 0, 1 });
+
+	return true;
+}
+
+bool ImageEncoder::Encode(const ImageFormat& format, const uint8_t* bgra, const int& width, const int& height, const int& threads, std::vector<uint8_t>& out)
+{
+	switch (format)
+	{
+	case ImageFormat::PNG:
+		return EncodePNG(bgra, width, height, threads, out);
+	case ImageFormat::QOI:
+		return EncodeQOI(bgra, width, height, out);
+	default:
+		return false;
+	}
+}
+
+const char* ImageEncoder::GetName(const ImageFormat& format)
+{
+	switch (format)
+	{
+	case ImageFormat::PNG:
+		return "PNG";
+	case ImageFormat::QOI:
+		return "QOI";
+	default:
+		return "Unknown";
+	}
+}
+
+const char* ImageEncoder::GetFileExtension(const ImageFormat& format)
+{
+	switch (format)
+	{
+	case ImageFormat::PNG:
+		return ".png";
+	case ImageFormat::QOI:
+		return ".qoi";
+	default:
+		return "";
+	}
+}
@@ -0,0 +1,644 @@
+#include <Modules/Graphics/JpegEncoder.h>
+
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define JPEG_ENCODE_X86 1
+#include <immintrin.h>
+#endif
+
+// MSVC lets us use AVX2 intrinsics anywhere, GCC and Clang need the functions marked
+#if defined(JPEG_ENCODE_X86) && (defined(__GNUC__) || defined(__clang__))
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define AVX2_TARGET
+#endif
+
+namespace
+{
+	const uint8_t Zigzag[64] =
+	{
+		0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+		12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+		35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+		58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+	};
+
+	// annex K tables, quality 50
+	const uint8_t LumaQuant[64] =
+	{
+		16, 11, 10, 16, 24, 40, 51, 61,
+		12, 12, 14, 19, 26, 58, 60, 55,
+		14, 13, 16, 24, 40, 57, 69, 56,
+		14, 17, 22, 29, 51, 87, 80, 62,
+		18, 22, 37, 56, 68, 109, 103, 77,
+		24, 35, 55, 64, 81, 104, 113, 92,
+		49, 64, 78, 87, 103, 121, 120, 101,
+		72, 92, 95, 98, 112, 100, 103, 99
+	};
+
+	const uint8_t ChromaQuant[64] =
+	{
+		17, 18, 24, 47, 99, 99, 99, 99,
+		18, 21, 26, 66, 99, 99, 99, 99,
+		24, 26, 56, 99, 99, 99, 99, 99,
+		47, 66, 99, 99, 99, 99, 99, 99,
+		99, 99, 99, 99, 99, 99, 99, 99,
+		99, 99, 99, 99, 99, 99, 99, 99,
+		99, 99, 99, 99, 99, 99, 99, 99,
+		99, 99, 99, 99, 99, 99, 99, 99
+	};
+
+	// annex K huffman tables, code counts for each length from 1 to 16 then the symbols in code order
+	const uint8_t DCLumaBits[16] = { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+	const uint8_t DCChromaBits[16] = { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 };
+	const uint8_t DCValues[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+
+	const uint8_t ACLumaBits[16] = { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7D };
+	const uint8_t ACLumaValues[162] =
+	{
+		0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+		0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08, 0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0,
+		0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28,
+		0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+		0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+		0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+		0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+		0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5,
+		0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2,
+		0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+		0xF9, 0xFA
+	};
+
+	const uint8_t ACChromaBits[16] = { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 };
+	const uint8_t ACChromaValues[162] =
+	{
+		0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+		0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0,
+		0x15, 0x62, 0x72, 0xD1, 0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26,
+		0x27, 0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+		0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+		0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+		0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5,
+		0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3,
+		0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA,
+		0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+		0xF9, 0xFA
+	};
+
+	struct HuffmanTable
+	{
+		uint16_t m_Codes[256]{};
+		uint8_t m_Sizes[256]{};
+
+		HuffmanTable(const uint8_t* bits, const uint8_t* values)
+		{
+			int code = 0;
+			int k = 0;
+
+			for (int length = 1; length <= 16; ++length)
+			{
+				for (int i = 0; i < bits[length - 1]; ++i, ++k)
+				{
+					m_Codes[values[k]] = (uint16_t)code++;
+					m_Sizes[values[k]] = (uint8_t)length;
+				}
+
+				code <<= 1;
+			}
+		}
+	};
+
+	const HuffmanTable DCLuma(DCLumaBits, DCValues);
+	const HuffmanTable DCChroma(DCChromaBits, DCValues);
+	const HuffmanTable ACLuma(ACLumaBits, ACLumaValues);
+	const HuffmanTable ACChroma(ACChromaBits, ACChromaValues);
+
+	// DCT as two matrix products, F = C * X * C^T, with C scaled so F comes out as the JPEG definition wants
+	struct DCTMatrix
+	{
+		alignas(32) float m_Rows[8][8]{};
+		alignas(32) float m_Columns[8][8]{};
+
+		DCTMatrix()
+		{
+			const double pi = 3.14159265358979323846;
+
+			for (int i = 0; i < 8; ++i)
+			{
+				for (int k = 0; k < 8; ++k)
+				{
+					const double scale = i == 0 ? std::sqrt(0.125) : 0.5;
+
+					m_Rows[i][k] = (float)(scale * std::cos((2 * k + 1) * i * pi / 16.0));
+					m_Columns[k][i] = m_Rows[i][k];
+				}
+			}
+		}
+	};
+
+	const DCTMatrix DCT;
+
+	// row pass then column pass, each output row is a sum of scaled input rows so it maps straight onto vector registers
+	// the sums run in the same order on every path, so all of them give the same coefficients
+	void ForwardDCTScalar(const float* block, const float* reciprocals, int16_t* out)
+	{
+		float rows[8][8];
+
+		for (int r = 0; r < 8; ++r)
+		{
+			for (int j = 0; j < 8; ++j)
+			{
+				float sum = 0.0f;
+
+				for (int k = 0; k < 8; ++k)
+				{
+					sum = sum + block[r * 8 + k] * DCT.m_Columns[k][j];
+				}
+
+				rows[r][j] = sum;
+			}
+		}
+
+		for (int i = 0; i < 8; ++i)
+		{
+			for (int j = 0; j < 8; ++j)
+			{
+				float sum = 0.0f;
+
+				for (int k = 0; k < 8; ++k)
+				{
+					sum = sum + DCT.m_Rows[i][k] * rows[k][j];
+				}
+
+				out[i * 8 + j] = (int16_t)std::clamp(std::lrint(sum * reciprocals[i * 8 + j]), -32768L, 32767L);
+			}
+		}
+	}
+
+#ifdef JPEG_ENCODE_X86
+	void ForwardDCTSSE2(const float* block, const float* reciprocals, int16_t* out)
+	{
+		__m128 rows[8][2];
+
+		for (int r = 0; r < 8; ++r)
+		{
+			__m128 low = _mm_setzero_ps();
+			__m128 high = _mm_setzero_ps();
+
+			for (int k = 0; k < 8; ++k)
+			{
+				const __m128 x = _mm_set1_ps(block[r * 8 + k]);
+
+				low = _mm_add_ps(low, _mm_mul_ps(x, _mm_load_ps(&DCT.m_Columns[k][0])));
+				high = _mm_add_ps(high, _mm_mul_ps(x, _mm_load_ps(&DCT.m_Columns[k][4])));
+			}
+
+			rows[r][0] = low;
+			rows[r][1] = high;
+		}
+
+		for (int i = 0; i < 8; ++i)
+		{
+			__m128 low = _mm_setzero_ps();
+			__m128 high = _mm_setzero_ps();
+
+			for (int k = 0; k < 8; ++k)
+			{
+				const __m128 c = _mm_set1_ps(DCT.m_Rows[i][k]);
+
+				low = _mm_add_ps(low, _mm_mul_ps(c, rows[k][0]));
+				high = _mm_add_ps(high, _mm_mul_ps(c, rows[k][1]));
+			}
+
+			// quantise, round to nearest and saturate to 16 bits in one go
+			low = _mm_mul_ps(low, _mm_loadu_ps(reciprocals + i * 8));
+			high = _mm_mul_ps(high, _mm_loadu_ps(reciprocals + i * 8 + 4));
+
+			_mm_storeu_si128((__m128i*)(out + i * 8), _mm_packs_epi32(_mm_cvtps_epi32(low), _mm_cvtps_epi32(high)));
+		}
+	}
+
+	AVX2_TARGET void ForwardDCTAVX2(const float* block, const float* reciprocals, int16_t* out)
+	{
+		__m256 rows[8];
+
+		for (int r = 0; r < 8; ++r)
+		{
+			__m256 sum = _mm256_setzero_ps();
+
+			for (int k = 0; k < 8; ++k)
+			{
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(block[r * 8 + k]), _mm256_load_ps(&DCT.m_Columns[k][0])));
+			}
+
+			rows[r] = sum;
+		}
+
+		for (int i = 0; i < 8; ++i)
+		{
+			__m256 sum = _mm256_setzero_ps();
+
+			for (int k = 0; k < 8; ++k)
+			{
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(DCT.m_Rows[i][k]), rows[k]));
+			}
+
+			const __m256i quantised = _mm256_cvtps_epi32(_mm256_mul_ps(sum, _mm256_loadu_ps(reciprocals + i * 8)));
+
+			// the 256 bit pack works within each half, packing the two halves together keeps the order
+			_mm_storeu_si128((__m128i*)(out + i * 8), _mm_packs_epi32(_mm256_castsi256_si128(quantised), _mm256_extracti128_si256(quantised, 1)));
+		}
+	}
+#endif
+
+	typedef void (*ForwardDCTFunction)(const float*, const float*, int16_t*);
+
+	ForwardDCTFunction GetForwardDCT(const JpegEncoder::Path& path)
+	{
+		switch (path)
+		{
+#ifdef JPEG_ENCODE_X86
+		case JpegEncoder::Path::SSE2:
+			return ForwardDCTSSE2;
+		case JpegEncoder::Path::AVX2:
+			return ForwardDCTAVX2;
+#endif
+		default:
+			return ForwardDCTScalar;
+		}
+	}
+
+	// entropy coded data is written most significant bit first, and any 0xFF byte is followed by a 0 so it can't be read as a marker
+	struct JpegBits
+	{
+		std::vector<uint8_t>& m_Out;
+		uint32_t m_Bits = 0;
+		int m_Count = 0;
+
+		inline void Put(const uint32_t& value, const int& size)
+		{
+			m_Bits = (m_Bits << size) | (value & ((1u << size) - 1));
+			m_Count += size;
+
+			while (m_Count >= 8)
+			{
+				const uint8_t byte = (uint8_t)(m_Bits >> (m_Count - 8));
+
+				m_Out.push_back(byte);
+
+				if (byte == 0xFF)
+					m_Out.push_back(0);
+
+				m_Count -= 8;
+			}
+
+			m_Bits &= (1u << m_Count) - 1;
+		}
+
+		// the last byte is padded with ones
+		inline void Flush()
+		{
+			if (m_Count > 0)
+				Put((1u << (8 - m_Count)) - 1, 8 - m_Count);
+		}
+	};
+
+	inline int BitCount(int value)
+	{
+		value = value < 0 ? -value : value;
+
+		int count = 0;
+
+		while (value > 0)
+		{
+			count++;
+			value >>= 1;
+		}
+
+		return count;
+	}
+
+	void EncodeBlock(JpegBits& bits, const int16_t* coefficients, int& previousDC, const HuffmanTable& dcTable, const HuffmanTable& acTable)
+	{
+		const int dc = coefficients[0];
+		const int difference = dc - previousDC;
+
+		previousDC = dc;
+
+		// negative values are sent as their ones complement in as many bits as the magnitude needs
+		int size = BitCount(difference);
+
+		bits.Put(dcTable.m_Codes[size], dcTable.m_Sizes[size]);
+
+		if (size > 0)
+			bits.Put(difference < 0 ? difference - 1 : difference, size);
+
+		int run = 0;
+
+		for (int k = 1; k < 64; ++k)
+		{
+			const int value = coefficients[Zigzag[k]];
+
+			if (value == 0)
+			{
+				run++;
+
+				continue;
+			}
+
+			// sixteen zeroes at a time
+			while (run > 15)
+			{
+				bits.Put(acTable.m_Codes[0xF0], acTable.m_Sizes[0xF0]);
+				run -= 16;
+			}
+
+			size = BitCount(value);
+
+			const int symbol = (run << 4) | size;
+
+			bits.Put(acTable.m_Codes[symbol], acTable.m_Sizes[symbol]);
+			bits.Put(value < 0 ? value - 1 : value, size);
+
+			run = 0;
+		}
+
+		// end of block, the rest are zero
+		if (run > 0)
+			bits.Put(acTable.m_Codes[0x00], acTable.m_Sizes[0x00]);
+	}
+
+	// byte at a time, inserting a braced list here trips gcc's bounds warnings at -O2
+	void PutBytes(std::vector<uint8_t>& out, const std::initializer_list<uint8_t>& bytes)
+	{
+		for (const uint8_t& byte : bytes)
+		{
+			out.push_back(byte);
+		}
+	}
+
+	void PutMarker(std::vector<uint8_t>& out, const uint8_t& marker, const size_t& length)
+	{
+		out.push_back(0xFF);
+		out.push_back(marker);
+		out.push_back((uint8_t)(length >> 8));
+		out.push_back((uint8_t)length);
+	}
+
+	void PutHuffmanTable(std::vector<uint8_t>& out, const uint8_t& id, const uint8_t* bits, const uint8_t* values)
+	{
+		int count = 0;
+
+		for (int i = 0; i < 16; ++i)
+		{
+			count += bits[i];
+		}
+
+		out.push_back(id);
+		out.insert(out.end(), bits, bits + 16);
+		out.insert(out.end(), values, values + count);
+	}
+}
+
+JpegEncoder::JpegEncoder(const int& width, const int& height, const int& quality, const int& threads) :
+	m_Width(width),
+	m_Height(height),
+	m_Quality(std::clamp(quality, 1, 100))
+{
+	m_McuColumns = (m_Width + 15) / 16;
+	m_McuRows = (m_Height + 15) / 16;
+
+	m_Path = ColourConverter::GetBestPath();
+
+	// same scaling libjpeg gives its quality setting
+	const int scale = m_Quality < 50 ? 5000 / m_Quality : 200 - m_Quality * 2;
+
+	for (int i = 0; i < 64; ++i)
+	{
+		m_QuantTables[0][i] = (uint8_t)std::clamp((LumaQuant[i] * scale + 50) / 100, 1, 255);
+		m_QuantTables[1][i] = (uint8_t)std::clamp((ChromaQuant[i] * scale + 50) / 100, 1, 255);
+
+		m_Reciprocals[0][i] = 1.0f / m_QuantTables[0][i];
+		m_Reciprocals[1][i] = 1.0f / m_QuantTables[1][i];
+	}
+
+	SetThreads(threads);
+}
+
+void JpegEncoder::SetThreads(const int& threads)
+{
+	const int threadCount = std::max(1, threads);
+
+	m_Pool = threadCount > 1 ? std::make_unique<WorkerPool>(threadCount) : nullptr;
+
+	// a couple of slices per thread evens out slices that take longer than the rest
+	m_SliceCount = threadCount > 1 ? std::min(std::max(1, m_McuRows), threadCount * 2) : 1;
+	m_SliceRows = (std::max(1, m_McuRows) + m_SliceCount - 1) / m_SliceCount;
+
+	// the restart interval is counted in macroblocks and has to fit in 16 bits
+	while (m_SliceRows > 1 && m_SliceRows * m_McuColumns > 65535)
+		m_SliceRows--;
+
+	m_SliceCount = (std::max(1, m_McuRows) + m_SliceRows - 1) / m_SliceRows;
+	m_Slices.resize(m_SliceCount);
+
+	BuildHeader();
+}
+
+bool JpegEncoder::SetPath(const Path& path)
+{
+	if (!ColourConverter::IsPathSupported(path))
+		return false;
+
+	m_Path = path;
+
+	return true;
+}
+
+void JpegEncoder::BuildHeader()
+{
+	m_Header.clear();
+
+	// the header is a little over 600 bytes, one allocation covers it
+	m_Header.reserve(640);
+
+	// start of image, then a JFIF marker with no thumbnail
+	PutBytes(m_Header, { 0xFF, 0xD8 });
+
+	PutMarker(m_Header, 0xE0, 16);
+	PutBytes(m_Header, { 'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0 });
+
+	// quantisation tables go out in zigzag order
+	PutMarker(m_Header, 0xDB, 2 + 65 * 2);
+
+	for (int table = 0; table < 2; ++table)
+	{
+		m_Header.push_back((uint8_t)table);
+
+		for (int k = 0; k < 64; ++k)
+		{
+			m_Header.push_back(m_QuantTables[table][Zigzag[k]]);
+		}
+	}
+
+	// baseline, 8 bit, luma at twice the chroma resolution both ways
+	PutMarker(m_Header, 0xC0, 17);
+	PutBytes(m_Header, { 8, (uint8_t)(m_Height >> 8), (uint8_t)m_Height, (uint8_t)(m_Width >> 8), (uint8_t)m_Width, 3 });
+	PutBytes(m_Header, { 1, 0x22, 0, 2, 0x11, 1, 3, 0x11, 1 });
+
+	PutMarker(m_Header, 0xC4, 2 + (1 + 16 + 12) * 2 + (1 + 16 + 162) * 2);
+	PutHuffmanTable(m_Header, 0x00, DCLumaBits, DCValues);
+	PutHuffmanTable(m_Header, 0x10, ACLumaBits, ACLumaValues);
+	PutHuffmanTable(m_Header, 0x01, DCChromaBits, DCValues);
+	PutHuffmanTable(m_Header, 0x11, ACChromaBits, ACChromaValues);
+
+	if (m_SliceCount > 1)
+	{
+		const int interval = m_SliceRows * m_McuColumns;
+
+		PutMarker(m_Header, 0xDD, 4);
+		PutBytes(m_Header, { (uint8_t)(interval >> 8), (uint8_t)interval });
+	}
+
+	// one scan with all three components
+	PutMarker(m_Header, 0xDA, 12);
+	PutBytes(m_Header, { 3, 1, 0x00, 2, 0x11, 3, 0x11, 0, 63, 0 });
+}
+
+bool JpegEncoder::Encode(const void* bgra, std::vector<uint8_t>& out)
+{
+	if (bgra == nullptr || m_Width <= 0 || m_Height <= 0)
+		return false;
+
+	const uint8_t* pixels = (const uint8_t*)bgra;
+
+	if (m_Pool != nullptr)
+	{
+		m_Pool->Run(m_SliceCount, [this, pixels](const int& slice) { EncodeSlice(pixels, slice, m_Slices[slice]); });
+	}
+	else
+	{
+		for (int slice = 0; slice < m_SliceCount; ++slice)
+		{
+			EncodeSlice(pixels, slice, m_Slices[slice]);
+		}
+	}
+
+	size_t size = m_Header.size() + 2;
+
+	for (const std::vector<uint8_t>& slice : m_Slices)
+	{
+		size += slice.size() + 2;
+	}
+
+	out.clear();
+	out.reserve(size);
+	out.insert(out.end(), m_Header.begin(), m_Header.end());
+
+	for (int slice = 0; slice < m_SliceCount; ++slice)
+	{
+		out.insert(out.end(), m_Slices[slice].begin(), m_Slices[slice].end());
+
+		// restart markers count 0 to 7 and wrap
+		if (slice + 1 < m_SliceCount)
+			out.insert(out.end(), { 0xFF, (uint8_t)(0xD0 + (slice & 7)) });
+	}
+
+	out.insert(out.end(), { 0xFF, 0xD9 });
+
+	return true;
+}
+
+void JpegEncoder::EncodeSlice(const uint8_t* bgra, const int& slice, std::vector<uint8_t>& out) const
+{
+	const ForwardDCTFunction forwardDCT = GetForwardDCT(m_Path);
+
+	out.clear();
+
+	JpegBits bits{ out };
+
+	// predictions start again after every restart marker
+	int previousDC[3] = { 0, 0, 0 };
+
+	alignas(32) float blocks[6][64];
+	alignas(32) int16_t coefficients[64];
+
+	const int firstRow = slice * m_SliceRows;
+	const int endRow = std::min(m_McuRows, firstRow + m_SliceRows);
+
+	const size_t stride = (size_t)m_Width * 4;
+
+	for (int mcuY = firstRow; mcuY < endRow; ++mcuY)
+	{
+		for (int mcuX = 0; mcuX < m_McuColumns; ++mcuX)
+		{
+			const int left = mcuX * 16;
+			const int top = mcuY * 16;
+
+			// full range BT.601 as JFIF expects, with the edge pixels repeated where the frame doesn't fill the macroblock
+			for (int y = 0; y < 16; y += 2)
+			{
+				const uint8_t* rows[2];
+
+				for (int i = 0; i < 2; ++i)
+				{
+					// frames are bottom up, JPEG is top down
+					const int row = std::min(top + y + i, m_Height - 1);
+
+					rows[i] = bgra + (size_t)(m_Height - 1 - row) * stride;
+				}
+
+				for (int x = 0; x < 16; x += 2)
+				{
+					int sums[3] = { 0, 0, 0 };
+
+					for (int i = 0; i < 2; ++i)
+					{
+						for (int j = 0; j < 2; ++j)
+						{
+							const uint8_t* px = rows[i] + std::min(left + x + j, m_Width - 1) * 4;
+
+							const int b = px[0];
+							const int g = px[1];
+							const int r = px[2];
+
+							const int luma = (19595 * r + 38470 * g + 7471 * b + 32768) >> 16;
+
+							const int lumaX = x + j;
+							const int lumaY = y + i;
+
+							blocks[(lumaY >> 3) * 2 + (lumaX >> 3)][(lumaY & 7) * 8 + (lumaX & 7)] = (float)(luma - 128);
+
+							sums[0] += b;
+							sums[1] += g;
+							sums[2] += r;
+						}
+					}
+
+					// chroma from the average of each 2x2, already centred on zero
+					const int index = (y >> 1) * 8 + (x >> 1);
+
+					blocks[4][index] = (float)((32768 * sums[0] - 21709 * sums[1] - 11059 * sums[2] + (1 << 17)) >> 18);
+					blocks[5][index] = (float)((-5329 * sums[0] - 27439 * sums[1] + 32768 * sums[2] + (1 << 17)) >> 18);
+				}
+			}
+
+			for (int block = 0; block < 4; ++block)
+			{
+				forwardDCT(blocks[block], m_Reciprocals[0], coefficients);
+				EncodeBlock(bits, coefficients, previousDC[0], DCLuma, ACLuma);
+			}
+
+			forwardDCT(blocks[4], m_Reciprocals[1], coefficients);
+			EncodeBlock(bits, coefficients, previousDC[1], DCChroma, ACChroma);
+
+			forwardDCT(blocks[5], m_Reciprocals[1], coefficients);
+			EncodeBlock(bits, coefficients, previousDC[2], DCChroma, ACChroma);
+		}
+	}
+
+	bits.Flush();
+}
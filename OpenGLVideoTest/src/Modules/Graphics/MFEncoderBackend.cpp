@@ -0,0 +1,493 @@
+#include <Modules/Graphics/MFEncoderBackend.h>
+#include <Modules/Graphics/OutputSink.h>
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+#include <iostream>
+#include <string>
+
+#include <mfapi.h>
+#include <mfidl.h>
+#include <mfreadwrite.h>
+#include <mferror.h>
+
+template <class T> void SafeRelease(T** ppT)
+{
+	if (*ppT)
+	{
+		(*ppT)->Release();
+		*ppT = NULL;
+	}
+}
+
+int FailInitSafely(const char* message, const HRESULT& code, IMFSinkWriter* sinkWriter, IMFMediaType* mediaTypeOut, IMFMediaType* mediaTypeIn)
+{
+	std::cout << "MFEncoderBackend Open Failed - " << message << "(Error code: " << code << ")" << std::endl;
+
+	SafeRelease(&sinkWriter);
+	SafeRelease(&mediaTypeOut);
+	SafeRelease(&mediaTypeIn);
+
+	return -1;
+}
+
+bool MFEncoderBackend::IsSupported()
+{
+	return true;
+}
+
+bool MFEncoderBackend::Startup()
+{
+	HRESULT hr = CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
+
+	if (SUCCEEDED(hr))
+	{
+		hr = MFStartup(MF_VERSION);
+	}
+
+	return SUCCEEDED(hr);
+}
+
+void MFEncoderBackend::Shutdown()
+{
+	MFShutdown();
+
+	CoUninitialize();
+}
+
+MFEncoderBackend::~MFEncoderBackend()
+{
+	Close();
+}
+
+int MFEncoderBackend::Open(const EncoderSettings& settings)
+{
+	Close();
+
+	m_BytesOutput = 0;
+
+	if (OutputSink::IsLiveTarget(settings.m_FilePath))
+	{
+		// the sink writer owns its output, it can only be pointed at a file
+		std::cout << "MFEncoderBackend - Live output needs the Y4M or Raw I420 encoder!" << std::endl;
+
+		return -1;
+	}
+
+	m_Settings = settings;
+
+	m_Converter = ColourConverter(m_Settings.m_FrameWidth, m_Settings.m_FrameHeight, ColourConverter::Format::NV12, m_Settings.m_ColourMatrix);
+
+	const GUID videoEncFormat = MFVideoFormat_WMV3;
+	const GUID videoInFormat = MFVideoFormat_NV12;
+
+	const std::wstring filePath(m_Settings.m_FilePath.begin(), m_Settings.m_FilePath.end());
+
+	IMFSinkWriter* sinkWriter = NULL;
+	IMFMediaType* mediaTypeOut = NULL;
+	IMFMediaType* mediaTypeIn = NULL;
+	DWORD streamIndex;
+
+	HRESULT res = MFCreateSinkWriterFromURL(filePath.c_str(), NULL, NULL, &sinkWriter);
+
+	if (SUCCEEDED(res))
+	{
+		res = MFCreateMediaType(&mediaTypeOut);
+	}
+	else
+	{
+		return FailInitSafely("Couldn't create Sink Writer!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+	}
+
+	if (SUCCEEDED(res))
+	{
+		res = mediaTypeOut->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video);
+	}
+	else
+	{
+		return FailInitSafely("Couldn't create out media type!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+	}
+
+	// SET VIDEO ENCODING FORMAT 
+	if (SUCCEEDED(res))
+	{
+		res = mediaTypeOut->SetGUID(MF_MT_SUBTYPE, videoEncFormat);
+	}
+	else
+	{
+		return FailInitSafely("Couldn't set out media major type!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+	}
+
+	// SET BITRATE
+	if (SUCCEEDED(res))
+	{
+		res = mediaTypeOut->SetUINT32(MF_MT_AVG_BITRATE, m_Settings.m_BitRate);
+	}
+	else
+	{
+		return FailInitSafely("Couldn't set out media video encoding format!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+	}
+
+	if (SUCCEEDED(res))
+	{
+		res = mediaTypeOut->SetUINT32(MF_MT_INTERLACE_MODE, MFVideoInterlace_Progressive);
+	}
+	else
+	{
+		return FailInitSafely("Couldn't set bitrate!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+	}
+
+	if (SUCCEEDED(res))
+	{
+		res = MFSetAttributeSize(mediaTypeOut, MF_MT_FRAME_SIZE, m_Settings.m_FrameWidth, m_Settings.m_FrameHeight);
+	}
+	else
+	{
+		return FailInitSafely("Couldn't set interlace mode!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+	}
+
+	if (SUCCEEDED(res))
+	{
+		res = MFSetAttributeRatio(mediaTypeOut, MF_MT_FRAME_RATE, m_Settings.m_FrameRate, 1);
+	}
+	else
+	{
+		return FailInitSafely("Couldn't set frame size!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+	}
+
+	if (SUCCEEDED(res))
+	{
+		res = MFSetAttributeRatio(mediaTypeOut, MF_MT_PIXEL_ASPECT_RATIO, 1, 1);
+	}
+	else
+	{
+		return FailInitSafely("Couldn't set frame rate!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+	}
+
+	if (SUCCEEDED(res))
+	{
+		res = sinkWriter->AddStream(mediaTypeOut, &streamIndex);
+	}
+	else
+	{
+		return FailInitSafely("Couldn't set aspect ratio!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+	}
+
+	// Set the input media type.
+	if (SUCCEEDED(res))
+	{
+		res = MFCreateMediaType(&mediaTypeIn);
+	}
+	else
+	{
+		return FailInitSafely("Couldn't add stream to sink writer!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+	}
+
+	if (SUCCEEDED(res))
+	{
+		res = mediaTypeIn->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video);
+	}
+	else
+	{
+		return FailInitSafely("Couldn't create in media type!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+	}
+
+	if (SUCCEEDED(res))
+	{
+		res = mediaTypeIn->SetGUID(MF_MT_SUBTYPE, videoInFormat);
+	}
+	else
+	{
+		return FailInitSafely("Couldn't set in media major type!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+	}
+
+	if (SUCCEEDED(res))
+	{
+		res = mediaTypeIn->SetUINT32(MF_MT_INTERLACE_MODE, MFVideoInterlace_Progressive);
+	}
+	else
+	{
+		return FailInitSafely("Couldn't set in media format", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+	}
+
+	if (SUCCEEDED(res))
+	{
+		res = mediaTypeIn->SetUINT32(MF_MT_YUV_MATRIX, m_Settings.m_ColourMatrix == ColourConverter::Matrix::BT709 ? MFVideoTransferMatrix_BT709 : MFVideoTransferMatrix_BT601);
+	}
+	else
+	{
+		return FailInitSafely("Couldn't set in media interlace mode!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+	}
+
+	if (SUCCEEDED(res))
+	{
+		res = MFSetAttributeSize(mediaTypeIn, MF_MT_FRAME_SIZE, m_Settings.m_FrameWidth, m_Settings.m_FrameHeight);
+	}
+	else
+	{
+		return FailInitSafely("Couldn't set in media colour matrix!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+	}
+
+	if (SUCCEEDED(res))
+	{
+		res = MFSetAttributeRatio(mediaTypeIn, MF_MT_FRAME_RATE, m_Settings.m_FrameRate, 1);
+	}
+	else
+	{
+		return FailInitSafely("Couldn't set in media frame size!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+	}
+
+	if (SUCCEEDED(res))
+	{
+		res = MFSetAttributeRatio(mediaTypeIn, MF_MT_PIXEL_ASPECT_RATIO, 1, 1);
+	}
+	else
+	{
+		return FailInitSafely("Couldn't set in media frame rate!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+	}
+
+	if (SUCCEEDED(res))
+	{
+		res = sinkWriter->SetInputMediaType(streamIndex, mediaTypeIn, NULL);
+	}
+	else
+	{
+		return FailInitSafely("Couldn't set in media aspect ratio!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+	}
+
+	// Tell the sink writer to start accepting data.
+	if (SUCCEEDED(res))
+	{
+		res = sinkWriter->BeginWriting();
+	}
+	else
+	{
+		return FailInitSafely("Couldn't set sink writer input media type!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+	}
+
+	// Return the pointer to the caller.
+	if (SUCCEEDED(res))
+	{
+		m_SinkWriter = sinkWriter;
+		m_SinkWriter->AddRef();
+		m_StreamIndex = streamIndex;
+	}
+	else
+	{
+		return FailInitSafely("Couldn't begin writing!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+	}
+
+	SafeRelease(&sinkWriter);
+	SafeRelease(&mediaTypeOut);
+	SafeRelease(&mediaTypeIn);
+
+	return 0;
+}
+
+bool MFEncoderBackend::WriteFrame(const void* frameData, const long long& timestamp, const long long& duration)
+{
+	bool success = true;
+
+	if (m_SinkWriter != nullptr)
+	{
+		IMFSample* pSample = NULL;
+		IMFMediaBuffer* frameBuffer = NULL;
+
+		const DWORD bufferLength = (DWORD)m_Converter.GetOutputSize();
+
+		BYTE* destBuffer = NULL;
+
+		// Create a new memory buffer.
+		HRESULT hr = MFCreateMemoryBuffer(bufferLength, &frameBuffer);
+
+		// Lock the buffer and copy the video frame to the buffer.
+		if (SUCCEEDED(hr) && success)
+		{
+			hr = frameBuffer->Lock(&destBuffer, NULL, NULL);
+		}
+		else
+		{
+			std::cout << "MFEncoderBackend - WriteFrame failed! Error creating frame buffer (err code: " << std::to_string(hr) << ")" << std::endl;
+			success = false;
+		}
+
+		if (SUCCEEDED(hr) && success)
+		{
+			// GL rows are bottom up, the conversion flips them as it goes
+			m_Converter.Convert(frameData, destBuffer, true);
+		}
+		else
+		{
+			std::cout << "MFEncoderBackend - WriteFrame failed! Error locking frame buffer (err code: " << std::to_string(hr) << ")" << std::endl;
+			success = false;
+		}
+
+		if (frameBuffer)
+		{
+			frameBuffer->Unlock();
+		}
+
+		// Set the data length of the buffer.
+		if (SUCCEEDED(hr) && success)
+		{
+			hr = frameBuffer->SetCurrentLength(bufferLength);
+		}
+		else
+		{
+			std::cout << "MFEncoderBackend - WriteFrame failed! Error copying frame (err code: " << std::to_string(hr) << ")" << std::endl;
+			success = false;
+		}
+
+		// Create a media sample and add the buffer to the sample.
+		if (SUCCEEDED(hr) && success)
+		{
+			hr = MFCreateSample(&pSample);
+		}
+		else
+		{
+			std::cout << "MFEncoderBackend - WriteFrame failed! Error setting frame buffer length (err code: " << std::to_string(hr) << ")" << std::endl;
+			success = false;
+		}
+
+		if (SUCCEEDED(hr) && success)
+		{
+			hr = pSample->AddBuffer(frameBuffer);
+		}
+		else
+		{
+			std::cout << "MFEncoderBackend - WriteFrame failed! Error creating sample (err code: " << std::to_string(hr) << ")" << std::endl;
+			success = false;
+		}
+
+		// Set the time stamp and the duration.
+		if (SUCCEEDED(hr) && success)
+		{
+			hr = pSample->SetSampleTime(timestamp);
+		}
+		else
+		{
+			std::cout << "MFEncoderBackend - WriteFrame failed! Error adding frame buffer to sample (err code: " << std::to_string(hr) << ")" << std::endl;
+			success = false;
+		}
+
+		if (SUCCEEDED(hr) && success)
+		{
+			hr = pSample->SetSampleDuration(duration);
+		}
+		else
+		{
+			std::cout << "MFEncoderBackend - WriteFrame failed! Error setting sample timestamp (err code: " << std::to_string(hr) << ")" << std::endl;
+			success = false;
+		}
+
+		// Send the sample to the Sink Writer.
+		if (SUCCEEDED(hr) && success)
+		{
+			hr = m_SinkWriter->WriteSample(m_StreamIndex, pSample);
+		}
+		else
+		{
+			std::cout << "MFEncoderBackend - WriteFrame failed! Error setting sample duration (err code: " << std::to_string(hr) << ")" << std::endl;
+			success = false;
+		}
+
+		if (!SUCCEEDED(hr) && success)
+		{
+			std::cout << "MFEncoderBackend - WriteFrame failed! Error writing sample (err code: " << std::to_string(hr) << ")" << std::endl;
+			success = false;
+		}
+
+		MF_SINK_WRITER_STATISTICS stats{};
+		stats.cb = sizeof(stats);
+
+		if (success && SUCCEEDED(m_SinkWriter->GetStatistics(m_StreamIndex, &stats)))
+		{
+			m_BytesOutput = stats.qwByteCountProcessed;
+		}
+
+		SafeRelease(&pSample);
+		SafeRelease(&frameBuffer);
+	}
+	else
+	{
+		std::cout << "MFEncoderBackend - Not open!" << std::endl;
+		success = false;
+	}
+
+	return success;
+}
+
+bool MFEncoderBackend::Finalize()
+{
+	if (m_SinkWriter == nullptr)
+		return false;
+
+	HRESULT hr = m_SinkWriter->Finalize();
+
+	if (!SUCCEEDED(hr))
+	{
+		std::cout << "MFEncoderBackend - Finalize failed! (err code: " << std::to_string(hr) << ")" << std::endl;
+	}
+
+	MF_SINK_WRITER_STATISTICS stats{};
+	stats.cb = sizeof(stats);
+
+	// the encoder still had frames in it until now
+	if (SUCCEEDED(hr) && SUCCEEDED(m_SinkWriter->GetStatistics(m_StreamIndex, &stats)))
+	{
+		m_BytesOutput = stats.qwByteCountProcessed;
+	}
+
+	Close();
+
+	return SUCCEEDED(hr);
+}
+
+void MFEncoderBackend::Close()
+{
+	SafeRelease(&m_SinkWriter);
+}
+
+#else
+
+// Media Foundation only exists on Windows, the other backends cover everything else
+bool MFEncoderBackend::IsSupported()
+{
+	return false;
+}
+
+bool MFEncoderBackend::Startup()
+{
+	return false;
+}
+
+void MFEncoderBackend::Shutdown()
+{
+}
+
+MFEncoderBackend::~MFEncoderBackend()
+{
+}
+
+int MFEncoderBackend::Open(const EncoderSettings& settings)
+{
+	return -1;
+}
+
+bool MFEncoderBackend::WriteFrame(const void* frameData, const long long& timestamp, const long long& duration)
+{
+	return false;
+}
+
+bool MFEncoderBackend::Finalize()
+{
+	return false;
+}
+
+void MFEncoderBackend::Close()
+{
+}
+
+#endif
@@ -0,0 +1,172 @@
+#include <Modules/Graphics/MJPEGEncoderBackend.h>
+
+#include <iostream>
+#include <algorithm>
+
+MJPEGSegmentEncoder::MJPEGSegmentEncoder(const EncoderSettings& settings, const int& threads) :
+	m_Encoder(settings.m_FrameWidth, settings.m_FrameHeight, settings.m_Quality, threads)
+{
+}
+
+bool MJPEGSegmentEncoder::Encode(const void* frameData, EncodedPacket& packet)
+{
+	packet.m_KeyFrame = true;
+
+	return m_Encoder.Encode(frameData, packet.m_Data);
+}
+
+MJPEGEncoderBackend::~MJPEGEncoderBackend()
+{
+	Close();
+}
+
+int MJPEGEncoderBackend::Open(const EncoderSettings& settings)
+{
+	Close();
+
+	m_Settings = settings;
+	m_HasWriteStats = false;
+	m_BytesOutput = 0;
+
+	m_Encoder = std::make_unique<MJPEGSegmentEncoder>(m_Settings, m_Settings.m_Threads);
+
+	if (!OutputSink::IsLiveTarget(m_Settings.m_FilePath))
+	{
+		m_Muxer = std::make_unique<MatroskaMuxer>();
+
+		if (m_Muxer->Open(m_Settings.m_FilePath, "V_MJPEG", m_Settings.m_FrameWidth, m_Settings.m_FrameHeight, m_Settings.m_FrameRate) != 0)
+		{
+			std::cout << "MJPEGEncoderBackend - Couldn't open '" << m_Settings.m_FilePath << "' for writing!" << std::endl;
+
+			m_Muxer = nullptr;
+
+			return -1;
+		}
+
+		return 0;
+	}
+
+	m_Sink = OutputSink::Create(m_Settings.m_FilePath);
+
+	if (m_Sink->Open(m_Settings.m_FilePath) != 0)
+	{
+		std::cout << "MJPEGEncoderBackend - Couldn't open '" << m_Settings.m_FilePath << "' for writing!" << std::endl;
+
+		m_Sink = nullptr;
+
+		return -1;
+	}
+
+	return 0;
+}
+
+bool MJPEGEncoderBackend::WriteFrame(const void* frameData, const long long& timestamp, const long long& duration)
+{
+	if (m_Encoder == nullptr)
+	{
+		std::cout << "MJPEGEncoderBackend - Not open!" << std::endl;
+
+		return false;
+	}
+
+	m_Packet.m_Timestamp = timestamp;
+	m_Packet.m_Duration = duration;
+
+	return m_Encoder->Encode(frameData, m_Packet) && WritePacket(m_Packet);
+}
+
+std::unique_ptr<SegmentEncoder> MJPEGEncoderBackend::CreateSegmentEncoder() const
+{
+	return std::make_unique<MJPEGSegmentEncoder>(m_Settings, 1);
+}
+
+bool MJPEGEncoderBackend::WritePacket(const EncodedPacket& packet)
+{
+	// matroska keeps every frame's time, so a frame held on screen is stored once
+	if (m_Muxer != nullptr)
+	{
+		if (!m_Muxer->WriteFrame(packet.m_Data.data(), packet.m_Data.size(), packet.m_Timestamp, packet.m_Duration, packet.m_KeyFrame))
+		{
+			std::cout << "MJPEGEncoderBackend - Couldn't write frame!" << std::endl;
+
+			return false;
+		}
+
+		m_BytesOutput += packet.m_Data.size();
+
+		return true;
+	}
+
+	if (m_Sink == nullptr)
+	{
+		std::cout << "MJPEGEncoderBackend - Not open!" << std::endl;
+
+		return false;
+	}
+
+	// a bare stream has no timestamps, so like y4m a frame lasting longer than one frame is written again
+	const long long repeats = std::max(1LL, (packet.m_Duration * m_Settings.m_FrameRate + 5000000) / 10000000);
+
+	for (long long i = 0; i < repeats; ++i)
+	{
+		if (!m_Sink->Write(packet.m_Data.data(), packet.m_Data.size()))
+		{
+			std::cout << "MJPEGEncoderBackend - Couldn't write frame!" << std::endl;
+
+			return false;
+		}
+
+		m_BytesOutput += packet.m_Data.size();
+
+		m_Sink->EndPacket();
+	}
+
+	return true;
+}
+
+bool MJPEGEncoderBackend::Finalize()
+{
+	if (m_Muxer == nullptr && m_Sink == nullptr)
+		return false;
+
+	const bool success = m_Muxer != nullptr ? m_Muxer->Finalize() : m_Sink->Flush();
+
+	Close();
+
+	return success;
+}
+
+void MJPEGEncoderBackend::Close()
+{
+	if (m_Muxer != nullptr)
+	{
+		m_Muxer->Close();
+		m_WriteStats = m_Muxer->GetFile().GetStats();
+		m_HasWriteStats = true;
+		m_Muxer = nullptr;
+	}
+
+	if (m_Sink != nullptr)
+	{
+		m_Sink->Close();
+		m_HasWriteStats = m_Sink->GetWriteStats(m_WriteStats);
+		m_Sink = nullptr;
+	}
+}
+
+bool MJPEGEncoderBackend::GetWriteStats(WriteStats& stats) const
+{
+	if (m_Muxer != nullptr)
+	{
+		stats = m_Muxer->GetFile().GetStats();
+
+		return true;
+	}
+
+	if (m_Sink != nullptr)
+		return m_Sink->GetWriteStats(stats);
+
+	stats = m_WriteStats;
+
+	return m_HasWriteStats;
+}
@@ -0,0 +1,419 @@
+#include <Modules/Graphics/MatroskaMuxer.h>
+
+#include <iostream>
+#include <cstring>
+
+namespace
+{
+	// element ids, with their length marker bits as they appear in the file
+	const uint32_t EBMLId = 0x1A45DFA3;
+	const uint32_t EBMLVersionId = 0x4286;
+	const uint32_t EBMLReadVersionId = 0x42F7;
+	const uint32_t EBMLMaxIdLengthId = 0x42F2;
+	const uint32_t EBMLMaxSizeLengthId = 0x42F3;
+	const uint32_t DocTypeId = 0x4282;
+	const uint32_t DocTypeVersionId = 0x4287;
+	const uint32_t DocTypeReadVersionId = 0x4285;
+
+	const uint32_t SegmentId = 0x18538067;
+
+	const uint32_t SeekHeadId = 0x114D9B74;
+	const uint32_t SeekId = 0x4DBB;
+	const uint32_t SeekIdId = 0x53AB;
+	const uint32_t SeekPositionId = 0x53AC;
+
+	const uint32_t InfoId = 0x1549A966;
+	const uint32_t TimestampScaleId = 0x2AD7B1;
+	const uint32_t DurationId = 0x4489;
+	const uint32_t MuxingAppId = 0x4D80;
+	const uint32_t WritingAppId = 0x5741;
+
+	const uint32_t TracksId = 0x1654AE6B;
+	const uint32_t TrackEntryId = 0xAE;
+	const uint32_t TrackNumberId = 0xD7;
+	const uint32_t TrackUIDId = 0x73C5;
+	const uint32_t TrackTypeId = 0x83;
+	const uint32_t FlagLacingId = 0x9C;
+	const uint32_t CodecIdId = 0x86;
+	const uint32_t DefaultDurationId = 0x23E383;
+	const uint32_t VideoId = 0xE0;
+	const uint32_t PixelWidthId = 0xB0;
+	const uint32_t PixelHeightId = 0xBA;
+
+	const uint32_t ClusterId = 0x1F43B675;
+	const uint32_t ClusterTimestampId = 0xE7;
+	const uint32_t SimpleBlockId = 0xA3;
+
+	const uint32_t CuesId = 0x1C53BB6B;
+	const uint32_t CuePointId = 0xBB;
+	const uint32_t CueTimeId = 0xB3;
+	const uint32_t CueTrackPositionsId = 0xB7;
+	const uint32_t CueTrackId = 0xF7;
+	const uint32_t CueClusterPositionId = 0xF1;
+
+	// sizes that get filled in later are always given all eight bytes
+	const int LongSize = 8;
+	const unsigned long long UnknownSize = 0x01FFFFFFFFFFFFFFULL;
+
+	const uint8_t TrackNumber = 1;
+	const uint8_t KeyFrameFlag = 0x80;
+
+	void PutBigEndian(std::vector<uint8_t>& out, const unsigned long long& value, const int& bytes)
+	{
+		for (int i = bytes - 1; i >= 0; --i)
+		{
+			out.push_back((uint8_t)(value >> (i * 8)));
+		}
+	}
+
+	void PutId(std::vector<uint8_t>& out, const uint32_t& id)
+	{
+		int bytes = 4;
+
+		while (bytes > 1 && (id >> ((bytes - 1) * 8)) == 0)
+			bytes--;
+
+		PutBigEndian(out, id, bytes);
+	}
+
+	// a variable length size, the shortest that fits unless a length is asked for
+	void PutSize(std::vector<uint8_t>& out, const unsigned long long& size, const int& length = 0)
+	{
+		int bytes = length;
+
+		if (bytes == 0)
+		{
+			bytes = 1;
+
+			// all ones is reserved for unknown
+			while (bytes < LongSize && size >= (1ULL << (7 * bytes)) - 1)
+				bytes++;
+		}
+
+		PutBigEndian(out, size | (1ULL << (7 * bytes)), bytes);
+	}
+
+	void PutUnsigned(std::vector<uint8_t>& out, const uint32_t& id, const unsigned long long& value, const int& length = 0)
+	{
+		int bytes = length;
+
+		if (bytes == 0)
+		{
+			bytes = 1;
+
+			while (bytes < 8 && (value >> (bytes * 8)) != 0)
+				bytes++;
+		}
+
+		PutId(out, id);
+		PutSize(out, (unsigned long long)bytes);
+		PutBigEndian(out, value, bytes);
+	}
+
+	void PutDouble(std::vector<uint8_t>& out, const uint32_t& id, const double& value)
+	{
+		unsigned long long bits = 0;
+		memcpy(&bits, &value, sizeof(bits));
+
+		PutId(out, id);
+		PutSize(out, sizeof(bits));
+		PutBigEndian(out, bits, sizeof(bits));
+	}
+
+	void PutString(std::vector<uint8_t>& out, const uint32_t& id, const std::string& value)
+	{
+		PutId(out, id);
+		PutSize(out, value.size());
+		out.insert(out.end(), value.begin(), value.end());
+	}
+
+	void PutMaster(std::vector<uint8_t>& out, const uint32_t& id, const std::vector<uint8_t>& children)
+	{
+		PutId(out, id);
+		PutSize(out, children.size());
+		out.insert(out.end(), children.begin(), children.end());
+	}
+
+	// an entry pointing at a top level element, the position always eight bytes so it can be filled in later
+	void PutSeek(std::vector<uint8_t>& out, const uint32_t& id, const unsigned long long& position, size_t& positionOffset)
+	{
+		std::vector<uint8_t> seekId{};
+		PutId(seekId, id);
+
+		std::vector<uint8_t> seek{};
+		PutMaster(seek, SeekIdId, seekId);
+		PutId(seek, SeekPositionId);
+		PutSize(seek, LongSize);
+
+		positionOffset = seek.size();
+		PutBigEndian(seek, position, LongSize);
+
+		PutId(out, SeekId);
+		PutSize(out, seek.size());
+
+		positionOffset += out.size();
+		out.insert(out.end(), seek.begin(), seek.end());
+	}
+}
+
+MatroskaMuxer::~MatroskaMuxer()
+{
+	Close();
+}
+
+int MatroskaMuxer::Open(const std::string& filePath, const std::string& codecId, const int& width, const int& height, const int& frameRate)
+{
+	Close();
+
+	if (m_File.Open(filePath, ChunkSize, ChunkCount) != 0)
+	{
+		std::cout << "MatroskaMuxer - Couldn't open '" << filePath << "'!" << std::endl;
+
+		return -1;
+	}
+
+	std::vector<uint8_t> ebml{};
+	PutUnsigned(ebml, EBMLVersionId, 1);
+	PutUnsigned(ebml, EBMLReadVersionId, 1);
+	PutUnsigned(ebml, EBMLMaxIdLengthId, 4);
+	PutUnsigned(ebml, EBMLMaxSizeLengthId, 8);
+	PutString(ebml, DocTypeId, "matroska");
+	PutUnsigned(ebml, DocTypeVersionId, 4);
+	PutUnsigned(ebml, DocTypeReadVersionId, 2);
+
+	std::vector<uint8_t> header{};
+	PutMaster(header, EBMLId, ebml);
+
+	// the segment runs to the end of the file, its size is unknown until then
+	PutId(header, SegmentId);
+	m_SegmentSizeOffset = header.size();
+	PutBigEndian(header, UnknownSize, LongSize);
+	m_SegmentDataOffset = header.size();
+
+	std::vector<uint8_t> info{};
+	PutUnsigned(info, TimestampScaleId, (unsigned long long)TimestampScale);
+	PutString(info, MuxingAppId, "OpenGLVideoTest");
+	PutString(info, WritingAppId, "OpenGLVideoTest");
+
+	PutDouble(info, DurationId, 0.0);
+	const size_t durationOffset = info.size() - LongSize;
+
+	std::vector<uint8_t> video{};
+	PutUnsigned(video, PixelWidthId, (unsigned long long)width);
+	PutUnsigned(video, PixelHeightId, (unsigned long long)height);
+
+	std::vector<uint8_t> track{};
+	PutUnsigned(track, TrackNumberId, TrackNumber);
+	PutUnsigned(track, TrackUIDId, TrackNumber);
+	PutUnsigned(track, TrackTypeId, 1);
+	PutUnsigned(track, FlagLacingId, 0);
+	PutString(track, CodecIdId, codecId);
+
+	if (frameRate > 0)
+		PutUnsigned(track, DefaultDurationId, 1000000000ULL / (unsigned long long)frameRate);
+
+	PutMaster(track, VideoId, video);
+
+	std::vector<uint8_t> tracks{};
+	PutMaster(tracks, TrackEntryId, track);
+
+	std::vector<uint8_t> infoElement{};
+	PutMaster(infoElement, InfoId, info);
+
+	std::vector<uint8_t> tracksElement{};
+	PutMaster(tracksElement, TracksId, tracks);
+
+	// every position is eight bytes, so the seek head is the same size whatever it points at
+	size_t cuesPositionOffset = 0;
+	size_t unused = 0;
+
+	std::vector<uint8_t> seeks{};
+	PutSeek(seeks, InfoId, 0, unused);
+	PutSeek(seeks, TracksId, 0, unused);
+	PutSeek(seeks, CuesId, 0, unused);
+
+	std::vector<uint8_t> seekHead{};
+	PutMaster(seekHead, SeekHeadId, seeks);
+
+	const size_t seekHeadSize = seekHead.size();
+	const size_t seekHeadHeaderSize = seekHeadSize - seeks.size();
+
+	seeks.clear();
+	PutSeek(seeks, InfoId, seekHeadSize, unused);
+	PutSeek(seeks, TracksId, seekHeadSize + infoElement.size(), unused);
+	PutSeek(seeks, CuesId, 0, cuesPositionOffset);
+
+	seekHead.clear();
+	PutMaster(seekHead, SeekHeadId, seeks);
+
+	m_CuesPositionOffset = m_SegmentDataOffset + seekHeadHeaderSize + cuesPositionOffset;
+	m_DurationOffset = m_SegmentDataOffset + seekHeadSize + (infoElement.size() - info.size()) + durationOffset;
+
+	header.insert(header.end(), seekHead.begin(), seekHead.end());
+	header.insert(header.end(), infoElement.begin(), infoElement.end());
+	header.insert(header.end(), tracksElement.begin(), tracksElement.end());
+
+	if (!m_File.Write(header.data(), header.size()))
+	{
+		std::cout << "MatroskaMuxer - Couldn't write the header!" << std::endl;
+
+		Close();
+
+		return -2;
+	}
+
+	m_Clusters.clear();
+	m_ClusterOpen = false;
+	m_EndTime = 0;
+	m_FramesWritten = 0;
+	m_Open = true;
+
+	return 0;
+}
+
+bool MatroskaMuxer::WriteFrame(const void* data, const size_t& size, const long long& timestamp, const long long& duration, const bool& keyFrame)
+{
+	if (!m_Open)
+		return false;
+
+	const long long time = timestamp * 100 / TimestampScale;
+
+	// block times are 16 bit offsets from the cluster, so a cluster can't span more than that even without a keyframe
+	const long long offset = m_ClusterOpen ? time - m_Clusters.back().m_Time : 0;
+
+	if (!m_ClusterOpen || offset < 0 || offset > 32767 || (keyFrame && offset >= ClusterDuration))
+	{
+		CloseCluster();
+
+		ClusterEntry cluster;
+		cluster.m_Time = time;
+		cluster.m_Position = m_File.GetPosition() - m_SegmentDataOffset;
+		cluster.m_KeyFrame = keyFrame;
+
+		m_Clusters.push_back(cluster);
+		m_ClusterOpen = true;
+
+		std::vector<uint8_t> clusterHeader{};
+		PutId(clusterHeader, ClusterId);
+		PutBigEndian(clusterHeader, UnknownSize, LongSize);
+		PutUnsigned(clusterHeader, ClusterTimestampId, (unsigned long long)time);
+
+		if (!m_File.Write(clusterHeader.data(), clusterHeader.size()))
+			return false;
+	}
+
+	const long long blockTime = time - m_Clusters.back().m_Time;
+
+	// track, time and flags, then the frame straight after without another copy
+	std::vector<uint8_t> block{};
+	PutId(block, SimpleBlockId);
+	PutSize(block, size + 4);
+	PutSize(block, TrackNumber);
+	PutBigEndian(block, (unsigned long long)(blockTime & 0xFFFF), 2);
+	block.push_back(keyFrame ? KeyFrameFlag : 0);
+
+	if (!m_File.Write(block.data(), block.size()) || !m_File.Write(data, size))
+		return false;
+
+	const long long endTime = (timestamp + duration) * 100 / TimestampScale;
+
+	if (endTime > m_EndTime)
+		m_EndTime = endTime;
+
+	m_FramesWritten++;
+
+	return true;
+}
+
+void MatroskaMuxer::CloseCluster()
+{
+	if (!m_ClusterOpen)
+		return;
+
+	ClusterEntry& cluster = m_Clusters.back();
+
+	// everything after the id and eight byte size
+	cluster.m_Size = m_File.GetPosition() - m_SegmentDataOffset - cluster.m_Position - 4 - LongSize;
+
+	m_ClusterOpen = false;
+}
+
+bool MatroskaMuxer::Finalize()
+{
+	if (!m_Open)
+		return false;
+
+	CloseCluster();
+
+	const unsigned long long cuesPosition = m_File.GetPosition() - m_SegmentDataOffset;
+
+	std::vector<uint8_t> cuePoints{};
+
+	for (const ClusterEntry& cluster : m_Clusters)
+	{
+		if (!cluster.m_KeyFrame)
+			continue;
+
+		std::vector<uint8_t> positions{};
+		PutUnsigned(positions, CueTrackId, TrackNumber);
+		PutUnsigned(positions, CueClusterPositionId, cluster.m_Position);
+
+		std::vector<uint8_t> cuePoint{};
+		PutUnsigned(cuePoint, CueTimeId, (unsigned long long)cluster.m_Time);
+		PutMaster(cuePoint, CueTrackPositionsId, positions);
+
+		PutMaster(cuePoints, CuePointId, cuePoint);
+	}
+
+	bool success = true;
+
+	if (!cuePoints.empty())
+	{
+		std::vector<uint8_t> cues{};
+		PutMaster(cues, CuesId, cuePoints);
+
+		success = m_File.Write(cues.data(), cues.size());
+
+		std::vector<uint8_t> position{};
+		PutBigEndian(position, cuesPosition, LongSize);
+
+		success = success && m_File.WriteAt(m_CuesPositionOffset, position.data(), position.size());
+	}
+
+	// the patches are all small and fixed size, one per cluster and three for the header
+	std::vector<uint8_t> value{};
+	PutDouble(value, DurationId, (double)m_EndTime);
+	success = success && m_File.WriteAt(m_DurationOffset, value.data() + value.size() - LongSize, LongSize);
+
+	value.clear();
+	PutSize(value, m_File.GetPosition() - m_SegmentDataOffset, LongSize);
+	success = success && m_File.WriteAt(m_SegmentSizeOffset, value.data(), value.size());
+
+	for (const ClusterEntry& cluster : m_Clusters)
+	{
+		value.clear();
+		PutSize(value, cluster.m_Size, LongSize);
+
+		success = success && m_File.WriteAt(m_SegmentDataOffset + cluster.m_Position + 4, value.data(), value.size());
+	}
+
+	success = success && m_File.Flush();
+
+	if (!success)
+	{
+		std::cout << "MatroskaMuxer - Failed to finish the file!" << std::endl;
+	}
+
+	Close();
+
+	return success;
+}
+
+void MatroskaMuxer::Close()
+{
+	m_File.Close();
+
+	m_Clusters.clear();
+	m_ClusterOpen = false;
+	m_Open = false;
+}
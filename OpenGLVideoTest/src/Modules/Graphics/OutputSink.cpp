@@ -0,0 +1,601 @@
+#include <Modules/Graphics/OutputSink.h>
+
+#include <iostream>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <chrono>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#else
+#include <cerrno>
+#include <csignal>
+#include <pthread.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#endif
+
+#ifndef _WIN32
+namespace
+{
+	// a fifo has no MSG_NOSIGNAL, so SIGPIPE from a reader that went away is blocked on this thread and taken back off
+	// rather than ignored for the whole process
+	long long WriteFifo(const int& fd, const void* data, const size_t& size)
+	{
+		sigset_t pipeSignal;
+		sigemptyset(&pipeSignal);
+		sigaddset(&pipeSignal, SIGPIPE);
+
+		// one already pending belongs to someone else and is left alone
+		sigset_t pending;
+		sigpending(&pending);
+		const bool alreadyPending = sigismember(&pending, SIGPIPE) == 1;
+
+		sigset_t previous;
+		pthread_sigmask(SIG_BLOCK, &pipeSignal, &previous);
+
+		const long long written = write(fd, data, size);
+		const int error = errno;
+
+		if (written < 0 && error == EPIPE && !alreadyPending)
+		{
+			const timespec noWait{};
+
+			while (sigtimedwait(&pipeSignal, nullptr, &noWait) < 0 && errno == EINTR)
+			{
+			}
+		}
+
+		pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+
+		errno = error;
+
+		return written;
+	}
+}
+#endif
+
+std::unique_ptr<OutputSink> OutputSink::Create(const std::string& target)
+{
+	if (IsLiveTarget(target))
+		return std::make_unique<LiveSink>();
+
+	return std::make_unique<FileSink>();
+}
+
+bool OutputSink::IsLiveTarget(const std::string& target)
+{
+	return target.rfind("tcp://", 0) == 0 || target.rfind("pipe://", 0) == 0 || target.rfind("unix://", 0) == 0;
+}
+
+FileSink::~FileSink()
+{
+	Close();
+}
+
+int FileSink::Open(const std::string& target)
+{
+	Close();
+
+	if (m_File.Open(target, ChunkSize, ChunkCount) != 0)
+	{
+		std::cout << "FileSink - Couldn't open '" << target << "' for writing!" << std::endl;
+
+		return -1;
+	}
+
+	return 0;
+}
+
+bool FileSink::Write(const void* data, const size_t& size)
+{
+	return m_File.Write(data, size);
+}
+
+bool FileSink::Flush()
+{
+	return m_File.Flush();
+}
+
+void FileSink::Close()
+{
+	m_File.Close();
+}
+
+bool FileSink::GetWriteStats(WriteStats& stats) const
+{
+	// still there once closed, so the last flush is counted
+	if (m_File.GetChunkSize() == 0)
+		return false;
+
+	stats = m_File.GetStats();
+
+	return true;
+}
+
+LiveSink::~LiveSink()
+{
+	Close();
+}
+
+int LiveSink::Open(const std::string& target)
+{
+	Close();
+
+	const size_t split = target.find("://");
+
+	const std::string scheme = target.substr(0, split);
+	m_Address = target.substr(split + 3);
+
+	if (scheme == "tcp")
+	{
+		m_Transport = Transport::Tcp;
+	}
+	else if (scheme == "pipe")
+	{
+		m_Transport = Transport::Pipe;
+	}
+	else
+	{
+		m_Transport = Transport::Unix;
+	}
+
+#ifdef _WIN32
+	if (m_Transport == Transport::Unix)
+	{
+		std::cout << "LiveSink - Unix sockets aren't supported here, use tcp:// or pipe://" << std::endl;
+
+		return -1;
+	}
+#else
+	// bind would take a cut down path and the client would never find the socket
+	if (m_Transport == Transport::Unix && m_Address.size() >= sizeof(sockaddr_un::sun_path))
+	{
+		std::cout << "LiveSink - Unix socket path '" << m_Address << "' is " << m_Address.size() << " bytes, it has to be under " << sizeof(sockaddr_un::sun_path) << "!" << std::endl;
+
+		return -3;
+	}
+#endif
+
+	m_Listening = !m_Address.empty() && Listen();
+
+	if (!m_Listening)
+	{
+		std::cout << "LiveSink - Couldn't listen on '" << target << "'!" << std::endl;
+
+		Close();
+
+		return -2;
+	}
+
+	m_Clients = 0;
+	m_BytesSent = 0;
+
+	std::cout << "LiveSink - Waiting for a client on '" << target << "', frames are dropped until one connects" << std::endl;
+
+	return 0;
+}
+
+bool LiveSink::Listen()
+{
+#ifdef _WIN32
+	if (m_Transport == Transport::Pipe)
+	{
+		const std::string pipeName = "\\\\.\\pipe\\" + m_Address;
+
+		// no wait mode lets ConnectNamedPipe be polled between packets
+		HANDLE pipe = CreateNamedPipeA(pipeName.c_str(), PIPE_ACCESS_OUTBOUND, PIPE_TYPE_BYTE | PIPE_NOWAIT, 1, 1024 * 1024, 0, 0, NULL);
+
+		if (pipe == INVALID_HANDLE_VALUE)
+			return false;
+
+		m_Listener = (long long)(intptr_t)pipe;
+
+		return true;
+	}
+
+	static bool wsaStarted = false;
+
+	if (!wsaStarted)
+	{
+		WSADATA wsaData;
+
+		if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+			return false;
+
+		wsaStarted = true;
+	}
+
+	SOCKET listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+	if (listener == INVALID_SOCKET)
+		return false;
+
+	m_Listener = (long long)listener;
+
+	sockaddr_in address{};
+	address.sin_family = AF_INET;
+	address.sin_port = htons((u_short)std::atoi(m_Address.c_str()));
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	u_long nonBlocking = 1;
+
+	return bind(listener, (sockaddr*)&address, sizeof(address)) == 0 && listen(listener, 1) == 0 && ioctlsocket(listener, FIONBIO, &nonBlocking) == 0;
+#else
+	if (m_Transport == Transport::Pipe)
+	{
+		// a reader can only open the fifo once it exists, the writing end is opened when one does
+		if (mkfifo(m_Address.c_str(), 0600) != 0 && errno != EEXIST)
+			return false;
+
+		return true;
+	}
+
+	int listener = -1;
+
+	if (m_Transport == Transport::Unix)
+	{
+		listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+		if (listener < 0)
+			return false;
+
+		m_Listener = listener;
+
+		sockaddr_un address{};
+		address.sun_family = AF_UNIX;
+		std::memcpy(address.sun_path, m_Address.c_str(), m_Address.size() + 1);
+
+		unlink(m_Address.c_str());
+
+		if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0)
+			return false;
+	}
+	else
+	{
+		listener = socket(AF_INET, SOCK_STREAM, 0);
+
+		if (listener < 0)
+			return false;
+
+		m_Listener = listener;
+
+		int reuse = 1;
+		setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+		sockaddr_in address{};
+		address.sin_family = AF_INET;
+		address.sin_port = htons((uint16_t)std::atoi(m_Address.c_str()));
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0)
+			return false;
+	}
+
+	return listen(listener, 1) == 0 && fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK) == 0;
+#endif
+}
+
+bool LiveSink::Accept()
+{
+#ifdef _WIN32
+	if (m_Transport == Transport::Pipe)
+	{
+		HANDLE pipe = (HANDLE)(intptr_t)m_Listener;
+
+		if (ConnectNamedPipe(pipe, NULL) || GetLastError() == ERROR_PIPE_CONNECTED)
+		{
+			// writes stay non blocking, Send waits a while for a slow reader rather than losing half a frame
+			m_Client = m_Listener;
+
+			return true;
+		}
+
+		if (GetLastError() == ERROR_NO_DATA)
+		{
+			// the last reader went away before we noticed, free the instance for the next one
+			DisconnectNamedPipe(pipe);
+		}
+
+		return false;
+	}
+
+	SOCKET client = accept((SOCKET)m_Listener, NULL, NULL);
+
+	if (client == INVALID_SOCKET)
+		return false;
+
+	// sockets accepted from a non blocking listener are non blocking too, Send waits on them with a timeout
+
+	BOOL noDelay = TRUE;
+	setsockopt(client, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+
+	m_Client = (long long)client;
+
+	return true;
+#else
+	if (m_Transport == Transport::Pipe)
+	{
+		// fails with ENXIO until a reader has the fifo open
+		int fifo = open(m_Address.c_str(), O_WRONLY | O_NONBLOCK);
+
+		if (fifo < 0)
+			return false;
+
+		m_Client = fifo;
+
+		return true;
+	}
+
+	int client = accept((int)m_Listener, nullptr, nullptr);
+
+	if (client < 0)
+		return false;
+
+	// left non blocking, Send waits on it with a timeout
+	fcntl(client, F_SETFL, fcntl(client, F_GETFL) | O_NONBLOCK);
+
+	if (m_Transport == Transport::Tcp)
+	{
+		int noDelay = 1;
+		setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+	}
+
+	m_Client = client;
+
+	return true;
+#endif
+}
+
+bool LiveSink::WaitForSpace(const int& timeoutMs)
+{
+	if (timeoutMs <= 0)
+		return false;
+
+#ifdef _WIN32
+	if (m_Transport == Transport::Pipe)
+	{
+		// a non blocking pipe can't be waited on, it is tried again shortly
+		Sleep(1);
+
+		return true;
+	}
+
+	fd_set writeSet;
+	FD_ZERO(&writeSet);
+	FD_SET((SOCKET)m_Client, &writeSet);
+
+	timeval timeout{ timeoutMs / 1000, (timeoutMs % 1000) * 1000 };
+
+	return select(0, NULL, &writeSet, NULL, &timeout) > 0;
+#else
+	pollfd client{ (int)m_Client, POLLOUT, 0 };
+
+	int ready = 0;
+
+	do
+	{
+		ready = poll(&client, 1, timeoutMs);
+	}
+	while (ready < 0 && errno == EINTR);
+
+	return ready > 0;
+#endif
+}
+
+bool LiveSink::Send(const void* data, const size_t& size)
+{
+	const char* bytes = (const char*)data;
+	size_t sent = 0;
+
+	// the client handle never blocks, a reader that takes nothing for this long is dropped rather than holding up the writer
+	std::chrono::steady_clock::time_point lastProgress = std::chrono::steady_clock::now();
+
+	while (sent < size)
+	{
+		const size_t chunk = size - sent < MaxChunk ? size - sent : MaxChunk;
+
+		bool full = false;
+
+#ifdef _WIN32
+		long long written = 0;
+
+		if (m_Transport == Transport::Pipe)
+		{
+			DWORD pipeWritten = 0;
+
+			if (WriteFile((HANDLE)(intptr_t)m_Client, bytes + sent, (DWORD)chunk, &pipeWritten, NULL))
+				written = pipeWritten;
+			else
+				written = -1;
+
+			// a full non blocking pipe takes nothing and still succeeds
+			full = written == 0;
+		}
+		else
+		{
+			written = send((SOCKET)m_Client, bytes + sent, (int)chunk, 0);
+
+			full = written < 0 && WSAGetLastError() == WSAEWOULDBLOCK;
+		}
+#else
+		long long written = m_Transport == Transport::Pipe ? WriteFifo((int)m_Client, bytes + sent, chunk) : send((int)m_Client, bytes + sent, chunk, MSG_NOSIGNAL);
+
+		if (written < 0 && errno == EINTR)
+			continue;
+
+		full = written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+#endif
+
+		if (full)
+		{
+			const long long waitedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - lastProgress).count();
+
+			if (!WaitForSpace(SendTimeoutMs - (int)waitedMs))
+			{
+				std::cout << "LiveSink - Client took nothing for " << SendTimeoutMs << "ms, dropping it" << std::endl;
+
+				return false;
+			}
+
+			continue;
+		}
+
+		if (written <= 0)
+			return false;
+
+		sent += (size_t)written;
+		lastProgress = std::chrono::steady_clock::now();
+	}
+
+	m_BytesSent += size;
+
+	return true;
+}
+
+void LiveSink::Disconnect()
+{
+	if (m_Client == -1)
+		return;
+
+#ifdef _WIN32
+	if (m_Transport == Transport::Pipe)
+	{
+		HANDLE pipe = (HANDLE)(intptr_t)m_Client;
+
+		DisconnectNamedPipe(pipe);
+
+		// back to polling for the next reader
+		DWORD mode = PIPE_READMODE_BYTE | PIPE_NOWAIT;
+		SetNamedPipeHandleState(pipe, &mode, NULL, NULL);
+	}
+	else
+	{
+		closesocket((SOCKET)m_Client);
+	}
+#else
+	close((int)m_Client);
+#endif
+
+	m_Client = -1;
+}
+
+bool LiveSink::WriteHeader(const void* data, const size_t& size)
+{
+	m_Header.assign((const unsigned char*)data, (const unsigned char*)data + size);
+
+	return true;
+}
+
+void LiveSink::BeginPacket(const bool& keyFrame)
+{
+	if (!m_WaitingForKeyFrame)
+		return;
+
+	if (keyFrame)
+		m_WaitingForKeyFrame = false;
+	else
+		m_SkipPacket = true;
+}
+
+bool LiveSink::Write(const void* data, const size_t& size)
+{
+	// nobody listening is not an error, the frame just isn't seen
+	if (m_Client == -1 || m_ClientLost || m_SkipPacket)
+		return true;
+
+	if (!Send(data, size))
+	{
+		std::cout << "LiveSink - Client disconnected, waiting for another" << std::endl;
+
+		m_ClientLost = true;
+	}
+
+	return true;
+}
+
+bool LiveSink::EndPacket()
+{
+	m_SkipPacket = false;
+
+	if (m_ClientLost)
+	{
+		Disconnect();
+
+		m_ClientLost = false;
+	}
+
+	if (m_Client == -1 && m_Listening && Accept())
+	{
+		m_Clients++;
+
+		std::cout << "LiveSink - Client connected to '" << m_Address << "'" << std::endl;
+
+		if (!m_Header.empty() && !Send(m_Header.data(), m_Header.size()))
+		{
+			Disconnect();
+		}
+
+		// backends that never call BeginPacket have no inter frames, so waiting never holds them back
+		m_WaitingForKeyFrame = m_Client != -1;
+	}
+
+	return true;
+}
+
+void LiveSink::Close()
+{
+	Disconnect();
+
+#ifdef _WIN32
+	if (m_Listener != -1)
+	{
+		if (m_Transport == Transport::Pipe)
+			CloseHandle((HANDLE)(intptr_t)m_Listener);
+		else
+			closesocket((SOCKET)m_Listener);
+	}
+#else
+	if (m_Listener != -1 && m_Transport != Transport::Pipe)
+	{
+		close((int)m_Listener);
+	}
+
+	if (m_Listening && m_Transport != Transport::Tcp && !m_Address.empty())
+	{
+		unlink(m_Address.c_str());
+	}
+#endif
+
+	m_Listener = -1;
+	m_Listening = false;
+	m_ClientLost = false;
+	m_WaitingForKeyFrame = false;
+	m_SkipPacket = false;
+	m_Header.clear();
+}
+
+const char* LiveSink::GetName() const
+{
+	switch (m_Transport)
+	{
+	case Transport::Tcp:
+		return "TCP";
+	case Transport::Pipe:
+		return "Pipe";
+	case Transport::Unix:
+		return "Unix Socket";
+	default:
+		return "Unknown";
+	}
+}
@@ -0,0 +1,38 @@
+#include <Modules/Graphics/PipelineStage.h>
+
+void PipelineStage::Reset(const size_t& capacity)
+{
+	m_Items = 0;
+	m_Dropped = 0;
+	m_BusyNs = 0;
+	m_IdleNs = 0;
+	m_StallNs = 0;
+
+	m_Depth = 0;
+	m_MaxDepth = 0;
+	m_Capacity = capacity;
+
+	m_Start = Clock::now();
+}
+
+void PipelineStage::SetDepth(const size_t& depth)
+{
+	m_Depth = depth;
+
+	if (depth > m_MaxDepth)
+		m_MaxDepth = depth;
+}
+
+double PipelineStage::GetThroughput() const
+{
+	const double seconds = std::chrono::duration<double>(Clock::now() - m_Start).count();
+
+	return seconds > 0.0 ? m_Items / seconds : 0.0;
+}
+
+double PipelineStage::GetLoad() const
+{
+	const long long elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_Start).count();
+
+	return elapsedNs > 0 ? (double)m_BusyNs / elapsedNs : 0.0;
+}
@@ -0,0 +1,164 @@
+#include <Modules/Graphics/PixelReadback.h>
+#include <Modules/Graphics/Common.h>
+
+#include <algorithm>
+#include <iostream>
+
+PixelReadback::PixelReadback(const unsigned int& bufferSize, const int& depth) : m_BufferSize(bufferSize)
+{
+	m_Slots.resize(std::clamp(depth, MinDepth, MaxDepth));
+
+	for (Slot& slot : m_Slots)
+	{
+		GL_CALL(glGenBuffers(1, &slot.m_Buffer));
+		GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.m_Buffer));
+		GL_CALL(glBufferData(GL_PIXEL_PACK_BUFFER, m_BufferSize, NULL, GL_STREAM_READ));
+	}
+
+	GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+}
+
+PixelReadback::~PixelReadback()
+{
+	Reset();
+
+	for (Slot& slot : m_Slots)
+	{
+		GL_CALL(glDeleteBuffers(1, &slot.m_Buffer));
+	}
+}
+
+PixelReadback::ReadResult PixelReadback::Read(const int& x, const int& y, const int& width, const int& height)
+{
+	if (width <= 0 || height <= 0 || (unsigned long long)width * height * 4 > m_BufferSize)
+		return ReadResult::TooLarge;
+
+	// every buffer is still in flight, the oldest has to be collected before we can reuse it
+	if (m_Pending == GetDepth())
+	{
+		++m_StallCount;
+
+		return ReadResult::RingFull;
+	}
+
+	Slot& slot = m_Slots[(m_Head + m_Pending) % GetDepth()];
+	slot.m_ReadAt = std::chrono::steady_clock::now();
+
+	GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.m_Buffer));
+	GL_CALL(glReadPixels(x, y, width, height, GL_BGRA, GL_UNSIGNED_BYTE, NULL));
+	GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+	// not GL_CALL, a missing fence is handled rather than a reason to break
+	ClearGLErrors();
+	slot.m_Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	if (slot.m_Fence == nullptr)
+	{
+		// mapping without a fence still waits for the read, it just can't be polled first
+		ClearGLErrors();
+		++m_FenceFailCount;
+	}
+
+	++m_Pending;
+	++m_ReadCount;
+
+	return ReadResult::Read;
+}
+
+const void* PixelReadback::Map(const bool& wait)
+{
+	if (m_Pending == 0 || m_Mapped)
+		return nullptr;
+
+	Slot& slot = m_Slots[m_Head];
+
+	if (slot.m_Fence != nullptr)
+	{
+		// zero timeout just polls, only block when the caller really needs the frame
+		GLuint64 timeout = wait ? 1000ull * 1000ull * 1000ull : 0;
+
+		ClearGLErrors();
+		GLenum status = glClientWaitSync(slot.m_Fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+
+		if (status == GL_TIMEOUT_EXPIRED)
+		{
+			++m_FencePendingCount;
+
+			return nullptr;
+		}
+
+		if (status == GL_WAIT_FAILED)
+		{
+			// the fence will never signal, so fall through and let the map wait for the read instead
+			ClearGLErrors();
+			++m_FenceFailCount;
+		}
+
+		GL_CALL(glDeleteSync(slot.m_Fence));
+		slot.m_Fence = nullptr;
+	}
+
+	GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.m_Buffer));
+	ClearGLErrors();
+	void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, m_BufferSize, GL_MAP_READ_BIT);
+
+	if (data == nullptr)
+	{
+		const GLenum error = glGetError();
+		ClearGLErrors();
+
+		std::cout << "PixelReadback - Couldn't map read " << m_ReadCount - m_Pending << " (OpenGL error " << error << "), skipping it" << std::endl;
+
+		++m_MapFailCount;
+
+		GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+		// nothing we can do with this read, move past it
+		m_Head = (m_Head + 1) % GetDepth();
+		--m_Pending;
+
+		return nullptr;
+	}
+
+	m_Mapped = true;
+
+	return data;
+}
+
+void PixelReadback::Unmap()
+{
+	if (!m_Mapped)
+		return;
+
+	GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, m_Slots[m_Head].m_Buffer));
+	GL_CALL(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+	GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+	m_Mapped = false;
+
+	m_Head = (m_Head + 1) % GetDepth();
+	--m_Pending;
+}
+
+void PixelReadback::Reset()
+{
+	Unmap();
+
+	for (Slot& slot : m_Slots)
+	{
+		if (slot.m_Fence != nullptr)
+		{
+			GL_CALL(glDeleteSync(slot.m_Fence));
+			slot.m_Fence = nullptr;
+		}
+	}
+
+	m_Head = 0;
+	m_Pending = 0;
+
+	m_ReadCount = 0;
+	m_FencePendingCount = 0;
+	m_StallCount = 0;
+	m_FenceFailCount = 0;
+	m_MapFailCount = 0;
+}
@@ -0,0 +1,75 @@
+#include <Modules/Graphics/RenderTarget.h>
+#include <Modules/Graphics/Common.h>
+
+RenderTarget::RenderTarget(const int& width, const int& height) :
+	m_Width(width),
+	m_Height(height)
+{
+	GL_CALL(glGenRenderbuffers(1, &m_ColourBuffer));
+	GL_CALL(glBindRenderbuffer(GL_RENDERBUFFER, m_ColourBuffer));
+	GL_CALL(glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_Width, m_Height));
+	GL_CALL(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+
+	GL_CALL(glGenFramebuffers(1, &m_ID));
+	GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, m_ID));
+	GL_CALL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_ColourBuffer));
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "RenderTarget - Framebuffer " << m_Width << "x" << m_Height << " is incomplete!" << std::endl;
+	}
+
+	GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
+
+RenderTarget::~RenderTarget()
+{
+	GL_CALL(glDeleteFramebuffers(1, &m_ID));
+	GL_CALL(glDeleteRenderbuffers(1, &m_ColourBuffer));
+}
+
+void RenderTarget::Bind(bool makeBind) const
+{
+	GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, makeBind ? m_ID : 0));
+}
+
+void RenderTarget::BindRead(bool makeBind) const
+{
+	GL_CALL(glBindFramebuffer(GL_READ_FRAMEBUFFER, makeBind ? m_ID : 0));
+}
+
+void RenderTarget::BlitFrom(const unsigned int& source, const int& sourceWidth, const int& sourceHeight, const bool& linear) const
+{
+	BlitFrom(source, 0, 0, sourceWidth, sourceHeight, linear);
+}
+
+void RenderTarget::BlitFrom(const unsigned int& source, const int& sourceX, const int& sourceY, const int& sourceWidth, const int& sourceHeight, const bool& linear) const
+{
+	GL_CALL(glBindFramebuffer(GL_READ_FRAMEBUFFER, source));
+	GL_CALL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_ID));
+
+	GL_CALL(glBlitFramebuffer(sourceX, sourceY, sourceX + sourceWidth, sourceY + sourceHeight, 0, 0, m_Width, m_Height, GL_COLOR_BUFFER_BIT, linear ? GL_LINEAR : GL_NEAREST));
+
+	GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
+
+void RenderTarget::BlitTo(const unsigned int& destination, const int& x, const int& y, const int& width, const int& height, const bool& linear) const
+{
+	GL_CALL(glBindFramebuffer(GL_READ_FRAMEBUFFER, m_ID));
+	GL_CALL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, destination));
+
+	GL_CALL(glBlitFramebuffer(0, 0, m_Width, m_Height, x, y, x + width, y + height, GL_COLOR_BUFFER_BIT, linear ? GL_LINEAR : GL_NEAREST));
+
+	GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
+
+bool RenderTarget::IsComplete() const
+{
+	GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, m_ID));
+
+	const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+	GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+
+	return complete;
+}
@@ -0,0 +1,785 @@
+#include <Modules/Graphics/ScreenCodec.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	typedef ScreenCodec::TileMode TileMode;
+
+	// a tile header is the mode and a six bit count, how many more tiles a skip covers or how many colours a palette has
+	const int MaxHeaderCount = 63;
+
+	const int MaxPaletteColours = 16;
+
+	// ops for pixel tiles, the first four work as they do in QOI
+	const uint8_t OpIndex = 0x00;
+	const uint8_t OpDiff = 0x40;
+	const uint8_t OpLuma = 0x80;
+	const uint8_t OpRun = 0xC0;
+	const uint8_t OpMask = 0xC0;
+
+	// a literal colour, then a run of pixels that match the previous frame, which only inter frames use
+	const uint8_t OpColour = 0xFE;
+	const uint8_t OpPrevious = 0xFF;
+
+	const int MaxRun = 62;
+	const int MaxPrevious = 256;
+
+	// alpha is whatever the framebuffer had, nothing reads it so only colour is compared and kept
+	const uint32_t ColourMask = 0x00FFFFFF;
+	const uint32_t OpaqueAlpha = 0xFF000000;
+
+	inline uint32_t LoadColour(const uint8_t* pixel)
+	{
+		uint32_t value;
+		memcpy(&value, pixel, 4);
+
+		return value & ColourMask;
+	}
+
+	inline void StoreColour(uint8_t* pixel, const uint32_t& colour)
+	{
+		const uint32_t value = colour | OpaqueAlpha;
+		memcpy(pixel, &value, 4);
+	}
+
+	inline int Hash(const uint32_t& colour)
+	{
+		return ((colour & 0xFF) * 7 + ((colour >> 8) & 0xFF) * 5 + ((colour >> 16) & 0xFF) * 3) & 63;
+	}
+
+	inline uint8_t Header(const TileMode& mode, const int& count)
+	{
+		return (uint8_t)((int)mode | (count << 2));
+	}
+
+	inline void PutColour(std::vector<uint8_t>& out, const uint32_t& colour)
+	{
+		out.insert(out.end(), { (uint8_t)colour, (uint8_t)(colour >> 8), (uint8_t)(colour >> 16) });
+	}
+
+	inline uint32_t GetColour(const uint8_t* data)
+	{
+		return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16);
+	}
+
+	inline int PaletteBits(const int& colours)
+	{
+		return colours <= 2 ? 1 : (colours <= 4 ? 2 : 4);
+	}
+
+	void EncodePixels(const uint8_t* source, const uint8_t* reference, const size_t& stride, const int& width, const int& height, std::vector<uint8_t>& out)
+	{
+		uint32_t cache[64]{};
+		uint32_t last = 0;
+
+		// pending runs of the last colour, and of pixels the previous frame already has
+		int run = 0;
+		int previous = 0;
+
+		for (int y = 0; y < height; ++y)
+		{
+			const uint8_t* sourceRow = source + y * stride;
+			const uint8_t* referenceRow = reference != nullptr ? reference + y * stride : nullptr;
+
+			for (int x = 0; x < width; ++x)
+			{
+				const uint32_t colour = LoadColour(sourceRow + x * 4);
+
+				if (referenceRow != nullptr && colour == LoadColour(referenceRow + x * 4))
+				{
+					if (run > 0)
+					{
+						out.push_back((uint8_t)(OpRun | (run - 1)));
+						run = 0;
+					}
+
+					if (++previous == MaxPrevious)
+					{
+						out.insert(out.end(), { OpPrevious, (uint8_t)(previous - 1) });
+						previous = 0;
+					}
+
+					last = colour;
+
+					continue;
+				}
+
+				if (previous > 0)
+				{
+					out.insert(out.end(), { OpPrevious, (uint8_t)(previous - 1) });
+					previous = 0;
+				}
+
+				if (colour == last)
+				{
+					if (++run == MaxRun)
+					{
+						out.push_back((uint8_t)(OpRun | (run - 1)));
+						run = 0;
+					}
+
+					continue;
+				}
+
+				if (run > 0)
+				{
+					out.push_back((uint8_t)(OpRun | (run - 1)));
+					run = 0;
+				}
+
+				const int hash = Hash(colour);
+
+				if (cache[hash] == colour)
+				{
+					out.push_back((uint8_t)(OpIndex | hash));
+				}
+				else
+				{
+					cache[hash] = colour;
+
+					const int db = (int8_t)(uint8_t)(colour - last);
+					const int dg = (int8_t)(uint8_t)((colour >> 8) - (last >> 8));
+					const int dr = (int8_t)(uint8_t)((colour >> 16) - (last >> 16));
+
+					const int drg = dr - dg;
+					const int dbg = db - dg;
+
+					if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+					{
+						out.push_back((uint8_t)(OpDiff | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2)));
+					}
+					else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7)
+					{
+						out.insert(out.end(), { (uint8_t)(OpLuma | (dg + 32)), (uint8_t)(((drg + 8) << 4) | (dbg + 8)) });
+					}
+					else
+					{
+						out.push_back(OpColour);
+						PutColour(out, colour);
+					}
+				}
+
+				last = colour;
+			}
+		}
+
+		if (run > 0)
+			out.push_back((uint8_t)(OpRun | (run - 1)));
+
+		if (previous > 0)
+			out.insert(out.end(), { OpPrevious, (uint8_t)(previous - 1) });
+	}
+
+	TileMode EncodeTile(const uint8_t* source, const uint8_t* reference, const size_t& stride, const int& width, const int& height, std::vector<uint8_t>& out)
+	{
+		// text and widgets rarely use more than a handful of colours in a tile, one too many and palettes are off the table
+		uint32_t palette[MaxPaletteColours]{};
+		int colours = 0;
+		bool paletteFits = true;
+
+		for (int y = 0; y < height && paletteFits; ++y)
+		{
+			const uint8_t* row = source + y * stride;
+			uint32_t last = ~0u;
+
+			for (int x = 0; x < width; ++x)
+			{
+				const uint32_t colour = LoadColour(row + x * 4);
+
+				if (colour == last)
+					continue;
+
+				last = colour;
+
+				int i = 0;
+
+				while (i < colours && palette[i] != colour)
+					i++;
+
+				if (i == colours)
+				{
+					if (colours == MaxPaletteColours)
+					{
+						paletteFits = false;
+						break;
+					}
+
+					palette[colours++] = colour;
+				}
+			}
+		}
+
+		if (paletteFits && colours == 1)
+		{
+			out.push_back(Header(TileMode::Solid, 0));
+			PutColour(out, palette[0]);
+
+			return TileMode::Solid;
+		}
+
+		const size_t start = out.size();
+
+		out.push_back(Header(TileMode::Pixels, 0));
+
+		EncodePixels(source, reference, stride, width, height, out);
+
+		if (!paletteFits)
+			return TileMode::Pixels;
+
+		// packed indices win on busy tiles like text, runs win on tiles that are mostly one colour
+		const int bits = PaletteBits(colours);
+		const size_t paletteSize = 1 + (size_t)colours * 3 + ((size_t)width * height * bits + 7) / 8;
+
+		if (paletteSize >= out.size() - start)
+			return TileMode::Pixels;
+
+		out.resize(start);
+		out.push_back(Header(TileMode::Palette, colours - 1));
+
+		for (int i = 0; i < colours; ++i)
+		{
+			PutColour(out, palette[i]);
+		}
+
+		// indices are packed high bits first and carry on from one row to the next
+		uint32_t accumulator = 0;
+		int pending = 0;
+		int index = 0;
+
+		for (int y = 0; y < height; ++y)
+		{
+			const uint8_t* row = source + y * stride;
+
+			for (int x = 0; x < width; ++x)
+			{
+				const uint32_t colour = LoadColour(row + x * 4);
+
+				if (palette[index] != colour)
+				{
+					index = 0;
+
+					while (palette[index] != colour)
+						index++;
+				}
+
+				accumulator = (accumulator << bits) | (uint32_t)index;
+				pending += bits;
+
+				if (pending == 8)
+				{
+					out.push_back((uint8_t)accumulator);
+					accumulator = 0;
+					pending = 0;
+				}
+			}
+		}
+
+		if (pending > 0)
+			out.push_back((uint8_t)(accumulator << (8 - pending)));
+
+		return TileMode::Palette;
+	}
+
+	bool DecodePixels(const uint8_t* data, const size_t& size, size_t& position, uint8_t* target, const size_t& stride, const int& width, const int& height, const bool& keyFrame)
+	{
+		uint32_t cache[64]{};
+		uint32_t last = 0;
+
+		const int pixelCount = width * height;
+		int pixel = 0;
+
+		while (pixel < pixelCount)
+		{
+			if (position >= size)
+				return false;
+
+			const uint8_t op = data[position++];
+
+			int count = 1;
+
+			if (op == OpPrevious)
+			{
+				if (keyFrame || position >= size)
+					return false;
+
+				count = data[position++] + 1;
+
+				if (pixel + count > pixelCount)
+					return false;
+
+				// the target already holds the previous frame, so the pixels are just stepped over
+				pixel += count;
+
+				const int end = pixel - 1;
+				last = LoadColour(target + (end / width) * stride + (end % width) * 4);
+
+				continue;
+			}
+
+			if (op == OpColour)
+			{
+				if (position + 3 > size)
+					return false;
+
+				last = GetColour(data + position);
+				position += 3;
+
+				cache[Hash(last)] = last;
+			}
+			else if ((op & OpMask) == OpIndex)
+			{
+				last = cache[op & 63];
+			}
+			else if ((op & OpMask) == OpDiff)
+			{
+				const uint32_t b = (last + ((op & 3) - 2)) & 0xFF;
+				const uint32_t g = ((last >> 8) + (((op >> 2) & 3) - 2)) & 0xFF;
+				const uint32_t r = ((last >> 16) + (((op >> 4) & 3) - 2)) & 0xFF;
+
+				last = b | (g << 8) | (r << 16);
+				cache[Hash(last)] = last;
+			}
+			else if ((op & OpMask) == OpLuma)
+			{
+				if (position >= size)
+					return false;
+
+				const int dg = (op & 63) - 32;
+				const int drg = (data[position] >> 4) - 8;
+				const int dbg = (data[position] & 15) - 8;
+				position++;
+
+				const uint32_t b = (last + dg + dbg) & 0xFF;
+				const uint32_t g = ((last >> 8) + dg) & 0xFF;
+				const uint32_t r = ((last >> 16) + dg + drg) & 0xFF;
+
+				last = b | (g << 8) | (r << 16);
+				cache[Hash(last)] = last;
+			}
+			else
+			{
+				count = (op & 63) + 1;
+
+				if (pixel + count > pixelCount)
+					return false;
+			}
+
+			for (int i = 0; i < count; ++i, ++pixel)
+			{
+				StoreColour(target + (pixel / width) * stride + (pixel % width) * 4, last);
+			}
+		}
+
+		return true;
+	}
+
+	bool DecodePalette(const uint8_t* data, const size_t& size, size_t& position, uint8_t* target, const size_t& stride, const int& width, const int& height, const int& colours)
+	{
+		const int bits = PaletteBits(colours);
+		const size_t indexBytes = ((size_t)width * height * bits + 7) / 8;
+
+		if (position + (size_t)colours * 3 + indexBytes > size)
+			return false;
+
+		uint32_t palette[MaxPaletteColours]{};
+
+		for (int i = 0; i < colours; ++i)
+		{
+			palette[i] = GetColour(data + position);
+			position += 3;
+		}
+
+		const uint8_t* indices = data + position;
+		const int mask = (1 << bits) - 1;
+
+		size_t bit = 0;
+
+		for (int y = 0; y < height; ++y)
+		{
+			uint8_t* row = target + y * stride;
+
+			for (int x = 0; x < width; ++x, bit += bits)
+			{
+				const int index = (indices[bit >> 3] >> (8 - bits - (bit & 7))) & mask;
+
+				if (index >= colours)
+					return false;
+
+				StoreColour(row + x * 4, palette[index]);
+			}
+		}
+
+		position += indexBytes;
+
+		return true;
+	}
+
+	inline void PutU16(std::vector<uint8_t>& out, const size_t& value)
+	{
+		out.insert(out.end(), { (uint8_t)value, (uint8_t)(value >> 8) });
+	}
+
+	inline void PutU32(std::vector<uint8_t>& out, const size_t& value)
+	{
+		out.insert(out.end(), { (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24) });
+	}
+
+	inline size_t GetU16(const uint8_t* data)
+	{
+		return (size_t)data[0] | ((size_t)data[1] << 8);
+	}
+
+	inline size_t GetU32(const uint8_t* data)
+	{
+		return (size_t)data[0] | ((size_t)data[1] << 8) | ((size_t)data[2] << 16) | ((size_t)data[3] << 24);
+	}
+
+	// a flags byte and the band count, then the tile rows and byte size of every band
+	const size_t FrameHeaderSize = 3;
+	const size_t BandHeaderSize = 6;
+
+	const uint8_t KeyFrameFlag = 1;
+}
+
+ScreenCodec::ScreenCodec(const int& width, const int& height, const int& threads) :
+	m_Width(width), m_Height(height)
+{
+	m_TileColumns = (std::max(0, m_Width) + TileSize - 1) / TileSize;
+	m_TileRows = (std::max(0, m_Height) + TileSize - 1) / TileSize;
+
+	m_Reference.resize((size_t)std::max(0, m_Width) * std::max(0, m_Height) * 4);
+
+	SetThreads(threads);
+}
+
+void ScreenCodec::SetThreads(const int& threads)
+{
+	const int threadCount = std::max(1, threads);
+
+	m_Pool = threadCount > 1 ? std::make_unique<WorkerPool>(threadCount) : nullptr;
+
+	// a couple of bands per thread, since a band of unchanged tiles finishes far sooner than one full of text
+	m_BandCount = threadCount > 1 ? std::min(std::max(1, m_TileRows), threadCount * 2) : 1;
+	m_BandRows = (std::max(1, m_TileRows) + m_BandCount - 1) / m_BandCount;
+	m_BandCount = (std::max(1, m_TileRows) + m_BandRows - 1) / m_BandRows;
+
+	m_Bands.resize(m_BandCount);
+	m_BandTileCounts.resize(m_BandCount);
+}
+
+void ScreenCodec::Reset()
+{
+	m_HasReference = false;
+}
+
+bool ScreenCodec::Encode(const void* bgra, const bool& keyFrame, std::vector<uint8_t>& out)
+{
+	if (bgra == nullptr || m_Width <= 0 || m_Height <= 0)
+		return false;
+
+	const uint8_t* pixels = (const uint8_t*)bgra;
+	const bool key = keyFrame || !m_HasReference;
+
+	auto encodeBand = [this, pixels, key](const int& band)
+	{
+		const int firstRow = band * m_BandRows;
+
+		EncodeBand(pixels, key, firstRow, std::min(m_BandRows, m_TileRows - firstRow), m_Bands[band], m_BandTileCounts[band]);
+	};
+
+	if (m_Pool != nullptr)
+	{
+		m_Pool->Run(m_BandCount, encodeBand);
+	}
+	else
+	{
+		for (int band = 0; band < m_BandCount; ++band)
+		{
+			encodeBand(band);
+		}
+	}
+
+	m_HasReference = true;
+
+	size_t size = FrameHeaderSize + BandHeaderSize * m_BandCount;
+
+	for (int mode = 0; mode < (int)TileMode::Count; ++mode)
+	{
+		m_TileCounts[mode] = 0;
+	}
+
+	for (int band = 0; band < m_BandCount; ++band)
+	{
+		size += m_Bands[band].size();
+
+		for (int mode = 0; mode < (int)TileMode::Count; ++mode)
+		{
+			m_TileCounts[mode] += m_BandTileCounts[band][mode];
+		}
+	}
+
+	out.clear();
+	out.reserve(size);
+
+	out.push_back(key ? KeyFrameFlag : 0);
+	PutU16(out, (size_t)m_BandCount);
+
+	for (int band = 0; band < m_BandCount; ++band)
+	{
+		PutU16(out, (size_t)std::min(m_BandRows, m_TileRows - band * m_BandRows));
+		PutU32(out, m_Bands[band].size());
+	}
+
+	for (const std::vector<uint8_t>& band : m_Bands)
+	{
+		out.insert(out.end(), band.begin(), band.end());
+	}
+
+	return true;
+}
+
+void ScreenCodec::EncodeBand(const uint8_t* bgra, const bool& keyFrame, const int& firstRow, const int& rowCount, std::vector<uint8_t>& out, std::vector<int>& tileCounts)
+{
+	out.clear();
+	tileCounts.assign((int)TileMode::Count, 0);
+
+	const size_t stride = (size_t)m_Width * 4;
+
+	// skipped tiles are written as runs, flushed once something else comes along
+	int skipped = 0;
+
+	for (int tileRow = firstRow; tileRow < firstRow + rowCount; ++tileRow)
+	{
+		const int tileY = tileRow * TileSize;
+		const int tileHeight = std::min(TileSize, m_Height - tileY);
+
+		for (int tileColumn = 0; tileColumn < m_TileColumns; ++tileColumn)
+		{
+			const int tileX = tileColumn * TileSize;
+			const int tileWidth = std::min(TileSize, m_Width - tileX);
+			const size_t rowBytes = (size_t)tileWidth * 4;
+
+			const size_t offset = (size_t)tileY * stride + (size_t)tileX * 4;
+			const uint8_t* source = bgra + offset;
+			uint8_t* reference = m_Reference.data() + offset;
+
+			if (!keyFrame)
+			{
+				bool same = true;
+
+				for (int y = 0; y < tileHeight && same; ++y)
+				{
+					same = memcmp(source + y * stride, reference + y * stride, rowBytes) == 0;
+				}
+
+				if (same)
+				{
+					tileCounts[(int)TileMode::Skip]++;
+
+					if (++skipped == MaxHeaderCount + 1)
+					{
+						out.push_back(Header(TileMode::Skip, skipped - 1));
+						skipped = 0;
+					}
+
+					continue;
+				}
+			}
+
+			if (skipped > 0)
+			{
+				out.push_back(Header(TileMode::Skip, skipped - 1));
+				skipped = 0;
+			}
+
+			const TileMode mode = EncodeTile(source, keyFrame ? nullptr : reference, stride, tileWidth, tileHeight, out);
+			tileCounts[(int)mode]++;
+
+			for (int y = 0; y < tileHeight; ++y)
+			{
+				memcpy(reference + y * stride, source + y * stride, rowBytes);
+			}
+		}
+	}
+
+	if (skipped > 0)
+		out.push_back(Header(TileMode::Skip, skipped - 1));
+}
+
+bool ScreenCodec::Decode(const uint8_t* data, const size_t& size, void* bgra)
+{
+	if (data == nullptr || bgra == nullptr || m_Width <= 0 || m_Height <= 0 || size < FrameHeaderSize)
+		return false;
+
+	const bool keyFrame = IsKeyFrame(data, size);
+
+	// inter frames only make sense on top of the frame before them
+	if (!keyFrame && !m_HasReference)
+		return false;
+
+	const int bandCount = (int)GetU16(data + 1);
+
+	if (bandCount <= 0 || size < FrameHeaderSize + BandHeaderSize * bandCount)
+		return false;
+
+	// bands are laid out by the encoder, which may have had a different thread count
+	std::vector<int> firstRows(bandCount);
+	std::vector<int> rowCounts(bandCount);
+	std::vector<size_t> offsets(bandCount);
+	std::vector<size_t> sizes(bandCount);
+
+	int row = 0;
+	size_t offset = FrameHeaderSize + BandHeaderSize * bandCount;
+
+	for (int band = 0; band < bandCount; ++band)
+	{
+		const uint8_t* header = data + FrameHeaderSize + BandHeaderSize * band;
+
+		firstRows[band] = row;
+		rowCounts[band] = (int)GetU16(header);
+		offsets[band] = offset;
+		sizes[band] = GetU32(header + 2);
+
+		row += rowCounts[band];
+		offset += sizes[band];
+	}
+
+	if (row != m_TileRows || offset > size)
+		return false;
+
+	std::vector<uint8_t> results(bandCount, 0);
+
+	auto decodeBand = [this, data, keyFrame, &firstRows, &rowCounts, &offsets, &sizes, &results](const int& band)
+	{
+		results[band] = DecodeBand(data + offsets[band], sizes[band], keyFrame, firstRows[band], rowCounts[band]) ? 1 : 0;
+	};
+
+	if (m_Pool != nullptr)
+	{
+		m_Pool->Run(bandCount, decodeBand);
+	}
+	else
+	{
+		for (int band = 0; band < bandCount; ++band)
+		{
+			decodeBand(band);
+		}
+	}
+
+	// a broken frame leaves the reference half written, so nothing after it can be trusted until the next keyframe
+	if (std::find(results.begin(), results.end(), 0) != results.end())
+	{
+		m_HasReference = false;
+
+		return false;
+	}
+
+	m_HasReference = true;
+
+	memcpy(bgra, m_Reference.data(), m_Reference.size());
+
+	return true;
+}
+
+bool ScreenCodec::DecodeBand(const uint8_t* data, const size_t& size, const bool& keyFrame, const int& firstRow, const int& rowCount)
+{
+	const size_t stride = (size_t)m_Width * 4;
+
+	size_t position = 0;
+	int skipped = 0;
+
+	for (int tileRow = firstRow; tileRow < firstRow + rowCount; ++tileRow)
+	{
+		const int tileY = tileRow * TileSize;
+		const int tileHeight = std::min(TileSize, m_Height - tileY);
+
+		for (int tileColumn = 0; tileColumn < m_TileColumns; ++tileColumn)
+		{
+			if (skipped > 0)
+			{
+				skipped--;
+
+				continue;
+			}
+
+			const int tileX = tileColumn * TileSize;
+			const int tileWidth = std::min(TileSize, m_Width - tileX);
+
+			uint8_t* target = m_Reference.data() + (size_t)tileY * stride + (size_t)tileX * 4;
+
+			if (position >= size)
+				return false;
+
+			const uint8_t header = data[position++];
+			const TileMode mode = (TileMode)(header & 3);
+			const int count = header >> 2;
+
+			switch (mode)
+			{
+			case TileMode::Skip:
+				if (keyFrame)
+					return false;
+
+				skipped = count;
+
+				break;
+			case TileMode::Solid:
+			{
+				if (position + 3 > size)
+					return false;
+
+				const uint32_t colour = GetColour(data + position);
+				position += 3;
+
+				for (int y = 0; y < tileHeight; ++y)
+				{
+					for (int x = 0; x < tileWidth; ++x)
+					{
+						StoreColour(target + y * stride + x * 4, colour);
+					}
+				}
+
+				break;
+			}
+			case TileMode::Palette:
+				if (count + 1 < 2 || count + 1 > MaxPaletteColours || !DecodePalette(data, size, position, target, stride, tileWidth, tileHeight, count + 1))
+					return false;
+
+				break;
+			case TileMode::Pixels:
+				if (!DecodePixels(data, size, position, target, stride, tileWidth, tileHeight, keyFrame))
+					return false;
+
+				break;
+			default:
+				return false;
+			}
+		}
+	}
+
+	return skipped == 0 && position == size;
+}
+
+bool ScreenCodec::IsKeyFrame(const uint8_t* data, const size_t& size)
+{
+	return data != nullptr && size >= 1 && (data[0] & KeyFrameFlag) != 0;
+}
+
+const char* ScreenCodec::GetModeName(const TileMode& mode)
+{
+	switch (mode)
+	{
+	case TileMode::Skip:
+		return "Skip";
+	case TileMode::Solid:
+		return "Solid";
+	case TileMode::Palette:
+		return "Palette";
+	case TileMode::Pixels:
+		return "Pixels";
+	default:
+		return "Unknown";
+	}
+}
@@ -0,0 +1,161 @@
+#include <Modules/Graphics/ScreenEncoderBackend.h>
+
+#include <iostream>
+#include <algorithm>
+
+namespace
+{
+	void PutLittleEndian(uint8_t* out, const unsigned long long& value, const int& bytes)
+	{
+		for (int i = 0; i < bytes; ++i)
+		{
+			out[i] = (uint8_t)(value >> (i * 8));
+		}
+	}
+}
+
+ScreenSegmentEncoder::ScreenSegmentEncoder(const EncoderSettings& settings, const int& threads) :
+	m_Codec(settings.m_FrameWidth, settings.m_FrameHeight, threads),
+	m_KeyFrameInterval(std::max(1, settings.m_KeyFrameInterval))
+{
+}
+
+bool ScreenSegmentEncoder::Encode(const void* frameData, EncodedPacket& packet)
+{
+	const bool keyFrame = m_FrameCount++ % m_KeyFrameInterval == 0;
+
+	if (!m_Codec.Encode(frameData, keyFrame, packet.m_Data))
+		return false;
+
+	packet.m_KeyFrame = ScreenCodec::IsKeyFrame(packet.m_Data.data(), packet.m_Data.size());
+
+	return true;
+}
+
+ScreenEncoderBackend::~ScreenEncoderBackend()
+{
+	Close();
+}
+
+int ScreenEncoderBackend::Open(const EncoderSettings& settings)
+{
+	Close();
+
+	m_Settings = settings;
+	m_HasWriteStats = false;
+	m_BytesOutput = 0;
+
+	m_Encoder = std::make_unique<ScreenSegmentEncoder>(m_Settings, m_Settings.m_Threads);
+
+	m_Sink = OutputSink::Create(m_Settings.m_FilePath);
+
+	if (m_Sink->Open(m_Settings.m_FilePath) != 0)
+	{
+		std::cout << "ScreenEncoderBackend - Couldn't open '" << m_Settings.m_FilePath << "' for writing!" << std::endl;
+
+		m_Sink = nullptr;
+
+		return -1;
+	}
+
+	uint8_t header[HeaderSize] = { 'G', 'L', 'S', 'C', StreamVersion, (uint8_t)ScreenCodec::TileSize };
+	PutLittleEndian(header + 6, (unsigned long long)m_Settings.m_FrameWidth, 4);
+	PutLittleEndian(header + 10, (unsigned long long)m_Settings.m_FrameHeight, 4);
+	PutLittleEndian(header + 14, (unsigned long long)m_Settings.m_FrameRate, 4);
+
+	if (!m_Sink->WriteHeader(header, sizeof(header)))
+	{
+		std::cout << "ScreenEncoderBackend - Couldn't write stream header!" << std::endl;
+
+		Close();
+
+		return -2;
+	}
+
+	m_BytesOutput += sizeof(header);
+
+	return 0;
+}
+
+bool ScreenEncoderBackend::WriteFrame(const void* frameData, const long long& timestamp, const long long& duration)
+{
+	if (m_Encoder == nullptr)
+	{
+		std::cout << "ScreenEncoderBackend - Not open!" << std::endl;
+
+		return false;
+	}
+
+	m_Packet.m_Timestamp = timestamp;
+	m_Packet.m_Duration = duration;
+
+	return m_Encoder->Encode(frameData, m_Packet) && WritePacket(m_Packet);
+}
+
+std::unique_ptr<SegmentEncoder> ScreenEncoderBackend::CreateSegmentEncoder() const
+{
+	return std::make_unique<ScreenSegmentEncoder>(m_Settings, 1);
+}
+
+bool ScreenEncoderBackend::WritePacket(const EncodedPacket& packet)
+{
+	if (m_Sink == nullptr)
+	{
+		std::cout << "ScreenEncoderBackend - Not open!" << std::endl;
+
+		return false;
+	}
+
+	// every frame carries its own timestamp and duration, so a frame held on screen is written once however long it lasts
+	uint8_t record[RecordSize]{};
+	PutLittleEndian(record, (unsigned long long)packet.m_Data.size(), 4);
+	PutLittleEndian(record + 4, (unsigned long long)packet.m_Timestamp, 8);
+	PutLittleEndian(record + 12, (unsigned long long)packet.m_Duration, 8);
+
+	m_Sink->BeginPacket(packet.m_KeyFrame);
+
+	if (!m_Sink->Write(record, sizeof(record)) || !m_Sink->Write(packet.m_Data.data(), packet.m_Data.size()))
+	{
+		std::cout << "ScreenEncoderBackend - Couldn't write frame!" << std::endl;
+
+		return false;
+	}
+
+	m_BytesOutput += sizeof(record) + packet.m_Data.size();
+
+	m_Sink->EndPacket();
+
+	return true;
+}
+
+bool ScreenEncoderBackend::Finalize()
+{
+	if (m_Sink == nullptr)
+		return false;
+
+	const bool success = m_Sink->Flush();
+
+	Close();
+
+	return success;
+}
+
+void ScreenEncoderBackend::Close()
+{
+	if (m_Sink != nullptr)
+	{
+		m_Sink->Close();
+		m_HasWriteStats = m_Sink->GetWriteStats(m_WriteStats);
+		m_Sink = nullptr;
+	}
+}
+
+bool ScreenEncoderBackend::GetWriteStats(WriteStats& stats) const
+{
+	if (m_Sink != nullptr)
+		return m_Sink->GetWriteStats(stats);
+
+	stats = m_WriteStats;
+
+	return m_HasWriteStats;
+}
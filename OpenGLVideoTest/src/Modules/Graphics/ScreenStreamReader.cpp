@@ -0,0 +1,248 @@
+#include <Modules/Graphics/ScreenStreamReader.h>
+#include <Modules/Graphics/MFEncoderBackend.h>
+
+#include <iostream>
+#include <thread>
+
+namespace
+{
+	unsigned long long GetLittleEndian(const uint8_t* data, const int& bytes)
+	{
+		unsigned long long value = 0;
+
+		for (int i = 0; i < bytes; ++i)
+		{
+			value |= (unsigned long long)data[i] << (i * 8);
+		}
+
+		return value;
+	}
+}
+
+ScreenStreamReader::~ScreenStreamReader()
+{
+	Close();
+}
+
+int ScreenStreamReader::Open(const std::string& path, const int& threads)
+{
+	Close();
+
+	m_File.open(path, std::ios::in | std::ios::binary);
+
+	if (!m_File.is_open())
+	{
+		std::cout << "ScreenStreamReader - Couldn't open '" << path << "' for reading!" << std::endl;
+
+		return -1;
+	}
+
+	uint8_t header[ScreenEncoderBackend::HeaderSize]{};
+
+	if (!m_File.read((char*)header, sizeof(header)) || header[0] != 'G' || header[1] != 'L' || header[2] != 'S' || header[3] != 'C')
+	{
+		std::cout << "ScreenStreamReader - '" << path << "' isn't a screen codec stream!" << std::endl;
+
+		Close();
+
+		return -2;
+	}
+
+	if (header[4] != ScreenEncoderBackend::StreamVersion || header[5] != ScreenCodec::TileSize)
+	{
+		std::cout << "ScreenStreamReader - '" << path << "' is version " << (int)header[4] << " with " << (int)header[5] << " pixel tiles, only version "
+			<< (int)ScreenEncoderBackend::StreamVersion << " with " << ScreenCodec::TileSize << " pixel tiles can be read!" << std::endl;
+
+		Close();
+
+		return -3;
+	}
+
+	m_Width = (int)GetLittleEndian(header + 6, 4);
+	m_Height = (int)GetLittleEndian(header + 10, 4);
+	m_FrameRate = (int)GetLittleEndian(header + 14, 4);
+
+	if (m_Width <= 0 || m_Height <= 0 || m_Width > 16384 || m_Height > 16384 || m_FrameRate <= 0)
+	{
+		std::cout << "ScreenStreamReader - '" << path << "' has a bad frame size or rate (" << m_Width << "x" << m_Height << " at " << m_FrameRate << ")!" << std::endl;
+
+		Close();
+
+		return -4;
+	}
+
+	m_Codec = ScreenCodec(m_Width, m_Height, threads);
+
+	return 0;
+}
+
+bool ScreenStreamReader::ReadFrame(std::vector<uint8_t>& bgra, long long& timestamp, long long& duration)
+{
+	if (!m_File.is_open() || m_Finished)
+		return false;
+
+	// a tile stored as pixels is never much bigger than the pixels themselves, anything past this is a damaged size
+	const size_t frameSize = (size_t)m_Width * m_Height * 4;
+	const size_t maxPacket = frameSize * 2 + 64 * 1024;
+
+	while (true)
+	{
+		uint8_t record[ScreenEncoderBackend::RecordSize]{};
+
+		m_File.read((char*)record, sizeof(record));
+
+		if (m_File.gcount() == 0 && m_File.eof())
+		{
+			m_Finished = true;
+
+			return false;
+		}
+
+		if ((size_t)m_File.gcount() != sizeof(record))
+		{
+			std::cout << "ScreenStreamReader - Stream ends part way through a frame record after " << m_FramesRead << " frames!" << std::endl;
+
+			return false;
+		}
+
+		const size_t size = (size_t)GetLittleEndian(record, 4);
+		timestamp = (long long)GetLittleEndian(record + 4, 8);
+		duration = (long long)GetLittleEndian(record + 12, 8);
+
+		if (size == 0 || size > maxPacket)
+		{
+			std::cout << "ScreenStreamReader - Frame " << m_FramesRead << " has a bad size of " << size << " bytes!" << std::endl;
+
+			return false;
+		}
+
+		m_Packet.resize(size);
+
+		if (!m_File.read((char*)m_Packet.data(), size))
+		{
+			std::cout << "ScreenStreamReader - Stream ends part way through frame " << m_FramesRead << "!" << std::endl;
+
+			return false;
+		}
+
+		// inter frames need the one before them, which a stream joined part way through never had
+		if (!m_HasKeyFrame && !ScreenCodec::IsKeyFrame(m_Packet.data(), m_Packet.size()))
+		{
+			m_FramesSkipped++;
+
+			continue;
+		}
+
+		m_HasKeyFrame = true;
+
+		bgra.resize(frameSize);
+
+		if (!m_Codec.Decode(m_Packet.data(), m_Packet.size(), bgra.data()))
+		{
+			std::cout << "ScreenStreamReader - Frame " << m_FramesRead << " didn't decode!" << std::endl;
+
+			return false;
+		}
+
+		m_FramesRead++;
+
+		return true;
+	}
+}
+
+void ScreenStreamReader::Close()
+{
+	if (m_File.is_open())
+		m_File.close();
+
+	m_File.clear();
+
+	m_Codec = ScreenCodec();
+	m_Packet.clear();
+
+	m_Width = 0;
+	m_Height = 0;
+	m_FrameRate = 0;
+
+	m_HasKeyFrame = false;
+	m_Finished = false;
+
+	m_FramesRead = 0;
+	m_FramesSkipped = 0;
+}
+
+int ScreenStreamReader::Export(const std::string& input, const std::string& output, const EncoderType& type)
+{
+	const int threads = std::thread::hardware_concurrency() > 0 ? (int)std::thread::hardware_concurrency() : 1;
+
+	ScreenStreamReader reader;
+
+	if (reader.Open(input, threads) != 0)
+		return -1;
+
+	// the media foundation backend is the only one with a runtime of its own to start
+	const bool mediaFoundation = type == EncoderType::MediaFoundation;
+
+	if (mediaFoundation && !MFEncoderBackend::Startup())
+	{
+		std::cout << "ScreenStreamReader - Couldn't start Media Foundation!" << std::endl;
+
+		return -2;
+	}
+
+	int result = 0;
+
+	{
+		std::unique_ptr<EncoderBackend> backend = EncoderBackend::Create(type);
+
+		EncoderSettings settings{};
+		settings.m_FilePath = output;
+		settings.m_FrameWidth = reader.GetWidth();
+		settings.m_FrameHeight = reader.GetHeight();
+		settings.m_FrameRate = reader.GetFrameRate();
+		settings.m_KeyFrameInterval = reader.GetFrameRate();
+		settings.m_Threads = threads;
+
+		if (backend == nullptr || backend->Open(settings) != 0)
+		{
+			std::cout << "ScreenStreamReader - Couldn't open '" << output << "' with the " << EncoderBackend::GetName(type) << " encoder!" << std::endl;
+
+			result = -3;
+		}
+		else
+		{
+			std::vector<uint8_t> frame{};
+			long long timestamp = 0;
+			long long duration = 0;
+
+			while (reader.ReadFrame(frame, timestamp, duration))
+			{
+				if (!backend->WriteFrame(frame.data(), timestamp, duration))
+				{
+					result = -4;
+
+					break;
+				}
+			}
+
+			if (result == 0 && !reader.IsFinished())
+				result = -5;
+
+			// whatever decoded is still worth keeping when the stream was cut short
+			if (!backend->Finalize() && result == 0)
+				result = -6;
+		}
+	}
+
+	if (mediaFoundation)
+		MFEncoderBackend::Shutdown();
+
+	std::cout << "ScreenStreamReader - " << (result == 0 ? "Exported " : "Export failed after ") << reader.GetFramesRead() << " frames of '" << input << "' to '" << output << "'";
+
+	if (reader.GetFramesSkipped() > 0)
+		std::cout << ", skipped " << reader.GetFramesSkipped() << " frames before the first keyframe";
+
+	std::cout << std::endl;
+
+	return result;
+}
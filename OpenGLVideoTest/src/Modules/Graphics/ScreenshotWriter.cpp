@@ -0,0 +1,147 @@
+#include <Modules/Graphics/ScreenshotWriter.h>
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+
+ScreenshotWriter::ScreenshotWriter(const int& threads) :
+	m_Threads(threads > 0 ? threads : 1)
+{
+	m_Worker = std::thread(&ScreenshotWriter::SaveScreenshots, this);
+}
+
+ScreenshotWriter::~ScreenshotWriter()
+{
+	Finish();
+}
+
+std::vector<uint8_t> ScreenshotWriter::AcquireBuffer(const size_t& size)
+{
+	std::vector<uint8_t> buffer;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (!m_FreeBuffers.empty())
+		{
+			buffer = std::move(m_FreeBuffers.back());
+			m_FreeBuffers.pop_back();
+		}
+	}
+
+	buffer.resize(size);
+
+	return buffer;
+}
+
+bool ScreenshotWriter::Submit(std::vector<uint8_t> pixels, const int& width, const int& height, const ImageFormat& format, const std::string& filePath)
+{
+	if (pixels.size() < (size_t)width * height * 4)
+		return false;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (m_Finishing || m_Jobs.size() >= MaxPending)
+			return false;
+
+		Job job;
+		job.m_Pixels = std::move(pixels);
+		job.m_Width = width;
+		job.m_Height = height;
+		job.m_Format = format;
+		job.m_FilePath = filePath;
+
+		m_Jobs.push_back(std::move(job));
+	}
+
+	m_Condition.notify_one();
+
+	return true;
+}
+
+void ScreenshotWriter::Finish()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Finishing = true;
+	}
+
+	m_Condition.notify_one();
+
+	if (m_Worker.joinable())
+	{
+		m_Worker.join();
+	}
+}
+
+size_t ScreenshotWriter::GetPending() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	return m_Jobs.size();
+}
+
+void ScreenshotWriter::SaveScreenshots()
+{
+	std::vector<uint8_t> encoded;
+
+	while (true)
+	{
+		Job job;
+
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+
+			m_Condition.wait(lock, [this] { return !m_Jobs.empty() || m_Finishing; });
+
+			if (m_Jobs.empty())
+				break;
+
+			job = std::move(m_Jobs.front());
+			m_Jobs.pop_front();
+		}
+
+		const std::chrono::steady_clock::time_point encodeStart = std::chrono::steady_clock::now();
+
+		bool saved = ImageEncoder::Encode(job.m_Format, job.m_Pixels.data(), job.m_Width, job.m_Height, m_Threads, encoded);
+
+		const std::chrono::steady_clock::time_point writeStart = std::chrono::steady_clock::now();
+
+		if (saved)
+		{
+			std::FILE* file = std::fopen(job.m_FilePath.c_str(), "wb");
+
+			saved = file != nullptr && std::fwrite(encoded.data(), 1, encoded.size(), file) == encoded.size();
+
+			if (file != nullptr && std::fclose(file) != 0)
+				saved = false;
+		}
+
+		const std::chrono::steady_clock::time_point writeEnd = std::chrono::steady_clock::now();
+
+		if (saved)
+		{
+			m_Saved++;
+			m_LastBytes = encoded.size();
+			m_LastEncodeUs = std::chrono::duration_cast<std::chrono::microseconds>(writeStart - encodeStart).count();
+			m_LastWriteUs = std::chrono::duration_cast<std::chrono::microseconds>(writeEnd - writeStart).count();
+
+			std::cout << "ScreenshotWriter - Saved '" << job.m_FilePath << "' (" << encoded.size() / 1024 << " KB, " << GetLastEncodeMs() << "ms to compress)" << std::endl;
+		}
+		else
+		{
+			m_Failed++;
+
+			std::cout << "ScreenshotWriter - Failed to save '" << job.m_FilePath << "'!" << std::endl;
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		// a couple of spare buffers covers a burst of screenshots without hoarding memory
+		if (m_FreeBuffers.size() < 2)
+		{
+			m_FreeBuffers.push_back(std::move(job.m_Pixels));
+		}
+	}
+}
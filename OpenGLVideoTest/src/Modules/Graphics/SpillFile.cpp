@@ -0,0 +1,217 @@
+#include <Modules/Graphics/SpillFile.h>
+
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+SpillFile::~SpillFile()
+{
+	Close();
+}
+
+int SpillFile::Open(const char* filePath, const size_t& frameSize, const size_t& slotCount)
+{
+	Close();
+
+	if (frameSize == 0 || slotCount == 0)
+	{
+		std::cout << "SpillFile - Nothing to allocate!" << std::endl;
+
+		return -1;
+	}
+
+	m_FrameSize = frameSize;
+	m_SlotSize = (frameSize + SlotAlignment - 1) / SlotAlignment * SlotAlignment;
+	m_SlotCount = slotCount;
+
+	unsigned long long fileSize = GetFileSize();
+
+#ifdef _WIN32
+	// temporary keeps it in the cache where it can, delete on close cleans up after a crash too
+	HANDLE file = CreateFileA(filePath, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		std::cout << "SpillFile - Failed to create " << filePath << "!" << std::endl;
+
+		return -2;
+	}
+
+	m_File = file;
+
+	// sizing the mapping extends the file, so the space is claimed up front
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)(fileSize >> 32), (DWORD)(fileSize & 0xFFFFFFFF), NULL);
+
+	if (mapping == NULL)
+	{
+		std::cout << "SpillFile - Failed to map " << fileSize / (1024 * 1024) << " MB!" << std::endl;
+
+		Close();
+
+		return -3;
+	}
+
+	m_Mapping = mapping;
+	m_View = (uint8_t*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+#else
+	m_File = open(filePath, O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+	if (m_File < 0)
+	{
+		std::cout << "SpillFile - Failed to create " << filePath << "!" << std::endl;
+
+		return -2;
+	}
+
+	// the mapping keeps the file alive, unlinking now means nothing is left behind
+	unlink(filePath);
+
+	if (posix_fallocate(m_File, 0, (off_t)fileSize) != 0 && ftruncate(m_File, (off_t)fileSize) != 0)
+	{
+		std::cout << "SpillFile - Failed to allocate " << fileSize / (1024 * 1024) << " MB!" << std::endl;
+
+		Close();
+
+		return -3;
+	}
+
+	void* view = mmap(nullptr, (size_t)fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_File, 0);
+	m_View = view != MAP_FAILED ? (uint8_t*)view : nullptr;
+
+	if (m_View != nullptr)
+	{
+		madvise(m_View, (size_t)fileSize, MADV_SEQUENTIAL);
+	}
+#endif
+
+	if (m_View == nullptr)
+	{
+		std::cout << "SpillFile - Failed to map view!" << std::endl;
+
+		Close();
+
+		return -4;
+	}
+
+	m_Head = 0;
+	m_Tail = 0;
+	m_Released.assign(slotCount, 0);
+	m_HighWater = 0;
+	m_TotalSpilled = 0;
+
+	return 0;
+}
+
+void SpillFile::Close()
+{
+#ifdef _WIN32
+	if (m_View != nullptr)
+	{
+		UnmapViewOfFile(m_View);
+	}
+
+	if (m_Mapping != nullptr)
+	{
+		CloseHandle((HANDLE)m_Mapping);
+	}
+
+	if (m_File != nullptr)
+	{
+		CloseHandle((HANDLE)m_File);
+	}
+
+	m_Mapping = nullptr;
+	m_File = nullptr;
+#else
+	if (m_View != nullptr)
+	{
+		munmap(m_View, (size_t)GetFileSize());
+	}
+
+	if (m_File >= 0)
+	{
+		close(m_File);
+	}
+
+	m_File = -1;
+#endif
+
+	m_View = nullptr;
+	m_Head = 0;
+	m_Tail = 0;
+}
+
+bool SpillFile::Push(size_t& slot)
+{
+	if (!IsOpen() || IsFull())
+		return false;
+
+	const size_t tail = m_Tail;
+
+	slot = tail % m_SlotCount;
+	m_Tail = tail + 1;
+
+	m_TotalSpilled++;
+
+	if (GetCount() > m_HighWater)
+		m_HighWater = GetCount();
+
+	return true;
+}
+
+void SpillFile::Written(const size_t& slot)
+{
+	// start writing the slot out now so its pages are clean and cheap to drop when memory gets tight
+#ifdef _WIN32
+	FlushViewOfFile(GetSlot(slot), m_FrameSize);
+#else
+	msync(GetSlot(slot), m_SlotSize, MS_ASYNC);
+#endif
+}
+
+void SpillFile::Unpush()
+{
+	const size_t tail = m_Tail;
+
+	if (tail == m_Head)
+		return;
+
+	m_Tail = tail - 1;
+	m_TotalSpilled--;
+}
+
+void SpillFile::Release(const size_t& slot)
+{
+	if (slot >= m_Released.size())
+		return;
+
+	// the frame has been consumed, its pages don't need to stay resident
+#ifdef _WIN32
+	VirtualUnlock(GetSlot(slot), m_SlotSize);
+#else
+	madvise(GetSlot(slot), m_SlotSize, MADV_DONTNEED);
+#endif
+
+	m_Released[slot] = 1;
+
+	size_t head = m_Head;
+
+	while (head != m_Tail && m_Released[head % m_SlotCount])
+	{
+		m_Released[head % m_SlotCount] = 0;
+		head++;
+	}
+
+	m_Head = head;
+}
+
+uint8_t* SpillFile::GetSlot(const size_t& slot) const
+{
+	return m_View + slot * m_SlotSize;
+}
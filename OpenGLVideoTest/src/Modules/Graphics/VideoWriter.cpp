@@ -1,56 +1,16 @@
-#include "Modules\Graphics\VideoWriter.h"
+#include "Modules/Graphics/VideoWriter.h"
+
+#include "Modules/Graphics/MFEncoderBackend.h"
 
 #include <functional>
+#include <algorithm>
+#include <cstring>
+#include <chrono>
 #include <iostream>
 
-#include <mfapi.h>
-#include <mfidl.h>
-#include <mfreadwrite.h>
-#include <mferror.h>
-
-template <class T> void SafeRelease(T** ppT)
-{
-	if (*ppT)
-	{
-		(*ppT)->Release();
-		*ppT = NULL;
-	}
-}
-
-int FailInitSafely(const char* message, const HRESULT& code, IMFSinkWriter* sinkWriter, IMFMediaType* mediaTypeOut, IMFMediaType* mediaTypeIn)
-{
-	std::cout << "VideoWriter Init Failed - " << message << "(Error code: " << code << ")" << std::endl;
-
-	SafeRelease(&sinkWriter);
-	SafeRelease(&mediaTypeOut);
-	SafeRelease(&mediaTypeIn);
-
-	return -1;
-}
-
-int FailWriteFrameSafely(const char* message, const HRESULT& code, IMFSinkWriter* sinkWriter, IMFMediaType* mediaTypeOut, IMFMediaType* mediaTypeIn)
-{
-	std::cout << "VideoWriter Init Failed - " << message << "(Error code: " << code << ")" << std::endl;
-
-	SafeRelease(&sinkWriter);
-	SafeRelease(&mediaTypeOut);
-	SafeRelease(&mediaTypeIn);
-
-	return -1;
-}
-
 int VideoWriter::Start()
 {
-	HRESULT hr = CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
-
-	if (SUCCEEDED(hr))
-	{
-		hr = MFStartup(MF_VERSION);
-		if (SUCCEEDED(hr))
-		{
-			m_Started = true;
-		}
-	}
+	m_Started = MFEncoderBackend::Startup();
 
 	return 0;
 }
@@ -62,12 +22,16 @@ int VideoWriter::Tick()
 
 int VideoWriter::End()
 {
-	if (m_Started)
+	if (IsStreaming())
 	{
-		SafeRelease(&m_SinkWriter);
-		MFShutdown();
+		EndStreaming();
+	}
 
-		CoUninitialize();
+	m_Backend = nullptr;
+
+	if (m_Started)
+	{
+		MFEncoderBackend::Shutdown();
 
 		m_Started = false;
 	}
@@ -77,355 +41,157 @@ int VideoWriter::End()
 
 int VideoWriter::Init(const char* filePath, const int& frameWidth, const int& frameHeight, const int& frameRate, const int& dur, const int& bitRate)
 {
-	SafeRelease(&m_SinkWriter);
-
-	bool success = true;
+	m_Backend = nullptr;
+	m_Initialised = false;
 
-	SetFilePath(filePath);
+	{
+		std::lock_guard<std::mutex> lock(m_WriteStatsMutex);
+		m_HasWriteStats = false;
+	}
 
+	m_FilePath = filePath;
 	m_FrameRate = frameRate;
 	m_FrameWidth = frameWidth;
 	m_FrameHeight = frameHeight;
 	m_FrameDur = 10 * 1000 * 1000 / m_FrameRate;
 	m_BitRate = bitRate;
-	m_VideoEncFormat = MFVideoFormat_WMV3;
-	m_VideoInFormat = MFVideoFormat_RGB32;
-	m_VideoArea = m_FrameWidth * m_FrameHeight;
-
-	IMFSinkWriter* sinkWriter = NULL;
-	IMFMediaType* mediaTypeOut = NULL;
-	IMFMediaType* mediaTypeIn = NULL;
-	DWORD streamIndex;
+	m_KeyFrameInterval = m_FrameRate;
 
-	HRESULT res = MFCreateSinkWriterFromURL(m_FilePath.c_str(), NULL, NULL, &sinkWriter);
+	m_Backend = EncoderBackend::Create(m_EncoderType);
 
-	if (SUCCEEDED(res))
-	{
-		res = MFCreateMediaType(&mediaTypeOut);
-	}
-	else
-	{
-		return FailInitSafely("Couldn't create Sink Writer!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
-	}
-
-	if (SUCCEEDED(res))
-	{
-		res = mediaTypeOut->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video);
-	}
-	else
-	{
-		return FailInitSafely("Couldn't create out media type!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
-	}
-
-	// SET VIDEO ENCODING FORMAT 
-	if (SUCCEEDED(res))
-	{
-		res = mediaTypeOut->SetGUID(MF_MT_SUBTYPE, m_VideoEncFormat);
-	}
-	else
-	{
-		return FailInitSafely("Couldn't set out media major type!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
-	}
-
-	// SET BITRATE
-	if (SUCCEEDED(res))
-	{
-		res = mediaTypeOut->SetUINT32(MF_MT_AVG_BITRATE, m_BitRate);
-	}
-	else
-	{
-		return FailInitSafely("Couldn't set out media video encoding format!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
-	}
-
-	if (SUCCEEDED(res))
-	{
-		res = mediaTypeOut->SetUINT32(MF_MT_INTERLACE_MODE, MFVideoInterlace_Progressive);
-	}
-	else
-	{
-		return FailInitSafely("Couldn't set bitrate!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
-	}
-
-	if (SUCCEEDED(res))
-	{
-		res = MFSetAttributeSize(mediaTypeOut, MF_MT_FRAME_SIZE, m_FrameWidth, m_FrameHeight);
-	}
-	else
+	if (m_Backend == nullptr)
 	{
-		return FailInitSafely("Couldn't set interlace mode!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
-	}
+		std::cout << "VideoWriter Init Failed - " << EncoderBackend::GetName(m_EncoderType) << " is not available on this platform!" << std::endl;
 
-	if (SUCCEEDED(res))
-	{
-		res = MFSetAttributeRatio(mediaTypeOut, MF_MT_FRAME_RATE, m_FrameRate, 1);
-	}
-	else
-	{
-		return FailInitSafely("Couldn't set frame size!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+		return -1;
 	}
 
-	if (SUCCEEDED(res))
-	{
-		res = MFSetAttributeRatio(mediaTypeOut, MF_MT_PIXEL_ASPECT_RATIO, 1, 1);
-	}
-	else
+	EncoderSettings settings;
+	settings.m_FilePath = m_FilePath;
+	settings.m_FrameWidth = m_FrameWidth;
+	settings.m_FrameHeight = m_FrameHeight;
+	settings.m_FrameRate = m_FrameRate;
+	settings.m_BitRate = m_BitRate;
+	settings.m_KeyFrameInterval = m_KeyFrameInterval;
+	settings.m_ColourMatrix = m_ColourMatrix;
+	settings.m_Quality = m_Quality;
+	settings.m_Threads = m_EncodeThreads;
+
+	if (m_Backend->Open(settings) != 0)
 	{
-		return FailInitSafely("Couldn't set frame rate!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
-	}
+		std::cout << "VideoWriter Init Failed - Couldn't open " << m_Backend->GetName() << " backend!" << std::endl;
 
-	if (SUCCEEDED(res))
-	{
-		res = sinkWriter->AddStream(mediaTypeOut, &streamIndex);
-	}
-	else
-	{
-		return FailInitSafely("Couldn't set aspect ratio!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
-	}
+		m_Backend = nullptr;
 
-	// Set the input media type.
-	if (SUCCEEDED(res))
-	{
-		res = MFCreateMediaType(&mediaTypeIn);
-	}
-	else
-	{
-		return FailInitSafely("Couldn't add stream to sink writer!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+		return -1;
 	}
 
-	if (SUCCEEDED(res))
-	{
-		res = mediaTypeIn->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video);
-	}
-	else
-	{
-		return FailInitSafely("Couldn't create in media type!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
-	}
+	m_Initialised = true;
 
-	if (SUCCEEDED(res))
-	{
-		res = mediaTypeIn->SetGUID(MF_MT_SUBTYPE, m_VideoInFormat);
-	}
-	else
-	{
-		return FailInitSafely("Couldn't set in media major type!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
-	}
+	return 0;
+}
 
-	if (SUCCEEDED(res))
-	{
-		res = mediaTypeIn->SetUINT32(MF_MT_INTERLACE_MODE, MFVideoInterlace_Progressive);
-	}
-	else
+bool VideoWriter::WriteFrame(const void* frameData, const long long& timestamp, const long long& duration)
+{
+	if (!m_Initialised || m_Backend == nullptr)
 	{
-		return FailInitSafely("Couldn't set in media format", res, sinkWriter, mediaTypeOut, mediaTypeIn);
-	}
+		std::cout << "VideoWriter - Not initialised!" << std::endl;
 
-	if (SUCCEEDED(res))
-	{
-		res = MFSetAttributeSize(mediaTypeIn, MF_MT_FRAME_SIZE, m_FrameWidth, m_FrameHeight);
-	}
-	else
-	{
-		return FailInitSafely("Couldn't set in media interlace mode!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
+		return false;
 	}
 
-	if (SUCCEEDED(res))
-	{
-		res = MFSetAttributeRatio(mediaTypeIn, MF_MT_FRAME_RATE, m_FrameRate, 1);
-	}
-	else
-	{
-		return FailInitSafely("Couldn't set in media frame size!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
-	}
+	const bool success = m_Backend->WriteFrame(frameData, timestamp, duration);
 
-	if (SUCCEEDED(res))
-	{
-		res = MFSetAttributeRatio(mediaTypeIn, MF_MT_PIXEL_ASPECT_RATIO, 1, 1);
-	}
-	else
-	{
-		return FailInitSafely("Couldn't set in media frame rate!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
-	}
+	UpdateOutputStats();
 
-	if (SUCCEEDED(res))
-	{
-		res = sinkWriter->SetInputMediaType(streamIndex, mediaTypeIn, NULL);
-	}
-	else
-	{
-		return FailInitSafely("Couldn't set in media aspect ratio!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
-	}
+	return success;
+}
 
-	// Tell the sink writer to start accepting data.
-	if (SUCCEEDED(res))
-	{
-		res = sinkWriter->BeginWriting();
-	}
-	else
-	{
-		return FailInitSafely("Couldn't set sink writer input media type!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
-	}
+bool VideoWriter::Finalize()
+{
+	if (m_Backend == nullptr)
+		return false;
 
-	// Return the pointer to the caller.
-	if (SUCCEEDED(res))
-	{
-		m_SinkWriter = sinkWriter;
-		m_SinkWriter->AddRef();
-		m_StreamIndex = std::make_shared<DWORD>(streamIndex);
+	bool success = m_Backend->Finalize();
 
-		m_Initialised = true;
-	}
-	else
-	{
-		return FailInitSafely("Couldn't begin writing!", res, sinkWriter, mediaTypeOut, mediaTypeIn);
-	}
+	// after the last flush, and before the backend goes
+	UpdateOutputStats();
 
-	SafeRelease(&sinkWriter);
-	SafeRelease(&mediaTypeOut);
-	SafeRelease(&mediaTypeIn);
+	m_Backend = nullptr;
 
-	return 0;
+	return success;
 }
 
-bool VideoWriter::WriteFrame(void* frameData, const long long& timestamp)
+namespace
 {
-	bool success = true;
-
-	if (m_Initialised)
+	class HandleFrameSource : public VideoWriter::FrameSource
 	{
-		IMFSample* pSample = NULL;
-		IMFMediaBuffer* frameBuffer = NULL;
-
-		const LONG stride = 4 * m_FrameWidth;
-		const DWORD bufferLength = stride * m_FrameHeight;
+		std::vector<FrameHandle>& m_Frames;
 
-		BYTE* destBuffer = NULL;
+	public:
+		HandleFrameSource(std::vector<FrameHandle>& frames) : m_Frames(frames) {}
 
-		// Create a new memory buffer.
-		HRESULT hr = MFCreateMemoryBuffer(bufferLength, &frameBuffer);
-
-		// Lock the buffer and copy the video frame to the buffer.
-		if (SUCCEEDED(hr) && success)
-		{
-			hr = frameBuffer->Lock(&destBuffer, NULL, NULL);
-		}
-		else
+		bool Get(const size_t& index, const void*& frameData) override
 		{
-			std::cout << "Video Writer - WriteFrame failed! Error creating frame buffer (err code: " << std::to_string(hr) << ")" << std::endl;
-			success = false;
-		}
+			frameData = m_Frames[index].GetData();
 
-		if (SUCCEEDED(hr) && success)
-		{
-			hr = MFCopyImage(
-				destBuffer,
-				stride,
-				(BYTE*)frameData + (m_FrameHeight - 1) * stride,    // First row in source image.
-				stride * -1,                    // Source stride.
-				stride,                    // Image width in bytes.
-				m_FrameHeight                // Image height in pixels.
-			);
-		}
-		else
-		{
-			std::cout << "Video Writer - WriteFrame failed! Error locking frame buffer (err code: " << std::to_string(hr) << ")" << std::endl;
-			success = false;
+			return frameData != nullptr;
 		}
 
-		if (frameBuffer)
-		{
-			frameBuffer->Unlock();
-		}
+		// frame can go back to the capture side as soon as it is encoded
+		void Done(const size_t& index) override { m_Frames[index].Reset(); }
 
-		// Set the data length of the buffer.
-		if (SUCCEEDED(hr) && success)
-		{
-			hr = frameBuffer->SetCurrentLength(bufferLength);
-		}
-		else
-		{
-			std::cout << "Video Writer - WriteFrame failed! Error copying frame (err code: " << std::to_string(hr) << ")" << std::endl;
-			success = false;
-		}
+		bool IsRepeat(const size_t& index) const override { return !m_Frames[index]; }
+	};
 
-		// Create a media sample and add the buffer to the sample.
-		if (SUCCEEDED(hr) && success)
-		{
-			hr = MFCreateSample(&pSample);
-		}
-		else
-		{
-			std::cout << "Video Writer - WriteFrame failed! Error setting frame buffer length (err code: " << std::to_string(hr) << ")" << std::endl;
-			success = false;
-		}
+	class StoreFrameSource : public VideoWriter::FrameSource
+	{
+		FrameStore::Reader m_Reader;
 
-		if (SUCCEEDED(hr) && success)
-		{
-			hr = pSample->AddBuffer(frameBuffer);
-		}
-		else
-		{
-			std::cout << "Video Writer - WriteFrame failed! Error creating sample (err code: " << std::to_string(hr) << ")" << std::endl;
-			success = false;
-		}
+	public:
+		StoreFrameSource(const FrameStore& store) : m_Reader(store) {}
 
-		// Set the time stamp and the duration.
-		if (SUCCEEDED(hr) && success)
-		{
-			hr = pSample->SetSampleTime(timestamp);
-		}
-		else
+		bool Get(const size_t& index, const void*& frameData) override
 		{
-			std::cout << "Video Writer - WriteFrame failed! Error adding frame buffer to sample (err code: " << std::to_string(hr) << ")" << std::endl;
-			success = false;
-		}
+			frameData = m_Reader.Read(index);
 
-		if (SUCCEEDED(hr) && success)
-		{
-			hr = pSample->SetSampleDuration(m_FrameDur);
-		}
-		else
-		{
-			std::cout << "Video Writer - WriteFrame failed! Error setting sample timestamp (err code: " << std::to_string(hr) << ")" << std::endl;
-			success = false;
+			return frameData != nullptr;
 		}
 
-		// Send the sample to the Sink Writer.
-		if (SUCCEEDED(hr) && success)
-		{
-			hr = m_SinkWriter->WriteSample(*m_StreamIndex, pSample);
-		}
-		else
-		{
-			std::cout << "Video Writer - WriteFrame failed! Error setting sample duration (err code: " << std::to_string(hr) << ")" << std::endl;
-			success = false;
-		}
+		bool IsRepeat(const size_t& index) const override { return m_Reader.IsRepeat(index); }
+	};
+}
 
-		if (!SUCCEEDED(hr) && success)
-		{
-			std::cout << "Video Writer - WriteFrame failed! Error writing sample (err code: " << std::to_string(hr) << ")" << std::endl;
-			success = false;
-		}
+bool VideoWriter::WriteAllFrames(std::vector<FrameHandle> frames)
+{
+	return WriteFrames(frames.size(), [&frames]() { return std::make_unique<HandleFrameSource>(frames); });
+}
 
-		SafeRelease(&pSample);
-		SafeRelease(&frameBuffer);
-	}
-	else
+bool VideoWriter::WriteStoredFrames(std::shared_ptr<FrameStore> store)
+{
+	if (store == nullptr)
+		return false;
+
+	store->Finish();
+
+	const int encodeThreads = m_EncodeThreads;
+
+	// segments must start on a store keyframe or every worker would decode from the one before
+	if (m_EncodeThreads > 1 && m_KeyFrameInterval % store->GetKeyFrameInterval() != 0)
 	{
-		std::cout << "VideoWriter - Not initialised!" << std::endl;
-		success = false;
+		std::cout << "VideoWriter - Frame store keyframes don't line up with the encoder, writing serially." << std::endl;
+
+		m_EncodeThreads = 1;
 	}
 
-	return success;
-}
+	const bool success = WriteFrames(store->GetFrameCount(), [&store]() { return std::make_unique<StoreFrameSource>(*store); });
 
-void VideoWriter::SetFilePath(const char* filePath)
-{
-	std::string stemp = filePath;
+	m_EncodeThreads = encodeThreads;
 
-	m_FilePath = std::wstring(stemp.begin(), stemp.end());
+	return success;
 }
 
-void VideoWriter::WriteAllFrames(std::vector<void*> frames)
+bool VideoWriter::WriteFrames(const size_t& frameCount, const FrameSourceFactory& createSource)
 {
 	if (!m_Writing)
 	{
@@ -434,19 +200,52 @@ void VideoWriter::WriteAllFrames(std::vector<void*> frames)
 		bool success = true;
 		long long timestamp = 0;
 
-		m_FrameCount = frames.size();
+		m_FrameCount = (unsigned int)frameCount;
+
+		ResetProgress(m_FrameCount);
 
 		if (m_FrameCount == 0)
 		{
 			std::cout << "Input frame container is empty!" << std::endl;
 		}
 
-		// foreach frame, write
-		for (size_t i = 0; i < m_FrameCount; ++i)
+		if (m_EncodeThreads > 1 && m_Backend != nullptr && m_Backend->SupportsSegments() && m_FrameCount > (unsigned int)m_KeyFrameInterval)
+		{
+			success = WriteSegments(frameCount, createSource);
+		}
+		else
 		{
-			if (frames[i] != nullptr)
+			std::unique_ptr<FrameSource> source = createSource();
+
+			// foreach frame, write
+			for (size_t i = 0; i < m_FrameCount; ++i)
 			{
-				if (!WriteFrame(frames[i], timestamp))
+				// a leading repeat has nothing to repeat
+				if (source->IsRepeat(i))
+					continue;
+
+				// duplicates that follow are folded into this frame's duration rather than encoded again
+				size_t repeats = 0;
+
+				while (i + repeats + 1 < m_FrameCount && source->IsRepeat(i + repeats + 1))
+					++repeats;
+
+				const void* frameData = nullptr;
+
+				if (!source->Get(i, frameData))
+				{
+					std::cout << "Failed to read frame " << i << "!" << std::endl;
+
+					success = false;
+
+					break;
+				}
+
+				timestamp = (long long)i * m_FrameDur;
+
+				const PipelineStage::Clock::time_point encodeStart = PipelineStage::Clock::now();
+
+				if (!WriteFrame(frameData, timestamp, (long long)(repeats + 1) * m_FrameDur))
 				{
 					std::cout << "Failed to write frame " << i << "!" << std::endl;
 
@@ -455,18 +254,872 @@ void VideoWriter::WriteAllFrames(std::vector<void*> frames)
 					break;
 				}
 
-				timestamp += m_FrameDur;
+				AddEncoded((long long)(repeats + 1) * m_FrameDur, encodeStart);
+
+				source->Done(i);
+
+				i += repeats;
 			}
 		}
 
 		if (success)
 		{
-			m_SinkWriter->Finalize();
+			success = Finalize();
+		}
+		else if (m_Backend != nullptr)
+		{
+			m_Backend->Close();
 		}
 
+		m_EncodeEndNs = std::chrono::duration_cast<std::chrono::nanoseconds>(PipelineStage::Clock::now().time_since_epoch()).count();
+
 		// must reinit
 		m_Initialised = false;
 		m_Writing = false;
+
+		return success;
+	}
+
+	return false;
+}
+
+bool VideoWriter::WriteSegments(const size_t& frameCount, const FrameSourceFactory& createSource)
+{
+	struct Segment
+	{
+		size_t m_First = 0;
+		size_t m_End = 0;
+		std::deque<EncodedPacket> m_Packets{};
+		bool m_Done = false;
+		bool m_Failed = false;
+	};
+
+	const size_t keyFrameInterval = m_KeyFrameInterval > 0 ? m_KeyFrameInterval : 1;
+
+	// one segment per thread, rounded up so every segment starts on a keyframe
+	size_t segmentLength = (frameCount + m_EncodeThreads - 1) / m_EncodeThreads;
+	segmentLength = (segmentLength + keyFrameInterval - 1) / keyFrameInterval * keyFrameInterval;
+
+	std::vector<Segment> segments((frameCount + segmentLength - 1) / segmentLength);
+
+	for (size_t i = 0; i < segments.size(); ++i)
+	{
+		segments[i].m_First = i * segmentLength;
+		segments[i].m_End = std::min(frameCount, segments[i].m_First + segmentLength);
+	}
+
+	std::mutex segmentMutex;
+	std::condition_variable segmentCondition;
+	std::atomic<bool> abort = false;
+
+	std::vector<std::thread> workers;
+
+	for (Segment& segment : segments)
+	{
+		workers.emplace_back([this, &createSource, &segment, &segmentMutex, &segmentCondition, &abort]()
+		{
+			std::unique_ptr<SegmentEncoder> encoder = m_Backend->CreateSegmentEncoder();
+			std::unique_ptr<FrameSource> source = createSource();
+
+			bool success = encoder != nullptr;
+
+			size_t i = segment.m_First;
+
+			// repeats at the start of a segment belong to the last frame of the one before, an empty packet carries them over
+			while (i < segment.m_End && source->IsRepeat(i))
+				++i;
+
+			if (i > segment.m_First)
+			{
+				EncodedPacket repeat;
+				repeat.m_Timestamp = (long long)segment.m_First * m_FrameDur;
+				repeat.m_Duration = (long long)(i - segment.m_First) * m_FrameDur;
+
+				m_FramesEncoded += (unsigned int)(i - segment.m_First);
+
+				std::lock_guard<std::mutex> lock(segmentMutex);
+				segment.m_Packets.push_back(std::move(repeat));
+			}
+
+			for (; i < segment.m_End && success && !abort; ++i)
+			{
+				size_t repeats = 0;
+
+				while (i + repeats + 1 < segment.m_End && source->IsRepeat(i + repeats + 1))
+					++repeats;
+
+				{
+					std::unique_lock<std::mutex> lock(segmentMutex);
+
+					segmentCondition.wait(lock, [&segment, &abort] { return segment.m_Packets.size() < SegmentQueueDepth || abort; });
+				}
+
+				if (abort)
+					break;
+
+				const void* frameData = nullptr;
+
+				if (!source->Get(i, frameData))
+				{
+					success = false;
+
+					break;
+				}
+
+				EncodedPacket packet;
+				packet.m_Timestamp = (long long)i * m_FrameDur;
+				packet.m_Duration = (long long)(repeats + 1) * m_FrameDur;
+
+				const PipelineStage::Clock::time_point encodeStart = PipelineStage::Clock::now();
+
+				success = encoder->Encode(frameData, packet);
+
+				source->Done(i);
+
+				if (success)
+				{
+					AddEncoded(packet.m_Duration, encodeStart);
+
+					std::lock_guard<std::mutex> lock(segmentMutex);
+					segment.m_Packets.push_back(std::move(packet));
+				}
+
+				segmentCondition.notify_all();
+
+				i += repeats;
+			}
+
+			std::lock_guard<std::mutex> lock(segmentMutex);
+
+			segment.m_Failed = !success;
+			segment.m_Done = true;
+
+			segmentCondition.notify_all();
+		});
+	}
+
+	bool success = true;
+
+	// each packet is held back until the next real one arrives, in case the next segment starts with repeats of it
+	EncodedPacket heldPacket;
+	bool holding = false;
+
+	// segments are concatenated in order as their packets come in, later segments keep encoding meanwhile
+	for (size_t i = 0; i < segments.size() && success; ++i)
+	{
+		Segment& segment = segments[i];
+
+		while (success)
+		{
+			EncodedPacket packet;
+
+			{
+				std::unique_lock<std::mutex> lock(segmentMutex);
+
+				segmentCondition.wait(lock, [&segment] { return !segment.m_Packets.empty() || segment.m_Done; });
+
+				if (segment.m_Packets.empty())
+				{
+					if (segment.m_Failed)
+					{
+						std::cout << "Failed to encode segment " << i << "!" << std::endl;
+
+						success = false;
+					}
+
+					break;
+				}
+
+				packet = std::move(segment.m_Packets.front());
+				segment.m_Packets.pop_front();
+			}
+
+			// room for the worker again if it was waiting on a full queue
+			segmentCondition.notify_all();
+
+			if (packet.m_Data.empty())
+			{
+				if (holding)
+				{
+					heldPacket.m_Duration += packet.m_Duration;
+				}
+
+				continue;
+			}
+
+			if (holding && !m_Backend->WritePacket(heldPacket))
+			{
+				std::cout << "Failed to write segment " << i << "!" << std::endl;
+
+				success = false;
+			}
+
+			heldPacket = std::move(packet);
+			holding = true;
+
+			UpdateOutputStats();
+		}
+	}
+
+	if (success && holding && !m_Backend->WritePacket(heldPacket))
+	{
+		std::cout << "Failed to write the last segment!" << std::endl;
+
+		success = false;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(segmentMutex);
+
+		abort = !success;
+	}
+
+	segmentCondition.notify_all();
+
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	return success;
+}
+
+int VideoWriter::BeginStreaming(const size_t& maxQueuedFrames)
+{
+	if (!m_Initialised)
+	{
+		std::cout << "VideoWriter - Not initialised!" << std::endl;
+
+		return -1;
+	}
+
+	if (m_Writing || IsStreaming())
+	{
+		std::cout << "VideoWriter - Already writing!" << std::endl;
+
+		return -2;
+	}
+
+	m_MaxQueuedFrames = maxQueuedFrames > 0 ? maxQueuedFrames : 1;
+	m_QueuedInMemory = 0;
+	m_DropRequests = 0;
+	m_StreamEnding = false;
+	m_StreamFailed = false;
+	m_EncodeDone = false;
+	m_FramesStreamed = 0;
+	m_FramesSpilled = 0;
+	m_SpillQueued = 0;
+	m_SpillHighWater = 0;
+	m_Spill = nullptr;
+
+	if (!m_SpillFilePath.empty() && m_MaxSpilledFrames > 0)
+	{
+		m_Spill = std::make_unique<SpillFile>();
+
+		if (m_Spill->Open(m_SpillFilePath.c_str(), GetFrameSize(), m_MaxSpilledFrames) != 0)
+		{
+			// not fatal, capture just waits on the encoder like it would without one
+			std::cout << "VideoWriter - Could not create spill file, queue is limited to memory!" << std::endl;
+
+			m_Spill = nullptr;
+		}
+	}
+
+	const size_t maxFrames = m_MaxQueuedFrames + (m_Spill != nullptr ? m_Spill->GetSlotCount() : 0);
+
+	// repeats take an entry but no memory, so leave plenty of room for them next to the real frames
+	m_EncodeQueue = std::make_unique<SPSCRing<QueuedFrame>>(maxFrames * 2 + 64);
+
+	m_StreamEncoder = m_Backend->SupportsSegments() ? m_Backend->CreateSegmentEncoder() : nullptr;
+
+	// only one frame is encoded at a time while streaming, so the encode threads go to splitting it up
+	if (m_StreamEncoder != nullptr)
+	{
+		m_StreamEncoder->SetThreads(m_EncodeThreads);
+	}
+	m_WriteQueue = nullptr;
+	m_FreePackets = nullptr;
+
+	// every packet waiting on the writer is latency a live viewer sees
+	const size_t writeDepth = m_Backend->IsLive() ? 2 : WriteQueueDepth;
+
+	if (m_StreamEncoder != nullptr)
+	{
+		m_WriteQueue = std::make_unique<SPSCRing<QueuedPacket>>(writeDepth);
+		m_FreePackets = std::make_unique<SPSCRing<QueuedPacket>>(writeDepth);
+
+		for (size_t i = 0; i < writeDepth; ++i)
+		{
+			QueuedPacket packet;
+			m_FreePackets->TryPush(packet);
+		}
+	}
+
+	m_Stages[(int)StreamStage::Capture].Reset(0);
+	m_Stages[(int)StreamStage::Encode].Reset(maxFrames);
+	m_Stages[(int)StreamStage::Write].Reset(m_WriteQueue != nullptr ? writeDepth : 0);
+
+	m_LatencyTotalNs = 0;
+	m_LatencyMaxNs = 0;
+	m_LatencyCount = 0;
+
+	ResetProgress(0);
+
+	m_Writing = true;
+
+	if (m_StreamEncoder != nullptr)
+	{
+		m_WriteThread = std::thread(&VideoWriter::WritePackets, this);
+	}
+
+	m_StreamThread = std::thread(&VideoWriter::StreamFrames, this);
+
+	return 0;
+}
+
+namespace
+{
+	// the rings have nothing to sleep on, so a waiting side yields for a while then drops to short sleeps
+	void Backoff(int& spins)
+	{
+		if (++spins < 64)
+		{
+			std::this_thread::yield();
+		}
+		else
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+	}
+}
+
+size_t VideoWriter::GetQueuedFrames() const
+{
+	return m_QueuedInMemory + (m_Spill != nullptr ? m_Spill->GetCount() : 0);
+}
+
+bool VideoWriter::QueueFrame(FrameHandle frame, const PipelineStage::Clock::time_point& capturedAt)
+{
+	if (m_StreamFailed || m_StreamEnding || !IsStreaming())
+	{
+		// frame goes back to its pool when the handle leaves scope
+		return false;
+	}
+
+	PipelineStage& stage = m_Stages[(int)StreamStage::Capture];
+	PipelineStage::Clock::time_point busyStart = PipelineStage::Clock::now();
+
+	QueuedFrame queued;
+	queued.m_CapturedAt = capturedAt;
+
+	// repeats carry no data, only real frames count against memory or the spill file
+	auto hasMemory = [this] { return m_QueuedInMemory < m_MaxQueuedFrames; };
+	auto hasSpill = [this] { return m_Spill != nullptr && !m_Spill->IsFull(); };
+
+	if (frame && !hasMemory() && !hasSpill())
+	{
+		if (m_QueuePolicy == QueuePolicy::DropNewest)
+		{
+			// the frame before simply stays on screen a frame longer
+			frame.Reset();
+			stage.AddDropped();
+		}
+		else
+		{
+			if (m_QueuePolicy == QueuePolicy::DropOldest)
+			{
+				// the encoder skips the oldest frame it has queued, so this wait lasts at most until it finishes the current one
+				m_DropRequests++;
+			}
+
+			stage.AddBusy(busyStart);
+
+			PipelineStage::Clock::time_point stallStart = PipelineStage::Clock::now();
+			int spins = 0;
+
+			while (!hasMemory() && !hasSpill())
+			{
+				if (m_StreamFailed)
+					return false;
+
+				Backoff(spins);
+			}
+
+			stage.AddStall(stallStart);
+
+			busyStart = PipelineStage::Clock::now();
+		}
+	}
+
+	if (!frame || hasMemory())
+	{
+		if (frame)
+			m_QueuedInMemory++;
+
+		queued.m_Frame = std::move(frame);
+	}
+	else
+	{
+		// the encoder only reads the slot once the entry is on the ring, so the copy can happen first
+		m_Spill->Push(queued.m_SpillSlot);
+		queued.m_Spilled = true;
+
+		memcpy(m_Spill->GetSlot(queued.m_SpillSlot), frame.GetData(), m_Spill->GetFrameSize());
+		m_Spill->Written(queued.m_SpillSlot);
+
+		// the memory frame is free as soon as it is on disk
+		frame.Reset();
+
+		m_FramesSpilled++;
+		m_SpillQueued = (unsigned int)m_Spill->GetCount();
+		m_SpillHighWater = (unsigned int)m_Spill->GetHighWater();
+	}
+
+	stage.AddBusy(busyStart);
+
+	if (!m_EncodeQueue->TryPush(queued))
+	{
+		// only a long run of repeats can fill the ring itself
+		PipelineStage::Clock::time_point stallStart = PipelineStage::Clock::now();
+		int spins = 0;
+
+		while (!m_EncodeQueue->TryPush(queued))
+		{
+			if (m_StreamFailed)
+			{
+				// the encoder never saw the slot, so it goes back off the tail rather than the head the encoder owns
+				if (queued.m_Spilled)
+					m_Spill->Unpush();
+
+				return false;
+			}
+
+			Backoff(spins);
+		}
+
+		stage.AddStall(stallStart);
+	}
+
+	stage.AddItems(1);
+	m_Stages[(int)StreamStage::Encode].SetDepth(GetQueuedFrames());
+
+	m_FramesToEncode++;
+
+	return true;
+}
+
+bool VideoWriter::EndStreaming()
+{
+	if (!IsStreaming())
+		return false;
+
+	m_StreamEnding = true;
+
+	m_StreamThread.join();
+
+	return !m_StreamFailed;
+}
+
+void VideoWriter::StreamFrames()
+{
+	PipelineStage& stage = m_Stages[(int)StreamStage::Encode];
+
+	long long timestamp = 0;
+
+	// the last real frame waits here until the next one shows how many repeats it picked up
+	QueuedFrame heldFrame;
+	bool holding = false;
+	long long heldDuration = 0;
+
+	auto releaseFrame = [this](QueuedFrame& frame)
+	{
+		if (frame.m_Spilled)
+		{
+			// a dropped frame can be released while the held frame before it still needs its slot
+			m_Spill->Release(frame.m_SpillSlot);
+			m_SpillQueued = (unsigned int)m_Spill->GetCount();
+
+			frame.m_Spilled = false;
+		}
+
+		// hand the buffer back to the capture side
+		frame.m_Frame.Reset();
+	};
+
+	// live output sends every frame as soon as it arrives, the held frame is only kept so repeats can send it again
+	const bool live = m_Backend->IsLive();
+
+	auto encodeHeld = [this, &stage, &heldFrame, &heldDuration, &timestamp](const PipelineStage::Clock::time_point& capturedAt)
+	{
+		PipelineStage::Clock::time_point busyStart = PipelineStage::Clock::now();
+
+		const void* frameData = heldFrame.m_Spilled ? m_Spill->GetSlot(heldFrame.m_SpillSlot) : heldFrame.m_Frame.GetData();
+		bool success = true;
+
+		PipelineStage::Clock::time_point encodeStart = busyStart;
+
+		if (m_StreamEncoder != nullptr)
+		{
+			QueuedPacket packet;
+
+			if (!m_FreePackets->TryPop(packet))
+			{
+				// every packet is waiting on the writer
+				stage.AddBusy(busyStart);
+
+				PipelineStage::Clock::time_point stallStart = PipelineStage::Clock::now();
+				int spins = 0;
+
+				while (!m_FreePackets->TryPop(packet) && !m_StreamFailed)
+				{
+					Backoff(spins);
+				}
+
+				stage.AddStall(stallStart);
+
+				busyStart = PipelineStage::Clock::now();
+				encodeStart = busyStart;
+			}
+
+			packet.m_Packet.m_Timestamp = timestamp;
+			packet.m_Packet.m_Duration = heldDuration;
+			packet.m_CapturedAt = capturedAt;
+
+			// there are only as many packets as the ring holds, so it always has room
+			success = !m_StreamFailed && m_StreamEncoder->Encode(frameData, packet.m_Packet) && m_WriteQueue->TryPush(packet);
+
+			m_Stages[(int)StreamStage::Write].SetDepth(m_WriteQueue->GetSize());
+		}
+		else
+		{
+			// the backend converts, encodes and writes in one go
+			success = WriteFrame(frameData, timestamp, heldDuration);
+
+			if (success)
+				AddLatency(capturedAt);
+		}
+
+		if (success)
+		{
+			m_FramesStreamed += (unsigned int)(heldDuration / m_FrameDur);
+			timestamp += heldDuration;
+
+			AddEncoded(heldDuration, encodeStart);
+		}
+		else if (!m_StreamFailed)
+		{
+			std::cout << "Failed to write frame " << m_FramesStreamed << "!" << std::endl;
+
+			m_StreamFailed = true;
+		}
+
+		heldDuration = 0;
+
+		stage.AddBusy(busyStart);
+	};
+
+	while (true)
+	{
+		QueuedFrame frame;
+
+		if (!m_EncodeQueue->TryPop(frame))
+		{
+			PipelineStage::Clock::time_point idleStart = PipelineStage::Clock::now();
+			bool drained = false;
+			int spins = 0;
+
+			while (!m_EncodeQueue->TryPop(frame))
+			{
+				// capture has stopped pushing once ending is set, so one more empty pop means it is fully drained
+				if (m_StreamEnding)
+				{
+					drained = !m_EncodeQueue->TryPop(frame);
+
+					break;
+				}
+
+				Backoff(spins);
+			}
+
+			stage.AddIdle(idleStart);
+
+			if (drained)
+				break;
+		}
+
+		if (frame.m_Frame)
+			m_QueuedInMemory--;
+
+		stage.AddItems(1);
+		stage.SetDepth(GetQueuedFrames());
+
+		bool isRepeat = !frame.m_Frame && !frame.m_Spilled;
+
+		if (m_StreamFailed)
+		{
+			releaseFrame(frame);
+
+			continue;
+		}
+
+		if (!isRepeat && holding && m_DropRequests > 0)
+		{
+			// capture ran out of room and asked for the oldest frame to go, it becomes a repeat of the one before
+			m_DropRequests--;
+			releaseFrame(frame);
+
+			m_Stages[(int)StreamStage::Capture].AddDropped();
+
+			isRepeat = true;
+		}
+
+		if (!isRepeat)
+		{
+			if (holding && heldDuration > 0)
+			{
+				encodeHeld(heldFrame.m_CapturedAt);
+			}
+
+			releaseFrame(heldFrame);
+
+			heldFrame = std::move(frame);
+			heldDuration = m_FrameDur;
+			holding = true;
+
+			if (live)
+			{
+				encodeHeld(heldFrame.m_CapturedAt);
+			}
+		}
+		else if (holding)
+		{
+			// duplicate of the held frame, it just lasts a frame longer
+			heldDuration += m_FrameDur;
+
+			if (live)
+			{
+				encodeHeld(frame.m_CapturedAt);
+			}
+		}
+	}
+
+	if (!m_StreamFailed && holding && heldDuration > 0)
+	{
+		encodeHeld(heldFrame.m_CapturedAt);
+	}
+
+	releaseFrame(heldFrame);
+
+	// the writer drains what is left on its ring then stops
+	m_EncodeDone = true;
+
+	if (m_WriteThread.joinable())
+	{
+		m_WriteThread.join();
+	}
+
+	if (!m_StreamFailed && m_FramesStreamed > 0)
+	{
+		m_StreamFailed = !Finalize();
+	}
+	else
+	{
+		// an empty stream never made it into a file either
+		m_StreamFailed = true;
+
+		if (m_Backend != nullptr)
+		{
+			m_Backend->Close();
+		}
+	}
+
+	// nothing is left in it, the file goes with it
+	m_Spill = nullptr;
+	m_StreamEncoder = nullptr;
+
+	m_EncodeEndNs = std::chrono::duration_cast<std::chrono::nanoseconds>(PipelineStage::Clock::now().time_since_epoch()).count();
+
+	// must reinit
+	m_Initialised = false;
+	m_Writing = false;
+}
+
+void VideoWriter::WritePackets()
+{
+	PipelineStage& stage = m_Stages[(int)StreamStage::Write];
+
+	while (true)
+	{
+		QueuedPacket packet;
+
+		if (!m_WriteQueue->TryPop(packet))
+		{
+			PipelineStage::Clock::time_point idleStart = PipelineStage::Clock::now();
+			bool drained = false;
+			int spins = 0;
+
+			while (!m_WriteQueue->TryPop(packet))
+			{
+				if (m_EncodeDone)
+				{
+					drained = !m_WriteQueue->TryPop(packet);
+
+					break;
+				}
+
+				Backoff(spins);
+			}
+
+			stage.AddIdle(idleStart);
+
+			if (drained)
+				break;
+		}
+
+		stage.SetDepth(m_WriteQueue->GetSize());
+
+		PipelineStage::Clock::time_point busyStart = PipelineStage::Clock::now();
+
+		if (!m_StreamFailed)
+		{
+			if (m_Backend->WritePacket(packet.m_Packet))
+			{
+				stage.AddItems(packet.m_Packet.m_Duration / m_FrameDur);
+
+				AddLatency(packet.m_CapturedAt);
+				UpdateOutputStats();
+			}
+			else
+			{
+				std::cout << "Failed to write packet at " << packet.m_Packet.m_Timestamp << "!" << std::endl;
+
+				m_StreamFailed = true;
+			}
+		}
+
+		stage.AddBusy(busyStart);
+
+		// back to the encoder with its buffer still allocated
+		m_FreePackets->TryPush(packet);
+	}
+}
+
+void VideoWriter::AddLatency(const PipelineStage::Clock::time_point& capturedAt)
+{
+	const long long latencyNs = std::chrono::duration_cast<std::chrono::nanoseconds>(PipelineStage::Clock::now() - capturedAt).count();
+
+	m_LatencyTotalNs += latencyNs;
+	m_LatencyCount++;
+
+	long long maxNs = m_LatencyMaxNs;
+
+	while (latencyNs > maxNs && !m_LatencyMaxNs.compare_exchange_weak(maxNs, latencyNs));
+}
+
+void VideoWriter::ResetProgress(const unsigned int& framesToEncode)
+{
+	m_FramesEncoded = 0;
+	m_FramesToEncode = framesToEncode;
+	m_BytesOutput = 0;
+	m_EncodeTotalNs = 0;
+	m_EncodeCount = 0;
+	m_EncodeStartNs = std::chrono::duration_cast<std::chrono::nanoseconds>(PipelineStage::Clock::now().time_since_epoch()).count();
+	m_EncodeEndNs = 0;
+}
+
+void VideoWriter::AddEncoded(const long long& duration, const PipelineStage::Clock::time_point& encodeStart)
+{
+	const PipelineStage::Clock::time_point now = PipelineStage::Clock::now();
+
+	m_EncodeTotalNs += std::chrono::duration_cast<std::chrono::nanoseconds>(now - encodeStart).count();
+	m_EncodeCount++;
+
+	// a frame held on screen is encoded once but is still that many frames of video
+	m_FramesEncoded += (unsigned int)(duration / m_FrameDur);
+}
+
+void VideoWriter::UpdateOutputStats()
+{
+	if (m_Backend == nullptr)
+		return;
+
+	m_BytesOutput = m_Backend->GetBytesOutput();
+
+	WriteStats stats;
+
+	if (!m_Backend->GetWriteStats(stats))
+		return;
+
+	std::lock_guard<std::mutex> lock(m_WriteStatsMutex);
+
+	m_WriteStats = stats;
+	m_HasWriteStats = true;
+}
+
+bool VideoWriter::GetWriteStats(WriteStats& stats) const
+{
+	std::lock_guard<std::mutex> lock(m_WriteStatsMutex);
+
+	stats = m_WriteStats;
+
+	return m_HasWriteStats;
+}
+
+unsigned int VideoWriter::GetFramesRemaining() const
+{
+	const unsigned int encoded = m_FramesEncoded;
+	const unsigned int toEncode = m_FramesToEncode;
+
+	return toEncode > encoded ? toEncode - encoded : 0;
+}
+
+double VideoWriter::GetAverageEncodeMs() const
+{
+	const unsigned long long count = m_EncodeCount;
+
+	return count > 0 ? m_EncodeTotalNs / 1000000.0 / count : 0.0;
+}
+
+double VideoWriter::GetEncodeFps() const
+{
+	const long long startNs = m_EncodeStartNs;
+
+	if (startNs == 0)
+		return 0.0;
+
+	// stops counting once the file is finished, so the last save's rate stays put
+	const long long endNs = m_EncodeEndNs;
+	const long long nowNs = endNs != 0 ? endNs : std::chrono::duration_cast<std::chrono::nanoseconds>(PipelineStage::Clock::now().time_since_epoch()).count();
+
+	return nowNs > startNs ? m_FramesEncoded * 1000000000.0 / (nowNs - startNs) : 0.0;
+}
+
+double VideoWriter::GetSecondsRemaining() const
+{
+	const double fps = GetEncodeFps();
+
+	return fps > 0.0 ? GetFramesRemaining() / fps : -1.0;
+}
+
+double VideoWriter::GetAverageLatencyMs() const
+{
+	const unsigned long long count = m_LatencyCount;
+
+	return count > 0 ? m_LatencyTotalNs / 1000000.0 / count : 0.0;
+}
+
+const char* VideoWriter::GetStageName(const StreamStage& stage)
+{
+	switch (stage)
+	{
+	case StreamStage::Capture:
+		return "Capture";
+	case StreamStage::Encode:
+		return "Encode";
+	case StreamStage::Write:
+		return "Write";
+	default:
+		return "Unknown";
 	}
 }
 
@@ -0,0 +1,95 @@
+#include <Modules/Graphics/WorkerPool.h>
+
+WorkerPool::WorkerPool(const int& threads)
+{
+	for (int i = 1; i < threads; ++i)
+	{
+		m_Threads.emplace_back(&WorkerPool::Work, this);
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+	}
+
+	m_StartCondition.notify_all();
+
+	for (std::thread& thread : m_Threads)
+	{
+		thread.join();
+	}
+}
+
+void WorkerPool::Run(const int& taskCount, const std::function<void(const int&)>& task)
+{
+	// nothing to share, skip the hand off
+	if (m_Threads.empty() || taskCount <= 1)
+	{
+		for (int i = 0; i < taskCount; ++i)
+		{
+			task(i);
+		}
+
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		m_Task = &task;
+		m_TaskCount = taskCount;
+		m_NextTask = 0;
+		m_Working = (int)m_Threads.size();
+		m_Batch++;
+	}
+
+	m_StartCondition.notify_all();
+
+	RunTasks();
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	m_DoneCondition.wait(lock, [this] { return m_Working == 0; });
+
+	m_Task = nullptr;
+}
+
+void WorkerPool::RunTasks()
+{
+	// tasks are taken one at a time, so a thread that finishes early picks up what the slower ones haven't reached
+	for (int i = m_NextTask++; i < m_TaskCount; i = m_NextTask++)
+	{
+		(*m_Task)(i);
+	}
+}
+
+void WorkerPool::Work()
+{
+	unsigned long long batch = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+
+			m_StartCondition.wait(lock, [this, &batch] { return m_Stopping || m_Batch != batch; });
+
+			if (m_Stopping)
+				return;
+
+			batch = m_Batch;
+		}
+
+		RunTasks();
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (--m_Working == 0)
+		{
+			m_DoneCondition.notify_one();
+		}
+	}
+}
@@ -0,0 +1,724 @@
+#include <Modules/Graphics/WriteBehindFile.h>
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <malloc.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+// raw syscalls rather than liburing, the kernel headers are all it needs
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#define WRITE_BEHIND_IO_URING 1
+#endif
+#endif
+#endif
+
+struct WriteBehindFile::IoUring
+{
+#ifdef WRITE_BEHIND_IO_URING
+	int m_Fd = -1;
+
+	void* m_SqRing = nullptr;
+	size_t m_SqRingSize = 0;
+	void* m_CqRing = nullptr;
+	size_t m_CqRingSize = 0;
+	io_uring_sqe* m_Sqes = nullptr;
+	size_t m_SqesSize = 0;
+
+	unsigned* m_SqTail = nullptr;
+	unsigned* m_SqMask = nullptr;
+	unsigned* m_SqArray = nullptr;
+
+	unsigned* m_CqHead = nullptr;
+	unsigned* m_CqTail = nullptr;
+	unsigned* m_CqMask = nullptr;
+	io_uring_cqe* m_Cqes = nullptr;
+#endif
+};
+
+namespace
+{
+	// completions with this tag aren't chunks, they tell the reaping thread to stop
+	const unsigned long long StopTag = ~0ULL;
+}
+
+// out of line, IoUring is only complete in here
+WriteBehindFile::WriteBehindFile()
+{
+}
+
+WriteBehindFile::~WriteBehindFile()
+{
+	Close();
+}
+
+int WriteBehindFile::Open(const std::string& filePath, const size_t& chunkSize, const size_t& chunkCount)
+{
+	Close();
+
+	if (chunkSize == 0)
+	{
+		std::cout << "WriteBehindFile - Chunks can't be empty!" << std::endl;
+
+		return -1;
+	}
+
+	m_ChunkSize = (chunkSize + Alignment - 1) / Alignment * Alignment;
+
+#ifdef _WIN32
+	// the cache manager reads ahead and writes behind more eagerly on files it knows are sequential
+	HANDLE file = CreateFileA(filePath.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		std::cout << "WriteBehindFile - Couldn't open '" << filePath << "' for writing!" << std::endl;
+
+		return -2;
+	}
+
+	m_File = file;
+#else
+	m_File = open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	if (m_File < 0)
+	{
+		std::cout << "WriteBehindFile - Couldn't open '" << filePath << "' for writing!" << std::endl;
+
+		return -2;
+	}
+#endif
+
+	// one being filled and at least one being written
+	const size_t count = chunkCount < 2 ? 2 : chunkCount;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		uint8_t* buffer = AllocateBuffer(m_ChunkSize);
+
+		if (buffer == nullptr)
+		{
+			std::cout << "WriteBehindFile - Failed to allocate " << count << " chunks of " << m_ChunkSize / 1024 << " KB!" << std::endl;
+
+			Close();
+
+			return -3;
+		}
+
+		m_Buffers.push_back(buffer);
+		m_FreeBuffers.push_back(i);
+	}
+
+	m_ChunkCount = count;
+	m_InFlight.assign(count, Chunk());
+
+	m_Current = Chunk();
+	m_Current.m_Index = m_FreeBuffers.back();
+	m_Current.m_Data = m_Buffers[m_Current.m_Index];
+	m_FreeBuffers.pop_back();
+
+	m_Pending = 0;
+	m_Failed = false;
+	m_Stopping = false;
+	m_BytesWritten = 0;
+	m_ChunksWritten = 0;
+	m_LatencyTotalUs = 0;
+	m_LatencyMaxUs = 0;
+	m_Depth = 0;
+	m_MaxDepth = 0;
+	m_Stalls = 0;
+
+	// the thread is only there to collect completions when the kernel does the writing
+	m_FixedBuffers = false;
+	m_Engine = OpenRing() ? Engine::IoUring : Engine::Thread;
+	m_Writer = std::thread(m_Engine == Engine::IoUring ? &WriteBehindFile::ReapChunks : &WriteBehindFile::WriteChunks, this);
+
+	return 0;
+}
+
+bool WriteBehindFile::Write(const void* data, const size_t& size)
+{
+	if (!IsOpen() || m_Failed)
+		return false;
+
+	const uint8_t* bytes = (const uint8_t*)data;
+	size_t remaining = size;
+
+	while (remaining > 0)
+	{
+		const size_t space = m_ChunkSize - m_Current.m_Size;
+		const size_t copy = remaining < space ? remaining : space;
+
+		memcpy(m_Current.m_Data + m_Current.m_Size, bytes, copy);
+
+		m_Current.m_Size += copy;
+		bytes += copy;
+		remaining -= copy;
+
+		if (m_Current.m_Size == m_ChunkSize && !QueueCurrent())
+			return false;
+	}
+
+	return true;
+}
+
+bool WriteBehindFile::WriteAt(const unsigned long long& offset, const void* data, const size_t& size)
+{
+	if (!IsOpen() || m_Failed || offset + size > GetPosition())
+		return false;
+
+	const uint8_t* bytes = (const uint8_t*)data;
+
+	// anything in the chunk still being filled is patched in place and goes out with it
+	if (offset + size > m_Current.m_Offset)
+	{
+		const size_t skip = offset < m_Current.m_Offset ? (size_t)(m_Current.m_Offset - offset) : 0;
+		const size_t start = (size_t)(offset + skip - m_Current.m_Offset);
+
+		memcpy(m_Current.m_Data + start, bytes + skip, size - skip);
+
+		if (skip == 0)
+			return true;
+
+		return Drain() && WriteNative(bytes, skip, offset);
+	}
+
+	// the rest has to be on disk first, or a write still in flight could put the old bytes back over it
+	return Drain() && WriteNative(bytes, size, offset);
+}
+
+bool WriteBehindFile::Flush()
+{
+	if (!IsOpen())
+		return false;
+
+	// the partial chunk is written where it will end up but kept, so later writes carry on filling it and full chunks stay aligned
+	if (!Drain() || (m_Current.m_Size > 0 && !WriteNative(m_Current.m_Data, m_Current.m_Size, m_Current.m_Offset)))
+		return false;
+
+	return !m_Failed;
+}
+
+void WriteBehindFile::Close()
+{
+	if (m_Writer.joinable())
+	{
+		if (!Flush())
+		{
+			std::cout << "WriteBehindFile - Failed to write everything before closing!" << std::endl;
+		}
+
+		bool stopped = true;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stopping = true;
+
+			if (m_Engine == Engine::IoUring)
+			{
+				Chunk stop;
+				stop.m_Index = (size_t)StopTag;
+
+				// without this the reaper would wait on a completion that never comes
+				stopped = SubmitRing(stop);
+			}
+		}
+
+		m_QueuedCondition.notify_all();
+
+		if (stopped)
+		{
+			m_Writer.join();
+		}
+		else
+		{
+			// nothing is in flight, so the reaper only ever wakes if the ring does, which is left mapped for it
+			std::cout << "WriteBehindFile - Couldn't stop io_uring!" << std::endl;
+
+			m_Writer.detach();
+			m_Ring.release();
+		}
+	}
+
+	CloseRing();
+
+#ifdef _WIN32
+	if (m_File != nullptr)
+	{
+		CloseHandle(m_File);
+		m_File = nullptr;
+	}
+#else
+	if (m_File >= 0)
+	{
+		close(m_File);
+		m_File = -1;
+	}
+#endif
+
+	for (uint8_t* buffer : m_Buffers)
+	{
+		FreeBuffer(buffer);
+	}
+
+	m_Buffers.clear();
+	m_FreeBuffers.clear();
+	m_InFlight.clear();
+	m_Queue.clear();
+
+	m_Current = Chunk();
+}
+
+bool WriteBehindFile::QueueCurrent()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	const unsigned long long next = m_Current.m_Offset + m_Current.m_Size;
+
+	// once writing has failed nothing more goes out, and with io_uring nothing would reap it
+	if (m_Failed)
+	{
+		m_Current.m_Size = 0;
+		m_Current.m_Offset = next;
+
+		return false;
+	}
+
+	m_Current.m_QueuedAt = Clock::now();
+
+	m_Pending++;
+	m_Depth = m_Pending;
+
+	if (m_Pending > m_MaxDepth)
+		m_MaxDepth = m_Pending;
+
+	if (m_Engine == Engine::IoUring)
+	{
+		m_InFlight[m_Current.m_Index] = m_Current;
+
+		if (!SubmitRing(m_Current))
+		{
+			std::cout << "WriteBehindFile - Failed to submit " << m_Current.m_Size << " bytes at " << m_Current.m_Offset << "!" << std::endl;
+
+			m_Failed = true;
+
+			m_Pending--;
+			m_Depth = m_Pending;
+			m_InFlight[m_Current.m_Index] = Chunk();
+			m_FreeBuffers.push_back(m_Current.m_Index);
+		}
+	}
+	else
+	{
+		m_Queue.push_back(m_Current);
+		m_QueuedCondition.notify_one();
+	}
+
+	if (m_FreeBuffers.empty())
+	{
+		++m_Stalls;
+
+		m_FreeCondition.wait(lock, [this] { return !m_FreeBuffers.empty() || m_Failed; });
+	}
+
+	// a failure with every chunk still out leaves the current one to be filled again, nothing is written from it now
+	if (m_FreeBuffers.empty())
+	{
+		m_Current.m_Size = 0;
+		m_Current.m_Offset = next;
+
+		return false;
+	}
+
+	m_Current = Chunk();
+	m_Current.m_Index = m_FreeBuffers.back();
+	m_Current.m_Data = m_Buffers[m_Current.m_Index];
+	m_Current.m_Offset = next;
+
+	m_FreeBuffers.pop_back();
+
+	return !m_Failed;
+}
+
+bool WriteBehindFile::Drain()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	m_FreeCondition.wait(lock, [this] { return m_Pending == 0; });
+
+	return !m_Failed;
+}
+
+void WriteBehindFile::WriteChunks()
+{
+	while (true)
+	{
+		Chunk chunk;
+
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+
+			m_QueuedCondition.wait(lock, [this] { return m_Stopping || !m_Queue.empty(); });
+
+			if (m_Queue.empty())
+				return;
+
+			chunk = m_Queue.front();
+			m_Queue.pop_front();
+		}
+
+		ChunkWritten(chunk, !m_Failed && WriteNative(chunk.m_Data, chunk.m_Size, chunk.m_Offset));
+	}
+}
+
+void WriteBehindFile::ReapChunks()
+{
+#ifdef WRITE_BEHIND_IO_URING
+	IoUring& ring = *m_Ring;
+
+	while (true)
+	{
+		unsigned head = *ring.m_CqHead;
+
+		// the kernel moves the tail as writes finish, wait in the kernel rather than spin when there is nothing yet
+		while (head == __atomic_load_n(ring.m_CqTail, __ATOMIC_ACQUIRE))
+		{
+			if (syscall(__NR_io_uring_enter, ring.m_Fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR)
+			{
+				std::cout << "WriteBehindFile - Failed waiting on io_uring!" << std::endl;
+
+				m_Failed = true;
+
+				// nothing more will be reaped, so every chunk in flight goes back and nothing is left to wait for
+				{
+					std::lock_guard<std::mutex> lock(m_Mutex);
+
+					for (size_t i = 0; i < m_InFlight.size(); ++i)
+					{
+						if (m_InFlight[i].m_Data != nullptr)
+						{
+							m_InFlight[i] = Chunk();
+							m_FreeBuffers.push_back(i);
+						}
+					}
+
+					m_Pending = 0;
+					m_Depth = 0;
+				}
+
+				m_FreeCondition.notify_all();
+
+				return;
+			}
+		}
+
+		const io_uring_cqe cqe = ring.m_Cqes[head & *ring.m_CqMask];
+
+		__atomic_store_n(ring.m_CqHead, head + 1, __ATOMIC_RELEASE);
+
+		if (cqe.user_data == StopTag)
+			return;
+
+		Chunk chunk;
+
+		{
+			// the kernel orders this after the submit, but nothing a thread checker can see does
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			chunk = m_InFlight[(size_t)cqe.user_data];
+		}
+
+		bool success = cqe.res >= 0;
+
+		// regular files rarely come up short, whatever is left goes out the slow way rather than another trip round the ring
+		if (success && (size_t)cqe.res < chunk.m_Size)
+		{
+			success = WriteNative(chunk.m_Data + cqe.res, chunk.m_Size - (size_t)cqe.res, chunk.m_Offset + (unsigned long long)cqe.res);
+		}
+
+		ChunkWritten(chunk, success);
+	}
+#endif
+}
+
+void WriteBehindFile::ChunkWritten(const Chunk& chunk, const bool& success)
+{
+	if (success)
+	{
+		const long long latencyUs = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - chunk.m_QueuedAt).count();
+
+		m_BytesWritten += chunk.m_Size;
+		m_ChunksWritten++;
+		m_LatencyTotalUs += latencyUs;
+
+		long long maxUs = m_LatencyMaxUs;
+
+		while (latencyUs > maxUs && !m_LatencyMaxUs.compare_exchange_weak(maxUs, latencyUs));
+	}
+	else if (!m_Failed)
+	{
+		std::cout << "WriteBehindFile - Failed to write " << chunk.m_Size << " bytes at " << chunk.m_Offset << "!" << std::endl;
+
+		m_Failed = true;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		m_Pending--;
+		m_Depth = m_Pending;
+		m_InFlight[chunk.m_Index] = Chunk();
+		m_FreeBuffers.push_back(chunk.m_Index);
+	}
+
+	m_FreeCondition.notify_all();
+}
+
+bool WriteBehindFile::WriteNative(const void* data, const size_t& size, const unsigned long long& offset)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	size_t remaining = size;
+	unsigned long long position = offset;
+
+	while (remaining > 0)
+	{
+#ifdef _WIN32
+		// positioned writes, so the writer thread and patches from the caller never share a file pointer
+		OVERLAPPED overlapped{};
+		overlapped.Offset = (DWORD)(position & 0xFFFFFFFF);
+		overlapped.OffsetHigh = (DWORD)(position >> 32);
+
+		const DWORD request = remaining < 0x40000000 ? (DWORD)remaining : 0x40000000;
+		DWORD written = 0;
+
+		if (!WriteFile(m_File, bytes, request, &written, &overlapped) || written == 0)
+			return false;
+#else
+		const ssize_t written = pwrite(m_File, bytes, remaining, (off_t)position);
+
+		if (written < 0 && errno == EINTR)
+			continue;
+
+		if (written <= 0)
+			return false;
+#endif
+
+		bytes += written;
+		remaining -= (size_t)written;
+		position += (unsigned long long)written;
+	}
+
+	return true;
+}
+
+bool WriteBehindFile::OpenRing()
+{
+#ifdef WRITE_BEHIND_IO_URING
+	m_Ring = std::make_unique<IoUring>();
+	IoUring& ring = *m_Ring;
+
+	// one entry per chunk, so every chunk can be in flight and the submission ring is never full
+	io_uring_params params{};
+	ring.m_Fd = (int)syscall(__NR_io_uring_setup, (unsigned)m_Buffers.size() + 1, &params);
+
+	// older kernels, and sandboxes that block it, leave the thread to do the writing
+	if (ring.m_Fd < 0)
+	{
+		m_Ring = nullptr;
+
+		return false;
+	}
+
+	ring.m_SqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	ring.m_CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+	const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+	if (singleMap)
+	{
+		ring.m_SqRingSize = ring.m_SqRingSize > ring.m_CqRingSize ? ring.m_SqRingSize : ring.m_CqRingSize;
+		ring.m_CqRingSize = ring.m_SqRingSize;
+	}
+
+	ring.m_SqRing = mmap(NULL, ring.m_SqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.m_Fd, IORING_OFF_SQ_RING);
+	ring.m_CqRing = singleMap ? ring.m_SqRing : mmap(NULL, ring.m_CqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.m_Fd, IORING_OFF_CQ_RING);
+
+	ring.m_SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	ring.m_Sqes = (io_uring_sqe*)mmap(NULL, ring.m_SqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.m_Fd, IORING_OFF_SQES);
+
+	if (ring.m_SqRing == MAP_FAILED || ring.m_CqRing == MAP_FAILED || ring.m_Sqes == MAP_FAILED)
+	{
+		std::cout << "WriteBehindFile - Couldn't map the io_uring rings, writing from a thread instead" << std::endl;
+
+		CloseRing();
+
+		return false;
+	}
+
+	uint8_t* sq = (uint8_t*)ring.m_SqRing;
+	uint8_t* cq = (uint8_t*)ring.m_CqRing;
+
+	ring.m_SqTail = (unsigned*)(sq + params.sq_off.tail);
+	ring.m_SqMask = (unsigned*)(sq + params.sq_off.ring_mask);
+	ring.m_SqArray = (unsigned*)(sq + params.sq_off.array);
+
+	ring.m_CqHead = (unsigned*)(cq + params.cq_off.head);
+	ring.m_CqTail = (unsigned*)(cq + params.cq_off.tail);
+	ring.m_CqMask = (unsigned*)(cq + params.cq_off.ring_mask);
+	ring.m_Cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+
+	// registered chunks are pinned once here, rather than the kernel mapping them again on every write
+	std::vector<iovec> iovecs(m_Buffers.size());
+
+	for (size_t i = 0; i < m_Buffers.size(); ++i)
+	{
+		iovecs[i].iov_base = m_Buffers[i];
+		iovecs[i].iov_len = m_ChunkSize;
+	}
+
+	// pinning counts against the locked memory limit, plain writes through the ring still beat a thread when it says no
+	m_FixedBuffers = syscall(__NR_io_uring_register, ring.m_Fd, IORING_REGISTER_BUFFERS, iovecs.data(), (unsigned)iovecs.size()) == 0;
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+void WriteBehindFile::CloseRing()
+{
+#ifdef WRITE_BEHIND_IO_URING
+	if (m_Ring != nullptr)
+	{
+		IoUring& ring = *m_Ring;
+
+		if (ring.m_Sqes != nullptr && ring.m_Sqes != MAP_FAILED)
+			munmap(ring.m_Sqes, ring.m_SqesSize);
+
+		if (ring.m_CqRing != nullptr && ring.m_CqRing != MAP_FAILED && ring.m_CqRing != ring.m_SqRing)
+			munmap(ring.m_CqRing, ring.m_CqRingSize);
+
+		if (ring.m_SqRing != nullptr && ring.m_SqRing != MAP_FAILED)
+			munmap(ring.m_SqRing, ring.m_SqRingSize);
+
+		// closing the ring drops the registered buffers with it
+		if (ring.m_Fd >= 0)
+			close(ring.m_Fd);
+	}
+#endif
+
+	m_Ring = nullptr;
+}
+
+bool WriteBehindFile::SubmitRing(const Chunk& chunk)
+{
+#ifdef WRITE_BEHIND_IO_URING
+	IoUring& ring = *m_Ring;
+
+	// only ever called with m_Mutex held, so there is one submitter and the kernel consumes each entry in io_uring_enter
+	const unsigned tail = *ring.m_SqTail;
+	const unsigned index = tail & *ring.m_SqMask;
+
+	io_uring_sqe& sqe = ring.m_Sqes[index];
+	memset(&sqe, 0, sizeof(sqe));
+
+	if (chunk.m_Index == (size_t)StopTag)
+	{
+		sqe.opcode = IORING_OP_NOP;
+	}
+	else
+	{
+		sqe.opcode = m_FixedBuffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+		sqe.fd = m_File;
+		sqe.addr = (unsigned long long)(uintptr_t)chunk.m_Data;
+		sqe.len = (unsigned)chunk.m_Size;
+		sqe.off = chunk.m_Offset;
+		sqe.buf_index = m_FixedBuffers ? (unsigned short)chunk.m_Index : 0;
+	}
+
+	sqe.user_data = chunk.m_Index == (size_t)StopTag ? StopTag : (unsigned long long)chunk.m_Index;
+
+	ring.m_SqArray[index] = index;
+
+	__atomic_store_n(ring.m_SqTail, tail + 1, __ATOMIC_RELEASE);
+
+	long submitted = 0;
+
+	do
+	{
+		submitted = syscall(__NR_io_uring_enter, ring.m_Fd, 1, 0, 0, NULL, 0);
+	}
+	while (submitted < 0 && errno == EINTR);
+
+	// left published, the entry would go out with the next submit, from a buffer that is being filled again by then
+	if (submitted != 1)
+	{
+		__atomic_store_n(ring.m_SqTail, tail, __ATOMIC_RELEASE);
+
+		return false;
+	}
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+WriteStats WriteBehindFile::GetStats() const
+{
+	WriteStats stats;
+
+	stats.m_Engine = m_Engine == Engine::IoUring && m_FixedBuffers ? "io_uring (fixed buffers)" : GetEngineName(m_Engine);
+	stats.m_Chunks = m_ChunksWritten;
+	stats.m_Bytes = m_BytesWritten;
+	stats.m_AverageLatencyMs = stats.m_Chunks > 0 ? m_LatencyTotalUs / 1000.0 / stats.m_Chunks : 0.0;
+	stats.m_MaxLatencyMs = m_LatencyMaxUs / 1000.0;
+	stats.m_Depth = m_Depth;
+	stats.m_MaxDepth = m_MaxDepth;
+	stats.m_Capacity = m_ChunkCount;
+	stats.m_Stalls = m_Stalls;
+
+	return stats;
+}
+
+const char* WriteBehindFile::GetEngineName(const Engine& engine)
+{
+	switch (engine)
+	{
+	case Engine::Thread:
+		return "Writer thread";
+	case Engine::IoUring:
+		return "io_uring";
+	default:
+		return "Unknown";
+	}
+}
+
+uint8_t* WriteBehindFile::AllocateBuffer(const size_t& size)
+{
+#ifdef _WIN32
+	return (uint8_t*)_aligned_malloc(size, Alignment);
+#else
+	return (uint8_t*)std::aligned_alloc(Alignment, size);
+#endif
+}
+
+void WriteBehindFile::FreeBuffer(uint8_t* buffer)
+{
+#ifdef _WIN32
+	_aligned_free(buffer);
+#else
+	std::free(buffer);
+#endif
+}
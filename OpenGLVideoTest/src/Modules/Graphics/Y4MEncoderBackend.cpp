@@ -0,0 +1,161 @@
+#include <Modules/Graphics/Y4MEncoderBackend.h>
+
+#include <iostream>
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+	// every y4m frame starts with this, the terminator isn't written
+	const char FrameTag[] = "FRAME\n";
+	const size_t FrameTagSize = sizeof(FrameTag) - 1;
+}
+
+Y4MSegmentEncoder::Y4MSegmentEncoder(const EncoderSettings& settings)
+{
+	m_Converter = ColourConverter(settings.m_FrameWidth, settings.m_FrameHeight, ColourConverter::Format::I420, settings.m_ColourMatrix);
+}
+
+bool Y4MSegmentEncoder::Encode(const void* frameData, EncodedPacket& packet)
+{
+	packet.m_Data.resize(m_Converter.GetOutputSize());
+	packet.m_KeyFrame = true;
+
+	m_Converter.Convert(frameData, packet.m_Data.data(), true);
+
+	return true;
+}
+
+Y4MEncoderBackend::~Y4MEncoderBackend()
+{
+	Close();
+}
+
+int Y4MEncoderBackend::Open(const EncoderSettings& settings)
+{
+	Close();
+
+	m_Settings = settings;
+	m_HasWriteStats = false;
+	m_BytesOutput = 0;
+
+	m_Encoder = std::make_unique<Y4MSegmentEncoder>(m_Settings);
+
+	m_Sink = OutputSink::Create(m_Settings.m_FilePath);
+
+	if (m_Sink->Open(m_Settings.m_FilePath) != 0)
+	{
+		std::cout << "Y4MEncoderBackend - Couldn't open '" << m_Settings.m_FilePath << "' for writing!" << std::endl;
+
+		m_Sink = nullptr;
+
+		return -1;
+	}
+
+	if (!m_Raw)
+	{
+		char header[128]{};
+		const int headerSize = std::snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n", m_Settings.m_FrameWidth, m_Settings.m_FrameHeight, m_Settings.m_FrameRate);
+
+		if (headerSize <= 0 || headerSize >= (int)sizeof(header) || !m_Sink->WriteHeader(header, (size_t)headerSize))
+		{
+			std::cout << "Y4MEncoderBackend - Couldn't write stream header!" << std::endl;
+
+			Close();
+
+			return -2;
+		}
+
+		m_BytesOutput += (unsigned long long)headerSize;
+	}
+
+	return 0;
+}
+
+bool Y4MEncoderBackend::WriteFrame(const void* frameData, const long long& timestamp, const long long& duration)
+{
+	if (m_Encoder == nullptr)
+	{
+		std::cout << "Y4MEncoderBackend - Not open!" << std::endl;
+
+		return false;
+	}
+
+	m_Packet.m_Timestamp = timestamp;
+	m_Packet.m_Duration = duration;
+
+	return m_Encoder->Encode(frameData, m_Packet) && WritePacket(m_Packet);
+}
+
+std::unique_ptr<SegmentEncoder> Y4MEncoderBackend::CreateSegmentEncoder() const
+{
+	return std::make_unique<Y4MSegmentEncoder>(m_Settings);
+}
+
+bool Y4MEncoderBackend::WritePacket(const EncodedPacket& packet)
+{
+	if (m_Sink == nullptr)
+	{
+		std::cout << "Y4MEncoderBackend - Not open!" << std::endl;
+
+		return false;
+	}
+
+	// y4m is constant frame rate, so a frame lasting longer than one frame is written again rather than stretched
+	const long long repeats = std::max(1LL, (packet.m_Duration * m_Settings.m_FrameRate + 5000000) / 10000000);
+
+	for (long long i = 0; i < repeats; ++i)
+	{
+		if (!m_Raw && !m_Sink->Write(FrameTag, FrameTagSize))
+		{
+			std::cout << "Y4MEncoderBackend - Couldn't write frame header!" << std::endl;
+
+			return false;
+		}
+
+		if (!m_Sink->Write(packet.m_Data.data(), packet.m_Data.size()))
+		{
+			std::cout << "Y4MEncoderBackend - Couldn't write frame!" << std::endl;
+
+			return false;
+		}
+
+		m_BytesOutput += (m_Raw ? 0 : FrameTagSize) + packet.m_Data.size();
+
+		m_Sink->EndPacket();
+	}
+
+	return true;
+}
+
+bool Y4MEncoderBackend::Finalize()
+{
+	if (m_Sink == nullptr)
+		return false;
+
+	const bool success = m_Sink->Flush();
+
+	Close();
+
+	return success;
+}
+
+void Y4MEncoderBackend::Close()
+{
+	if (m_Sink != nullptr)
+	{
+		m_Sink->Close();
+		m_HasWriteStats = m_Sink->GetWriteStats(m_WriteStats);
+		m_Sink = nullptr;
+	}
+}
+
+bool Y4MEncoderBackend::GetWriteStats(WriteStats& stats) const
+{
+	if (m_Sink != nullptr)
+		return m_Sink->GetWriteStats(stats);
+
+	stats = m_WriteStats;
+
+	return m_HasWriteStats;
+}
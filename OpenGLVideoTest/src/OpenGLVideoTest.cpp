@@ -1,14 +1,27 @@
 #include <iostream>
 #include <memory>
 #include <Engine.h>
+#include <Modules/Graphics/ScreenStreamReader.h>
 
 
 
-int main()
+int main(int argc, char** argv)
 {
 	int engineTickCode = 0;
 
-	std::unique_ptr<Engine> engineInstance = std::make_unique<Engine>(Engine());
+	LaunchOptions options;
+
+	if (!options.Parse(argc, argv))
+	{
+		return 1;
+	}
+
+	if (!options.m_DecodeInput.empty())
+	{
+		return ScreenStreamReader::Export(options.m_DecodeInput, options.m_DecodeOutput, (EncoderType)options.m_Encoder) == 0 ? 0 : 1;
+	}
+
+	std::unique_ptr<Engine> engineInstance = std::make_unique<Engine>(Engine(options));
 
 	if (engineInstance != nullptr)
 	{
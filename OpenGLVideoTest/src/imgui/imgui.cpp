@@ -807,13 +807,13 @@ CODE
 #define _CRT_SECURE_NO_WARNINGS
 #endif
 
-#include "imgui\imgui.h"
+#include "imgui/imgui.h"
 #ifndef IMGUI_DISABLE
 
 #ifndef IMGUI_DEFINE_MATH_OPERATORS
 #define IMGUI_DEFINE_MATH_OPERATORS
 #endif
-#include "imgui\imgui_internal.h"
+#include "imgui/imgui_internal.h"
 
 // System includes
 #include <ctype.h>      // toupper
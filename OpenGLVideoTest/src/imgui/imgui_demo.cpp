@@ -75,7 +75,7 @@ Index of this file:
 #define _CRT_SECURE_NO_WARNINGS
 #endif
 
-#include "imgui\imgui.h"
+#include "imgui/imgui.h"
 #ifndef IMGUI_DISABLE
 
 // System includes